@@ -0,0 +1,83 @@
+/** =========================================================================
+ * @example{lineno} SimulatedScheduler.ino
+ * @author Sara Damiano <sdamiano@stroudcenter.org>
+ * @copyright Stroud Water Research Center
+ * @license This example is published under the BSD-3 license.
+ *
+ * @brief This example runs the adaptive uplink scheduler against a simulated
+ * radio link that fades and recovers, to show how it trades time on air for
+ * delivery.
+ *
+ * No LoRa module is needed; everything is printed to the serial monitor.
+ *
+ * @m_examplenavigation{example_simulated_scheduler,}
+ * ======================================================================= */
+
+// Set serial for debug console (to the Serial Monitor, default speed 115200)
+#define SerialMon Serial
+
+#include <LoRa_AT_Scheduler.h>
+
+// The region to simulate
+#define SIM_REGION LORA_AT_REGION_US915
+
+// The messages sent in each phase of the simulation
+#define SIM_MESSAGES 200
+
+// A phase of the simulation: the SNR at the gateway and how many of the
+// messages are important instead of routine
+struct SimPhase {
+  const char* name;
+  int8_t      snr;
+  uint8_t     importantEvery;
+};
+
+static const SimPhase phases[] = {
+    {"good link", 5, 10},
+    {"fading", -5, 10},
+    {"very weak", -15, 10},
+    {"recovered", 5, 10},
+};
+static const uint8_t numPhases = sizeof(phases) / sizeof(phases[0]);
+
+LoRa_AT_SimulatedModem                    sim(SIM_REGION, phases[0].snr);
+LoRa_AT_Scheduler<LoRa_AT_SimulatedModem> scheduler(sim, SIM_REGION);
+
+uint8_t phase = 0;
+
+void setup() {
+  // Set console baud rate
+  SerialMon.begin(115200);
+  delay(10);
+
+  SerialMon.println(F("Simulating the adaptive uplink scheduler"));
+  SerialMon.println(
+      F("phase         SNR  sent  lost  transmissions  delivered  airtime ms"));
+}
+
+void loop() {
+  if (phase >= numPhases) { return; }
+  const SimPhase& p = phases[phase++];
+
+  sim.setLink(p.snr);
+  sim.resetStats();
+  scheduler.resetStats();
+
+  // an 11 byte reading fits the slowest US915 data rate
+  uint8_t reading[11] = {0};
+  for (uint16_t i = 0; i < SIM_MESSAGES; i++) {
+    reading[0] = static_cast<uint8_t>(i);
+    scheduler.send(reading, sizeof(reading),
+                   i % p.importantEvery == 0 ? LORA_AT_MSG_IMPORTANT
+                                             : LORA_AT_MSG_ROUTINE);
+  }
+
+  char row[96];
+  snprintf(row, sizeof(row), "%-12s %4d  %4lu  %4lu  %13lu  %9lu  %10lu",
+           p.name, p.snr, static_cast<unsigned long>(scheduler.uplinks()),
+           static_cast<unsigned long>(scheduler.lost()),
+           static_cast<unsigned long>(sim.transmissions()),
+           static_cast<unsigned long>(sim.delivered()),
+           static_cast<unsigned long>(sim.airtime()));
+  SerialMon.println(row);
+}
@@ -0,0 +1,100 @@
+/**
+ * @file       AirtimeTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks the time on air against the LoRa modem calculator and checks
+ * that an airtime budget doesn't make every send ask the module for its data
+ * rate.
+ */
+
+#include <LoRa_AT.h>
+
+#include <algorithm>
+
+#include "HostTest.h"
+
+static const char TEST_APP_EUI[] = "8A598335072D2776";
+static const char TEST_APP_KEY[] = "DD8F3881F180151C739534C4EC56216F";
+static const char TEST_DEV_EUI[] = "15C3202192A4504A";
+
+// Frames with coding rate 4/5, an explicit header, a CRC and 8 preamble
+// symbols, as in LoRaWAN uplinks, from the Semtech LoRa modem calculator
+struct FrameCase {
+  uint8_t  sf;
+  uint16_t bw;
+  uint16_t phyLen;
+  uint32_t us;
+};
+static const FrameCase frames[] = {
+    {7, 125, 13, 46336},      {12, 125, 13, 1155072},
+    {7, 125, 23, 61696},      {9, 125, 23, 205824},
+    {12, 125, 23, 1482752},   {7, 250, 23, 30848},
+    {8, 500, 23, 28288},      {7, 125, 64, 118016},
+    {10, 125, 24, 370688},    {12, 125, 64, 2793472},
+    {7, 125, 255, 399616},    {12, 125, 255, 9019392},
+    {12, 125, 256, 9183232},  {7, 125, 268, 420096},
+    {10, 500, 255, 573952},
+};
+
+// Uplinks with no MAC commands, in milliseconds rounded up
+struct UplinkCase {
+  LoRa_AT_Region region;
+  uint8_t        dataRate;
+  uint16_t       len;
+  uint32_t       ms;
+};
+static const UplinkCase uplinks[] = {
+    {LORA_AT_REGION_EU868, 0, 10, 1483},  // SF12
+    {LORA_AT_REGION_EU868, 5, 10, 62},    // SF7
+    {LORA_AT_REGION_EU868, 7, 0, 4},      // FSK, 50 kbps
+    {LORA_AT_REGION_US915, 0, 11, 371},   // SF10
+    {LORA_AT_REGION_US915, 4, 10, 29},    // SF8, 500 kHz
+    {LORA_AT_REGION_EU868, 5, 242, 400},  // the PHY payload is 255 bytes
+    {LORA_AT_REGION_EU868, 5, 255, 421},  // and here 268
+    {LORA_AT_REGION_US915, 5, 10, 0},     // not a US915 data rate
+};
+
+int main() {
+  for (size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+    const FrameCase& f = frames[i];
+    CHECK_EQUAL(f.us, LoRa_AT_TimeOnAir(f.sf, f.bw, f.phyLen));
+  }
+  for (size_t i = 0; i < sizeof(uplinks) / sizeof(uplinks[0]); i++) {
+    const UplinkCase& u = uplinks[i];
+    CHECK_EQUAL(u.ms, LoRa_AT_UplinkAirtime(u.region, u.dataRate, u.len));
+  }
+  // PHY payloads past 255 bytes keep getting longer instead of wrapping
+  for (uint16_t len = 1; len <= 255; len++) {
+    CHECK(LoRa_AT_UplinkAirtime(LORA_AT_REGION_EU868, 0, len) >=
+          LoRa_AT_UplinkAirtime(LORA_AT_REGION_EU868, 0, len - 1));
+  }
+
+  // with a budget attached, sends use the data rate the planner knows
+  FakeModule            fake;
+  LoRa_AT               modem(fake);
+  LoRaStream            loraStream(modem);
+  LoRa_AT_AirtimeBudget budget(LORA_AT_REGION_US915);
+  modem.setAirtimeBudget(&budget);
+  CHECK(modem.joinOTAA(TEST_APP_EUI, TEST_APP_KEY, TEST_DEV_EUI, 3, 1000L));
+  CHECK(modem.setDataRate(2));
+  fake.resetStats();
+  uint8_t data[4] = {1, 2, 3, 4};
+  for (uint8_t i = 0; i < 5; i++) {
+    CHECK(modem.beginSend(data, sizeof(data)));
+    while (modem.poll()) {}
+    CHECK_EQUAL(LORA_AT_SEND_DONE, modem.sendStatus());
+  }
+#if defined(LORA_AT_MDOT)
+  CHECK_EQUAL(0, fake.count("AT+TXDR?"));
+#else
+  CHECK_EQUAL(0, std::count(fake.commands().begin(), fake.commands().end(),
+                            std::string("AT+DR")));
+#endif
+  CHECK_EQUAL(2, budget.getDataRate());
+  CHECK_EQUAL(5 * LoRa_AT_UplinkAirtime(LORA_AT_REGION_US915, 2, 4),
+              budget.used());
+
+  return hostTestResult("AirtimeTest");
+}
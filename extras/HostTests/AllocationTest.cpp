@@ -0,0 +1,219 @@
+/**
+ * @file       AllocationTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks that the getters that write into a caller's buffer never
+ * allocate, by counting every call to operator new and malloc while they run.
+ *
+ * The simulated modules keep their own lists of commands and replies, which
+ * allocate, so here the module is a fixed table of recorded answers instead.
+ */
+
+#include <LoRa_AT.h>
+
+#include <new>
+
+#include "HostTest.h"
+
+// Only counts while a getter is running
+static bool     counting    = false;
+static uint32_t allocations = 0;
+
+static void* counted(void* p) {
+  if (counting) { allocations++; }
+  return p;
+}
+
+void* operator new(size_t n) {
+  void* p = counted(malloc(n ? n : 1));
+  if (!p) { throw std::bad_alloc(); }
+  return p;
+}
+void* operator new[](size_t n) {
+  return operator new(n);
+}
+void operator delete(void* p) noexcept {
+  free(p);
+}
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+// The sanitizers bring their own malloc, so it can only be counted without
+// them; operator new still catches every String and standard container
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define LORA_AT_TEST_SANITIZED
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define LORA_AT_TEST_SANITIZED
+#endif
+#if defined(__GLIBC__) && !defined(LORA_AT_TEST_SANITIZED)
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t n);
+void* malloc(size_t n) {
+  return counted(__libc_malloc(n));
+}
+void* calloc(size_t n, size_t size) {
+  return counted(__libc_calloc(n, size));
+}
+void* realloc(void* p, size_t n) {
+  return counted(__libc_realloc(p, n));
+}
+}
+#endif
+
+/**
+ * @brief A module that answers each command from a fixed table, without
+ * allocating anything.
+ */
+class TableStream : public Stream {
+ public:
+  struct Answer {
+    const char* command;  ///< The command, without the line ending
+    const char* reply;    ///< What the module prints back
+  };
+
+  template <size_t N>
+  explicit TableStream(const Answer (&table)[N])
+      : silent(false), _table(table), _count(N), _reply(""), _len(0) {}
+
+  int available() override {
+    return static_cast<int>(strlen(_reply));
+  }
+  int read() override {
+    return *_reply ? static_cast<uint8_t>(*_reply++) : -1;
+  }
+  int peek() override {
+    return *_reply ? static_cast<uint8_t>(*_reply) : -1;
+  }
+  size_t write(uint8_t c) override {
+    if (c == '\r') { return 1; }
+    if (c != '\n') {
+      if (_len + 1 < sizeof(_line)) { _line[_len++] = static_cast<char>(c); }
+      return 1;
+    }
+    _line[_len] = '\0';
+    _len        = 0;
+    _reply      = "";
+    for (size_t i = 0; i < _count && !silent; i++) {
+      if (strcmp(_line, _table[i].command) == 0) { _reply = _table[i].reply; }
+    }
+    return 1;
+  }
+  using Print::write;
+
+  bool silent;  ///< True to answer nothing
+
+ private:
+  const Answer* _table;
+  size_t        _count;
+  const char*   _reply;
+  char          _line[96];
+  size_t        _len;
+};
+
+#if defined(LORA_AT_MDOT)
+static const TableStream::Answer ANSWERS[] = {
+    {"AT+DI?", "\r\n00-80-00-00-04-00-4a-2b\r\n\r\nOK\r\n"},
+    {"ATI", "\r\nMultiTech mDot\r\nFirmware: 4.1.5\r\n\r\nOK\r\n"},
+    {"AT+FREQ?", "\r\nUS915\r\n\r\nOK\r\n"},
+    {"AT+CHM?", "\r\n00000000FF00\r\n\r\nOK\r\n"},
+    {"AT+NA?", "\r\n26-0b-11-22\r\n\r\nOK\r\n"},
+    {"AT+NSK?", "\r\nd5-2a-1f-3c-8e-5b-77-19-42-a0-6d-c3-09-e1-b4-58\r\n"
+                "\r\nOK\r\n"},
+    {"AT+DSK?", "\r\n3f-91-c4-0d-6a-e2-58-b7-13-8c-f0-25-9e-47-d1-6b\r\n"
+                "\r\nOK\r\n"},
+    {"AT+NI?", "\r\n8a-59-83-35-07-2d-27-76\r\n\r\nOK\r\n"},
+    {"AT+NK?", "\r\ndd-8f-38-81-f1-80-15-1c-73-95-34-c4-ec-56-21-6f\r\n"
+               "\r\nOK\r\n"},
+};
+#else
+static const TableStream::Answer ANSWERS[] = {
+    {"AT+ID=DevEUI", "+ID: DevEui, 2C:F7:F1:20:32:30:A5:D4\r\n"},
+    {"AT+VER", "+VER: 4.0.11\r\n"},
+    {"AT+LW=VER", "+LW: VER, v1.0.2\r\n"},
+    {"AT+DR=SCHEME", "+DR: US915\r\n"},
+    {"AT+CH", "+CH: 2; 8,903900000,DR0,DR3; 9,904100000,DR0,DR3;\r\n"},
+    {"AT+ID=DevAddr", "+ID: DevAddr, 26:0B:11:22\r\n"},
+    {"AT+ID=AppEui", "+ID: AppEui, 8A:59:83:35:07:2D:27:76\r\n"},
+    {"AT+LW=DTR", "+LW: DTR\r\n"},
+    {"AT+RTC=FULL",
+     "+RTC: 2026-10-16 12:34:56 +00:00, 1476275714, 12\r\n"},
+};
+#endif
+
+// Runs a getter, returning how many allocations it made
+template <typename Getter>
+static uint32_t allocationsIn(Getter getter, bool* ok) {
+  allocations = 0;
+  counting    = true;
+  *ok         = getter();
+  counting    = false;
+  return allocations;
+}
+
+#define CHECK_NO_ALLOCATION(expected, call)                                 \
+  do {                                                                      \
+    bool ok_ = false;                                                       \
+    CHECK_EQUAL(0, allocationsIn([&]() { return call; }, &ok_));            \
+    CHECK_EQUAL(expected, ok_);                                             \
+  } while (0)
+
+int main() {
+  TableStream module(ANSWERS);
+  LoRa_AT     modem(module);
+  char        buff[LORA_AT_STRING_BUFFER];
+
+  // the String versions allocate, so the counting works
+  {
+    bool ok = false;
+    CHECK(allocationsIn([&]() { return modem.getDevEUI().length() > 0; },
+                        &ok) > 0);
+    CHECK(ok);
+  }
+
+  CHECK_NO_ALLOCATION(true, modem.getDevEUI(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(true, modem.getModuleInfo(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(true, modem.getBand(buff, sizeof(buff)));
+  CHECK(strcmp(buff, "US915") == 0);
+  CHECK_NO_ALLOCATION(true, modem.getChannelMask(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(true, modem.getDevAddr(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(true, modem.getAppEUI(buff, sizeof(buff)));
+#if defined(LORA_AT_MDOT)
+  CHECK_NO_ALLOCATION(true, modem.getNwkSKey(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(true, modem.getAppSKey(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(true, modem.getAppKey(buff, sizeof(buff)));
+#else
+  // the Wio-E5 never reports its keys
+  CHECK_NO_ALLOCATION(false, modem.getNwkSKey(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(false, modem.getAppSKey(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(false, modem.getAppKey(buff, sizeof(buff)));
+  // the mDOT has no date and time string
+  CHECK_NO_ALLOCATION(true, modem.getDateTimeString(DATE_FULL, buff,
+                                                    sizeof(buff)));
+  CHECK_NO_ALLOCATION(true, modem.getDateTimeString(DATE_TIME, buff,
+                                                    sizeof(buff)));
+  CHECK_NO_ALLOCATION(true, modem.getDateTimeString(DATE_DATE, buff,
+                                                    sizeof(buff)));
+  CHECK(strcmp(buff, "2026-10-16") == 0);
+#endif
+
+  // nor does a getter the module never answers
+  module.silent = true;
+  CHECK_NO_ALLOCATION(false, modem.getDevEUI(buff, sizeof(buff)));
+  CHECK_NO_ALLOCATION(false, modem.getDevAddr(buff, sizeof(buff)));
+
+  return hostTestResult("AllocationTest");
+}
@@ -0,0 +1,63 @@
+/**
+ * @file       AsyncTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks that a send started while a send or join is under way is
+ * refused without sending anything to the module.
+ */
+
+#include <LoRa_AT.h>
+
+#include "HostTest.h"
+
+static const char TEST_APP_EUI[] = "8A598335072D2776";
+static const char TEST_APP_KEY[] = "DD8F3881F180151C739534C4EC56216F";
+static const char TEST_DEV_EUI[] = "15C3202192A4504A";
+
+int main() {
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+  LoRaStream loraStream(modem);
+
+  uint8_t data[5] = {1, 2, 3, 4, 5};
+  // confirmed sends set up the retries on the module before they start, so
+  // make sure the module isn't already known to have them
+  modem.requireConfirmation(true);
+  CHECK(modem.setConfirmationRetries(2));
+  modem.forgetSettings();
+
+  // a send while joining
+  fake.joinFailures = 1;
+  CHECK(modem.beginJoinOTAA(TEST_APP_EUI, TEST_APP_KEY, TEST_DEV_EUI, 3,
+                            1000L));
+  CHECK_EQUAL(LORA_AT_JOIN_BUSY, modem.joinStatus());
+  size_t commands = fake.commands().size();
+  CHECK(!modem.beginSend(data, sizeof(data)));
+  CHECK_EQUAL(0, loraStream.write(data, sizeof(data)));
+  LoRa_AT_SendOptions options;
+  options.confirmed = false;
+  options.retries   = 5;
+  options.port      = 9;
+  CHECK(!modem.beginSend(data, sizeof(data), options));
+  CHECK_EQUAL(commands, fake.commands().size());
+  while (modem.poll()) {}
+  CHECK_EQUAL(LORA_AT_JOIN_JOINED, modem.joinStatus());
+
+  // a send while sending
+  modem.requireConfirmation(false);
+  fake.resetStats();
+  CHECK(modem.beginSend(data, sizeof(data)));
+  CHECK_EQUAL(LORA_AT_SEND_BUSY, modem.sendStatus());
+  commands = fake.commands().size();
+  CHECK(!modem.beginSend(data, sizeof(data)));
+  CHECK(!modem.beginSend(data, sizeof(data), options));
+  CHECK_EQUAL(commands, fake.commands().size());
+  while (modem.poll()) {}
+  CHECK_EQUAL(LORA_AT_SEND_DONE, modem.sendStatus());
+  CHECK_EQUAL(sizeof(data), modem.bytesSent());
+  CHECK_EQUAL(1, fake.stats.uplinks);
+
+  return hostTestResult("AsyncTest");
+}
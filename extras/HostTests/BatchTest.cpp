@@ -0,0 +1,65 @@
+/**
+ * @file       BatchTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks that the batcher refuses records that can never fit without
+ * sending anything, and keeps a record that filled a batch it could not send.
+ */
+
+#include <LoRa_AT.h>
+#include <LoRa_AT_Batch.h>
+
+#include "HostTest.h"
+
+static const char TEST_APP_EUI[] = "8A598335072D2776";
+static const char TEST_APP_KEY[] = "DD8F3881F180151C739534C4EC56216F";
+static const char TEST_DEV_EUI[] = "15C3202192A4504A";
+
+int main() {
+  FakeModule               fake;
+  LoRa_AT                  modem(fake);
+  LoRaStream               loraStream(modem);
+  LoRa_AT_Batcher<LoRa_AT> batch(modem);
+
+  CHECK(modem.joinOTAA(TEST_APP_EUI, TEST_APP_KEY, TEST_DEV_EUI, 3, 1000L));
+  // US915 DR0 carries 11 bytes
+  modem.setRegion(LORA_AT_REGION_US915);
+  CHECK(modem.setDataRate(0));
+
+  uint8_t record[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+
+  // a record that can never fit is refused without a send, even with a
+  // batch waiting
+  CHECK(batch.add(record, 5));
+  fake.resetStats();
+  CHECK(!batch.add(record, 12));
+  CHECK_EQUAL(0, fake.stats.commands);
+  CHECK_EQUAL(5, batch.size());
+
+  // a record that doesn't fit sends the batch first
+  CHECK(batch.add(record, 4));
+  CHECK(batch.add(record, 6));
+  CHECK_EQUAL(1, fake.stats.uplinks);
+  CHECK_EQUAL(9, fake.stats.uplinkBytes);
+  CHECK_EQUAL(6, batch.size());
+
+  // a record that fills the batch is kept when the batch can't be sent
+  fake.joined = false;
+  CHECK(batch.add(record, 5));
+  CHECK_EQUAL(1, batch.sendFailures());
+  CHECK_EQUAL(11, batch.size());
+  CHECK_EQUAL(1, fake.stats.uplinks);
+
+  // and goes out with the batch on the next flush
+  fake.joined = true;
+  CHECK(batch.flush());
+  CHECK_EQUAL(0, batch.size());
+  CHECK_EQUAL(2, fake.stats.uplinks);
+  CHECK_EQUAL(20, fake.stats.uplinkBytes);
+  CHECK_EQUAL(2, batch.frames());
+  CHECK_EQUAL(1, batch.sendFailures());
+
+  return hostTestResult("BatchTest");
+}
@@ -0,0 +1,73 @@
+/**
+ * @file       Benchmark.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Measures the device time, AT commands and serial bytes of a few
+ * whole duty cycles: a join that fails three times, a long send at the
+ * slowest data rate and draining a backlog of downlinks.
+ */
+
+#include <LoRa_AT.h>
+
+#include "HostTest.h"
+
+static const char TEST_APP_EUI[] = "8A598335072D2776";
+static const char TEST_APP_KEY[] = "DD8F3881F180151C739534C4EC56216F";
+static const char TEST_DEV_EUI[] = "15C3202192A4504A";
+
+int main() {
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+  LoRaStream loraStream(modem);
+
+  HostMeasurement::printHeader();
+  HostMeasurement call(fake);
+
+  // join with 3 failures
+  fake.joinFailures = 3;
+  fake.resetStats();
+  call.restart();
+  CHECK(modem.joinOTAA(TEST_APP_EUI, TEST_APP_KEY, TEST_DEV_EUI, 4, 1000L));
+  call.print("join with 3 failures");
+  CHECK(fake.joined);
+  CHECK_EQUAL(4, fake.stats.joinAttempts);
+  // three backoffs of at least the initial backoff each
+  CHECK(call.deviceMillis() >= 3000);
+
+  // send 200 bytes at DR0
+  uint8_t data[200];
+  for (uint16_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+  CHECK(modem.setDataRate(0));
+  fake.resetStats();
+  call.restart();
+  CHECK_EQUAL(sizeof(data), loraStream.write(data, sizeof(data)));
+  call.print("send 200 bytes at DR0");
+  // US915 DR0 carries 11 bytes, so 19 uplinks with the last one 2 bytes
+  CHECK_EQUAL(19, fake.stats.uplinks);
+  CHECK_EQUAL(sizeof(data), fake.stats.uplinkBytes);
+  CHECK_EQUAL(18 * LoRa_AT_UplinkAirtime(LORA_AT_REGION_US915, 0, 11) +
+                  LoRa_AT_UplinkAirtime(LORA_AT_REGION_US915, 0, 2),
+              fake.stats.airtime);
+
+  // drain 5 queued downlinks
+  const char* payloads[] = {"one", "two", "three", "four", "five"};
+  for (uint8_t i = 0; i < 5; i++) { fake.queueDownlink(2, payloads[i]); }
+  // the modem only checks for downlinks once the check interval has passed
+  hostAdvanceMicros((LORA_AT_DL_CHECK + 1) * 1000ULL);
+  fake.resetStats();
+  call.restart();
+  modem.maintain();
+  call.print("drain 5 queued downlinks");
+  CHECK_EQUAL(0, fake.pendingDownlinks());
+  CHECK_EQUAL(5, fake.stats.downlinks);
+  char rx[32] = {0};
+  CHECK_EQUAL(19, loraStream.available());
+  CHECK_EQUAL(19, loraStream.readBytes(rx, sizeof(rx) - 1));
+  CHECK(strcmp(rx, "onetwothreefourfive") == 0);
+
+  return hostTestResult("Benchmark");
+}
@@ -0,0 +1,79 @@
+/**
+ * @file       ChannelBenchmark.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Measures the commands it takes to move a factory-fresh US915 module
+ * onto a sub-band and between sub-bands, and checks that the channel
+ * commands still reach a Wio-E5 in automatic low power mode.
+ */
+
+#include <LoRa_AT.h>
+
+#include "HostTest.h"
+
+#if defined(LORA_AT_WIOE5)
+// Makes the module refuse channel lists, so each channel is set by itself
+static bool refuseChannelList(FakeModem& modem, const std::string& command) {
+  if (command.compare(0, 9, "AT+CH=NUM") != 0) { return false; }
+  modem.reply("+CH: ERROR(-1)\r\n", modem.latency);
+  return true;
+}
+#endif
+
+int main() {
+  HostMeasurement::printHeader();
+
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+  HostMeasurement call(fake);
+
+  // all 72 channels are on to start with
+  call.restart();
+  CHECK(modem.setFrequencySubBand(2));
+  call.print("sub-band 2 from all channels");
+  CHECK(fake.channels == LoRa_AT_ChannelMask::subBand(2));
+  CHECK_EQUAL(call.commands(), modem.channelCommandsSent());
+  CHECK_EQUAL(1, call.commands());
+
+  call.restart();
+  CHECK(modem.setFrequencySubBand(3));
+  call.print("sub-band 2 to 3");
+  CHECK(fake.channels == LoRa_AT_ChannelMask::subBand(3));
+  CHECK_EQUAL(1, call.commands());
+
+  call.restart();
+  CHECK(modem.setFrequencySubBand(3));
+  call.print("sub-band 3 again");
+  CHECK_EQUAL(0, call.commands());
+
+#if defined(LORA_AT_WIOE5)
+  {
+    // without the channel list, every channel that changes is one command
+    FakeModule slow;
+    LoRa_AT    slowModem(slow);
+    slow.script = refuseChannelList;
+    HostMeasurement slowCall(slow);
+    CHECK(slowModem.setFrequencySubBand(2));
+    slowCall.print("sub-band 2 one channel at a time");
+    CHECK(slow.channels == LoRa_AT_ChannelMask::subBand(2));
+    // the refused list, a read of the mask and the 63 channels turned off
+    CHECK_EQUAL(65, slowCall.commands());
+    CHECK(slowCall.commands() > 30 * call.commands());
+  }
+
+  // in automatic low power mode every command needs the wake up bytes,
+  // including the channel list
+  CHECK(modem.enableAutoSleep(true));
+  CHECK(fake.lowPower());
+  fake.resetStats();
+  call.restart();
+  CHECK(modem.setFrequencySubBand(4));
+  call.print("sub-band 3 to 4 in low power mode");
+  CHECK(fake.channels == LoRa_AT_ChannelMask::subBand(4));
+  CHECK_EQUAL(0, fake.stats.ignored);
+#endif
+
+  return hostTestResult("ChannelBenchmark");
+}
@@ -0,0 +1,232 @@
+/**
+ * @file       CodecBenchmark.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Runs each payload codec over day-long sensor traces and prints the
+ * compression ratio and the host cycles per byte it takes to encode and
+ * decode, after checking that every message comes back unchanged.
+ *
+ * The traces are a day of readings every fifteen minutes, sent as the
+ * messages a logger would make of them: a timestamp series, a temperature in
+ * hundredths of a degree, a pressure in pascals, a rain gauge tip counter and
+ * text reports of all of them.
+ */
+
+#include <LoRa_AT_Codec.h>
+
+#include <chrono>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "HostTest.h"
+
+typedef std::vector<uint8_t>  Message;
+typedef std::vector<Message> Trace;
+
+static const int    SAMPLES      = 96;  // a day at fifteen minute intervals
+static const size_t MESSAGE_SIZE = 48;  // fits an uplink at any data rate
+static const int    ROUNDS       = 200;
+
+// A repeatable source of noise
+static uint32_t noise_state = 12345;
+static int32_t  noise(int32_t spread) {
+  noise_state = noise_state * 1103515245UL + 12345;
+  return static_cast<int32_t>((noise_state >> 16) % (2 * spread + 1)) - spread;
+}
+
+// Splits packed samples into messages of whole samples
+template <typename T>
+static Trace toMessages(const std::vector<T>& samples) {
+  Trace  trace;
+  size_t per = MESSAGE_SIZE / sizeof(T);
+  for (size_t i = 0; i < samples.size(); i += per) {
+    size_t         n = samples.size() - i < per ? samples.size() - i : per;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&samples[i]);
+    trace.push_back(Message(p, p + n * sizeof(T)));
+  }
+  return trace;
+}
+
+static Trace timestamps() {
+  std::vector<uint32_t> samples;
+  uint32_t              t = 1791000000UL;
+  for (int i = 0; i < SAMPLES; i++) {
+    // the logger wakes up to a second late now and then
+    samples.push_back(t + (i % 11 == 0 ? 1 : 0));
+    t += 900;
+  }
+  return toMessages(samples);
+}
+
+static Trace temperature() {
+  std::vector<int16_t> samples;
+  for (int i = 0; i < SAMPLES; i++) {
+    double day = 2 * M_PI * i / SAMPLES;
+    samples.push_back(
+        static_cast<int16_t>(1850 + 600 * sin(day - M_PI / 2) + noise(3)));
+  }
+  return toMessages(samples);
+}
+
+static Trace pressure() {
+  std::vector<int32_t> samples;
+  int32_t              p = 101325;
+  for (int i = 0; i < SAMPLES; i++) {
+    p += noise(4) - (i > SAMPLES / 2 ? 3 : 0);  // a front comes through
+    samples.push_back(p);
+  }
+  return toMessages(samples);
+}
+
+static Trace rainTips() {
+  std::vector<uint32_t> samples;
+  uint32_t              tips = 40213;
+  for (int i = 0; i < SAMPLES; i++) {
+    if (i > 30 && i < 45) { tips += 2 + noise(2); }
+    samples.push_back(tips);
+  }
+  return toMessages(samples);
+}
+
+static const char REPORT_DICTIONARY[] =
+    "{\"site\":\"SL099\",\"time\":1791000000,\"temp\":18.50,"
+    "\"pressure\":101325,\"rain\":40213}";
+
+static Trace reports() {
+  Trace    trace;
+  uint32_t tips = 40213;
+  noise_state   = 12345;
+  for (int i = 0; i < SAMPLES; i++) {
+    double day  = 2 * M_PI * i / SAMPLES;
+    int    temp = static_cast<int>(1850 + 600 * sin(day - M_PI / 2) + noise(3));
+    if (i > 30 && i < 45) { tips += 2; }
+    char text[96];
+    int  n = snprintf(text, sizeof(text),
+                      "{\"site\":\"SL099\",\"time\":%lu,\"temp\":%d.%02d,"
+                      "\"pressure\":%ld,\"rain\":%lu}",
+                      1791000000UL + 900UL * i, temp / 100, temp % 100,
+                      101325L + noise(40), static_cast<unsigned long>(tips));
+    trace.push_back(Message(text, text + n));
+  }
+  return trace;
+}
+
+// Host cycles since some fixed point; the time stamp counter where there is
+// one and nanoseconds elsewhere
+static uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+static void printHeader() {
+  printf("%-14s %-12s %8s %8s %7s %12s %12s\n", "trace", "codec", "bytes in",
+         "out", "ratio", "enc cyc/B", "dec cyc/B");
+}
+
+// Encodes and decodes every message of a trace, checking the round trip, and
+// prints the ratio and the cost per message byte. Returns the ratio.
+static double run(const char* traceName, const Trace& trace,
+                  const char* codecName, LoRa_AT_Codec& codec) {
+  uint8_t encoded[LORA_AT_CODEC_BUFFER];
+  uint8_t decoded[LORA_AT_CODEC_BUFFER];
+  size_t  bytesIn  = 0;
+  size_t  bytesOut = 0;
+  for (const Message& message : trace) {
+    size_t n = codec.encode(message.data(), message.size(), encoded,
+                            sizeof(encoded));
+    CHECK(n > 0);
+    size_t back = codec.decode(encoded, n, decoded, sizeof(decoded));
+    CHECK_EQUAL(message.size(), back);
+    CHECK(back == message.size() &&
+          memcmp(decoded, message.data(), back) == 0);
+    bytesIn += message.size();
+    bytesOut += n;
+  }
+
+  // keep the results live so the loops aren't optimized away
+  volatile size_t sink  = 0;
+  uint64_t        start = cycles();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (const Message& message : trace) {
+      sink = sink + codec.encode(message.data(), message.size(), encoded,
+                                 sizeof(encoded));
+    }
+  }
+  uint64_t encodeCycles = cycles() - start;
+
+  std::vector<Message> packed;
+  for (const Message& message : trace) {
+    size_t n = codec.encode(message.data(), message.size(), encoded,
+                            sizeof(encoded));
+    packed.push_back(Message(encoded, encoded + n));
+  }
+  start = cycles();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (const Message& message : packed) {
+      sink = sink + codec.decode(message.data(), message.size(), decoded,
+                                 sizeof(decoded));
+    }
+  }
+  uint64_t decodeCycles = cycles() - start;
+
+  double total = static_cast<double>(bytesIn) * ROUNDS;
+  double ratio = static_cast<double>(bytesIn) / bytesOut;
+  printf("%-14s %-12s %8lu %8lu %7.2f %12.1f %12.1f\n", traceName, codecName,
+         static_cast<unsigned long>(bytesIn),
+         static_cast<unsigned long>(bytesOut), ratio, encodeCycles / total,
+         decodeCycles / total);
+  return ratio;
+}
+
+int main() {
+  LoRa_AT_VarintCodec<int32_t>     varint32;
+  LoRa_AT_VarintCodec<int16_t>     varint16;
+  LoRa_AT_DeltaDeltaCodec<int32_t> deltaDelta32;
+  LoRa_AT_DeltaDeltaCodec<int16_t> deltaDelta16;
+  LoRa_AT_DictionaryCodec          lz;
+  LoRa_AT_DictionaryCodec          dictionary(
+      reinterpret_cast<const uint8_t*>(REPORT_DICTIONARY),
+      sizeof(REPORT_DICTIONARY) - 1);
+
+  Trace time  = timestamps();
+  Trace temp  = temperature();
+  Trace press = pressure();
+  Trace rain  = rainTips();
+  Trace text  = reports();
+
+#if !defined(__x86_64__) && !defined(__i386__)
+  printf("No time stamp counter; cycles are nanoseconds\n");
+#endif
+  printHeader();
+  double timeVarint = run("timestamps", time, "varint", varint32);
+  double timeDelta  = run("timestamps", time, "delta-delta", deltaDelta32);
+  double tempVarint = run("temperature", temp, "varint", varint16);
+  double tempDelta  = run("temperature", temp, "delta-delta", deltaDelta16);
+  run("pressure", press, "varint", varint32);
+  double pressDelta = run("pressure", press, "delta-delta", deltaDelta32);
+  run("rain tips", rain, "varint", varint32);
+  double rainDelta = run("rain tips", rain, "delta-delta", deltaDelta32);
+  double textLz    = run("reports", text, "lz77", lz);
+  double textDict  = run("reports", text, "dictionary", dictionary);
+
+  // steady series take about a byte a sample after the first two, which are
+  // written in full in every message
+  CHECK(timeDelta > 2.5 && timeDelta > timeVarint);
+  CHECK(tempDelta > 1.5 && tempDelta > tempVarint);
+  CHECK(pressDelta > 3.0);
+  CHECK(rainDelta > 3.0);
+  // short reports hardly repeat themselves, but share most of the dictionary
+  CHECK(textDict > 2.0 && textDict > textLz);
+
+  return hostTestResult("CodecBenchmark");
+}
@@ -0,0 +1,85 @@
+/**
+ * @file       DriverTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Runs the main calls of the driver against the simulated module and
+ * prints what each one cost.
+ */
+
+#include <LoRa_AT.h>
+
+#include "HostTest.h"
+
+static const char TEST_APP_EUI[] = "8A598335072D2776";
+static const char TEST_APP_KEY[] = "DD8F3881F180151C739534C4EC56216F";
+static const char TEST_DEV_EUI[] = "15C3202192A4504A";
+
+int main() {
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+  LoRaStream loraStream(modem);
+
+  HostMeasurement::printHeader();
+  HostMeasurement call(fake);
+
+  CHECK(modem.testAT(1000L));
+  call.print("testAT");
+
+  call.restart();
+  CHECK(modem.joinOTAA(TEST_APP_EUI, TEST_APP_KEY, TEST_DEV_EUI, 3, 1000L));
+  call.print("joinOTAA");
+  CHECK(fake.joined);
+  CHECK_EQUAL(1, fake.stats.joinAttempts);
+
+  call.restart();
+  CHECK(modem.setPort(12));
+  CHECK_EQUAL(12, modem.getPort());
+  call.print("setPort + getPort");
+  CHECK_EQUAL(12, fake.port);
+
+  // 30 bytes at US915 DR0 take three 11 byte uplinks
+  uint8_t data[30];
+  for (uint8_t i = 0; i < sizeof(data); i++) { data[i] = i; }
+  fake.resetStats();
+  call.restart();
+  CHECK_EQUAL(sizeof(data), loraStream.write(data, sizeof(data)));
+  call.print("write 30 bytes at DR0");
+  CHECK_EQUAL(3, fake.stats.uplinks);
+  CHECK_EQUAL(sizeof(data), fake.stats.uplinkBytes);
+  CHECK_EQUAL(3 * LoRa_AT_UplinkAirtime(LORA_AT_REGION_US915, 0, 11),
+              fake.stats.airtime);
+#if defined(LORA_AT_MDOT)
+  CHECK(fake.count("AT+TXS?") >= 1);
+  CHECK_EQUAL(3, fake.count("AT+SENDB="));
+#else
+  CHECK(fake.count("AT+LW=LEN") >= 1);
+  CHECK_EQUAL(3, fake.count("AT+MSGHEX="));
+#endif
+
+  // a downlink comes back after the next uplink
+  fake.queueDownlink(2, "hello");
+  call.restart();
+  CHECK_EQUAL(1, loraStream.write(data, 1));
+  call.print("write 1 byte with a downlink");
+  CHECK_EQUAL(5, loraStream.available());
+  char rx[8] = {0};
+  CHECK_EQUAL(5, loraStream.readBytes(rx, 5));
+  CHECK(strcmp(rx, "hello") == 0);
+
+  // a link check
+  fake.linkMargin = 17;
+  modem.setLinkStaleness(0);
+  call.restart();
+  CHECK(modem.isNetworkConnected(1, 1000L));
+  call.print("isNetworkConnected");
+  CHECK_EQUAL(17, modem.linkHistory().latest(LORA_AT_LINK_MARGIN));
+#if defined(LORA_AT_MDOT)
+  CHECK_EQUAL(1, fake.count("AT+NLC"));
+#else
+  CHECK_EQUAL(1, fake.count("AT+LW=LCR"));
+#endif
+
+  return hostTestResult("DriverTest");
+}
@@ -0,0 +1,526 @@
+/**
+ * @file       FakeModem.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "FakeModem.h"
+
+#include "LoRa_AT_Airtime.h"
+
+// The receive windows open one and two seconds after an uplink; a downlink
+// takes about this long to arrive in one
+static const uint32_t RX1_DELAY    = 1000;
+static const uint32_t RX2_DELAY    = 2000;
+static const uint32_t RX_DURATION  = 100;
+static const uint32_t JOIN_DELAY   = 5000;
+static const uint32_t RETRY_DELAY  = 2000;
+static const uint8_t  JOIN_REQUEST = 10;  // 23 byte PHY payload
+
+static std::string toHex(const std::string& data) {
+  static const char hex[] = "0123456789ABCDEF";
+  std::string       out;
+  for (unsigned char c : data) {
+    out += hex[c >> 4];
+    out += hex[c & 0x0F];
+  }
+  return out;
+}
+
+static std::string fromHex(const std::string& hex) {
+  std::string out;
+  for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+    out += static_cast<char>(strtol(hex.substr(i, 2).c_str(), nullptr, 16));
+  }
+  return out;
+}
+
+static std::string number(long value) {
+  char b[24];
+  snprintf(b, sizeof(b), "%ld", value);
+  return b;
+}
+
+
+/*
+ * FakeModem
+ */
+FakeModem::FakeModem(uint32_t baud)
+    : region(LORA_AT_REGION_US915),
+      dataRate(0),
+      adr(true),
+      joined(false),
+      joinFailures(0),
+      port(8),
+      retries(3),
+      networkAcks(true),
+      macPending(0),
+      linkMargin(20),
+      gateways(1),
+      rssi(-90),
+      snr(5),
+      latency(5),
+      channels(LoRa_AT_ChannelMask::subBand(0)),
+      _linkCheck(false),
+      _lowPower(false),
+      _byteMicros(10000000UL / baud),
+      _lastOut(0),
+      _wakeBytes(0) {
+  resetStats();
+}
+
+int FakeModem::available() {
+  size_t n = ready();
+  if (!n) {
+    idle();
+    n = ready();
+  }
+  return static_cast<int>(n);
+}
+
+int FakeModem::read() {
+  if (!ready()) { idle(); }
+  if (!ready()) { return -1; }
+  uint8_t c = _out.front().second;
+  _out.pop_front();
+  stats.bytesRead++;
+  return c;
+}
+
+int FakeModem::peek() {
+  if (!ready()) { idle(); }
+  return ready() ? _out.front().second : -1;
+}
+
+size_t FakeModem::write(uint8_t c) {
+  // the library waits while the byte goes out
+  hostAdvanceMicros(_byteMicros);
+  stats.bytesWritten++;
+  if (c == 0xFF && _line.empty()) {
+    _wakeBytes++;
+    return 1;
+  }
+  if (c != '\n') {
+    _line += static_cast<char>(c);
+    return 1;
+  }
+  std::string command = _line;
+  if (!command.empty() && command[command.size() - 1] == '\r') {
+    command.erase(command.size() - 1);
+  }
+  bool awake = !_lowPower || _wakeBytes >= 4;
+  _line.clear();
+  _wakeBytes = 0;
+  if (!awake) {
+    stats.ignored++;
+    return 1;
+  }
+  stats.commands++;
+  _commands.push_back(command);
+  if (!script || !script(*this, command)) { handle(command); }
+  return 1;
+}
+
+void FakeModem::reply(const std::string& text, uint32_t delay_ms) {
+  uint64_t start = hostMicros() + static_cast<uint64_t>(delay_ms) * 1000;
+  if (start < _lastOut) { start = _lastOut; }
+  for (unsigned char c : text) {
+    start += _byteMicros;
+    _out.push_back(std::make_pair(start, c));
+  }
+  _lastOut = start;
+}
+
+void FakeModem::queueDownlink(uint8_t downlinkPort,
+                              const std::string& payload) {
+  _downlinks.push_back(std::make_pair(downlinkPort, payload));
+}
+
+size_t FakeModem::count(const char* prefix) const {
+  size_t n = 0;
+  for (const std::string& c : _commands) {
+    if (c.compare(0, strlen(prefix), prefix) == 0) { n++; }
+  }
+  return n;
+}
+
+void FakeModem::resetStats() {
+  memset(&stats, 0, sizeof(stats));
+  _commands.clear();
+}
+
+void FakeModem::clearOutput() {
+  _out.clear();
+  _lastOut = 0;
+}
+
+bool FakeModem::isCommand(const std::string& line, const char* name,
+                          std::string* value) {
+  size_t len = strlen(name);
+  if (line.compare(0, 2, "AT") != 0 || line.compare(2, len, name) != 0) {
+    return false;
+  }
+  if (line.size() == len + 2) {
+    if (value) { value->clear(); }
+    return true;
+  }
+  if (line[len + 2] != '=') { return false; }
+  if (value) { *value = line.substr(len + 3); }
+  return true;
+}
+
+uint8_t FakeModem::space() const {
+  uint8_t largest = LoRa_AT_MaxPayload(region, dataRate);
+  return largest > macPending ? largest - macPending : 0;
+}
+
+uint32_t FakeModem::transmit(size_t len) {
+  uint32_t air = LoRa_AT_UplinkAirtime(region, dataRate, len + macPending);
+  stats.uplinks++;
+  stats.uplinkBytes += len;
+  stats.airtime += air;
+  return air;
+}
+
+FakeModem::Reception FakeModem::uplink(size_t len, bool confirmed) {
+  Reception rx = {false, false, false, false, 0, "", 0, 0};
+  uint32_t  t  = latency;
+  uint8_t   tries = confirmed && !networkAcks ? retries + 1 : 1;
+  for (uint8_t i = 0; i < tries; i++) {
+    if (i) { t += RX2_DELAY + RX_DURATION + RETRY_DELAY; }
+    t += transmit(len);
+  }
+  macPending = 0;
+  rx.acked     = confirmed && networkAcks;
+  rx.linkCheck = _linkCheck;
+  _linkCheck   = false;
+  if (!_downlinks.empty() && joined) {
+    rx.hasDownlink = true;
+    rx.port        = _downlinks.front().first;
+    rx.payload     = _downlinks.front().second;
+    _downlinks.pop_front();
+    rx.pending = !_downlinks.empty();
+    stats.downlinks++;
+  }
+  if (rx.acked || rx.linkCheck || rx.hasDownlink) {
+    rx.at   = t + RX1_DELAY + RX_DURATION;
+    rx.done = rx.at + latency;
+  } else {
+    rx.at   = t + RX2_DELAY + RX_DURATION;
+    rx.done = rx.at;
+  }
+  return rx;
+}
+
+bool FakeModem::joinRequest(uint32_t* done) {
+  stats.joinAttempts++;
+  uint32_t t = latency + transmit(JOIN_REQUEST);
+  stats.uplinkBytes -= JOIN_REQUEST;
+  if (joinFailures) {
+    joinFailures--;
+    *done = t + JOIN_DELAY + 1000 + RX_DURATION;
+    return false;
+  }
+  joined = true;
+  *done  = t + JOIN_DELAY + RX_DURATION;
+  return true;
+}
+
+size_t FakeModem::ready() const {
+  uint64_t now = hostMicros();
+  size_t   n   = 0;
+  while (n < _out.size() && _out[n].first <= now) { n++; }
+  return n;
+}
+
+// Nothing has arrived, so time passes until the next byte does, but by no
+// more than a millisecond at a time
+void FakeModem::idle() {
+  uint64_t now  = hostMicros();
+  uint64_t step = 1000;
+  if (!_out.empty() && _out.front().first > now &&
+      _out.front().first - now < step) {
+    step = _out.front().first - now;
+  }
+  hostAdvanceMicros(step);
+}
+
+
+/*
+ * FakeWioE5
+ */
+FakeWioE5::FakeWioE5() : FakeModem(9600) {}
+
+void FakeWioE5::handle(const std::string& command) {
+  std::string v;
+  if (command == "AT") {
+    reply("+AT: OK\r\n", latency);
+  } else if (isCommand(command, "+MSGHEX", &v)) {
+    send("+MSGHEX", v, true, false);
+  } else if (isCommand(command, "+CMSGHEX", &v)) {
+    send("+CMSGHEX", v, true, true);
+  } else if (isCommand(command, "+MSG", &v)) {
+    send("+MSG", v, false, false);
+  } else if (isCommand(command, "+CMSG", &v)) {
+    send("+CMSG", v, false, true);
+  } else if (isCommand(command, "+LW", &v)) {
+    if (v == "LEN") {
+      reply("+LW: LEN, " + number(space()) + "\r\n", latency);
+    } else if (v == "LCR") {
+      _linkCheck = true;
+      reply("+LW: LCR\r\n", latency);
+    } else if (v == "VER") {
+      reply("+LW: VER, v1.0.2\r\n", latency);
+    } else if (v.compare(0, 2, "DC") == 0) {
+      reply("+LW: DC, OFF, 0\r\n", latency);
+    } else {
+      reply("+LW: " + v + "\r\n", latency);
+    }
+  } else if (isCommand(command, "+JOIN", &v)) {
+    if (joined && v != "FORCE") {
+      reply("+JOIN: Joined already\r\n", latency);
+      return;
+    }
+    reply("+JOIN: Start\r\n+JOIN: NORMAL\r\n", latency);
+    uint32_t done;
+    if (joinRequest(&done)) {
+      reply("+JOIN: Network joined\r\n+JOIN: NetID 000013 DevAddr "
+            "26:0B:11:22\r\n+JOIN: Done\r\n",
+            done);
+    } else {
+      reply("+JOIN: Join failed\r\n+JOIN: Done\r\n", done);
+    }
+  } else if (isCommand(command, "+DR", &v)) {
+    if (v == "SCHEME") {
+      reply(region == LORA_AT_REGION_EU868 ? "+DR: EU868\r\n"
+                                           : "+DR: US915\r\n",
+            latency);
+    } else if (!v.empty() && isdigit(v[0])) {
+      dataRate = atoi(v.c_str());
+      reply("+DR: DR" + v + "\r\n", latency);
+    } else if (!v.empty()) {
+      LoRa_AT_RegionFromBand(v.c_str(), &region);
+      reply("+DR: " + v + "\r\n", latency);
+    } else {
+      reply("+DR: DR" + number(dataRate) + "\r\n", latency);
+    }
+  } else if (isCommand(command, "+ADR", &v)) {
+    if (!v.empty()) { adr = v == "ON"; }
+    reply(std::string("+ADR: ") + (adr ? "ON" : "OFF") + "\r\n", latency);
+  } else if (command == "AT+ADR?") {
+    reply(std::string("+ADR: ") + (adr ? "ON" : "OFF") + "\r\n", latency);
+  } else if (isCommand(command, "+PORT", &v)) {
+    if (!v.empty()) { port = atoi(v.c_str()); }
+    reply("+PORT: " + number(port) + "\r\n", latency);
+  } else if (isCommand(command, "+RETRY", &v)) {
+    if (!v.empty()) { retries = atoi(v.c_str()); }
+    reply("+RETRY: " + number(retries) + "\r\n", latency);
+  } else if (isCommand(command, "+CLASS", &v)) {
+    reply("+CLASS: A\r\n", latency);
+  } else if (isCommand(command, "+CH", &v)) {
+    if (v.compare(0, 3, "NUM") == 0) {
+      // AT+CH=NUM,8-15,65
+      channels = LoRa_AT_ChannelMask();
+      for (size_t p = v.find(','); p != std::string::npos;
+           p = v.find(',', p + 1)) {
+        char* end;
+        long  first = strtol(v.c_str() + p + 1, &end, 10);
+        long  last  = *end == '-' ? strtol(end + 1, nullptr, 10) : first;
+        for (long i = first; i <= last; i++) { channels.set(i); }
+      }
+      reply("+CH: " + v + "\r\n", latency);
+    } else if (!v.empty()) {
+      // AT+CH=8,ON
+      int  ch = atoi(v.c_str());
+      bool on = v.find("ON") != std::string::npos;
+      channels.set(ch, on);
+      reply("+CH: CH" + number(ch) + (on ? " ON" : " OFF") + "\r\n", latency);
+    } else {
+      std::string list;
+      for (uint8_t i = 0; i < 72; i++) {
+        if (channels.test(i)) {
+          list += " " + number(i) + ",902300000,DR0,DR3;";
+        }
+      }
+      reply("+CH: " + number(channels.count()) + ";" + list + "\r\n", latency);
+    }
+  } else if (isCommand(command, "+LOWPOWER", &v)) {
+    if (v == "AUTOON" || v == "AUTOOFF") {
+      _lowPower = v == "AUTOON";
+      reply("+LOWPOWER: " + v + "\r\n", latency);
+    } else {
+      reply("+LOWPOWER: SLEEP\r\n", latency);
+    }
+  } else if (isCommand(command, "+MODE", &v)) {
+    reply("+MODE: " + v + "\r\n", latency);
+  } else if (isCommand(command, "+ID", &v)) {
+    std::string name = v.substr(0, v.find(','));
+    std::string id   = v.find('"') != std::string::npos
+          ? v.substr(v.find('"') + 1, v.rfind('"') - v.find('"') - 1)
+          : "2C:F7:F1:20:32:30:A5:D4";
+    reply("+ID: " + name + ", " + id + "\r\n", latency);
+  } else if (isCommand(command, "+KEY", &v)) {
+    reply("+KEY: " + v.substr(0, v.find(',')) + " " +
+              v.substr(v.find(',') + 1) + "\r\n",
+          latency);
+  } else if (isCommand(command, "+LOG", &v)) {
+    reply("+LOG: " + v + "\r\n", latency);
+  } else if (isCommand(command, "+VER")) {
+    reply("+VER: 4.0.11\r\n", latency);
+  } else if (isCommand(command, "+RESET")) {
+    reply("+RESET: OK\r\n", latency);
+  } else {
+    reply(command.substr(2, command.find('=') - 2) + ": ERROR(-1)\r\n",
+          latency);
+  }
+}
+
+void FakeWioE5::send(const std::string& name, const std::string& value,
+                     bool hex, bool confirmed) {
+  if (!joined) {
+    reply(name + ": Please join network first\r\n", latency);
+    return;
+  }
+  std::string payload = value;
+  if (payload.size() >= 2 && payload[0] == '"') {
+    payload = payload.substr(1, payload.size() - 2);
+  }
+  if (hex) { payload = fromHex(payload); }
+  if (payload.size() > space()) {
+    reply(name + ": Length error " + number(space()) + "\r\n", latency);
+    return;
+  }
+  reply(name + ": Start\r\n", latency);
+  if (confirmed) { reply(name + ": Wait ACK\r\n", latency); }
+  Reception rx = uplink(payload.size(), confirmed);
+  if (rx.pending) { reply(name + ": FPENDING\r\n", rx.at); }
+  if (rx.linkCheck) {
+    reply(name + ": Link " + number(linkMargin) + ", " + number(gateways) +
+              "\r\n",
+          rx.at);
+  }
+  if (rx.acked) { reply(name + ": ACK Received\r\n", rx.at); }
+  if (rx.hasDownlink) {
+    reply(name + ": PORT: " + number(rx.port) + "; RX: \"" +
+              toHex(rx.payload) + "\"\r\n",
+          rx.at);
+  }
+  if (rx.acked || rx.linkCheck || rx.hasDownlink) {
+    reply(name + ": RXWIN1, RSSI " + number(rssi) + ", SNR " + number(snr) +
+              "\r\n",
+          rx.at);
+  }
+  reply(name + ": Done\r\n", rx.done);
+}
+
+
+/*
+ * FakeMDOT
+ */
+FakeMDOT::FakeMDOT() : FakeModem(115200) {
+  retries = 0;
+}
+
+void FakeMDOT::ok(const std::string& value) {
+  reply(value.empty() ? "\r\nOK\r\n" : "\r\n" + value + "\r\n\r\nOK\r\n",
+        latency);
+}
+
+void FakeMDOT::handle(const std::string& command) {
+  std::string v;
+  if (command == "AT" || command == "ATE0" || command == "ATV0" ||
+      command == "ATV1" || command == "AT&W" || command == "ATZ") {
+    ok();
+  } else if (isCommand(command, "+SENDB", &v)) {
+    send(fromHex(v), false);
+  } else if (isCommand(command, "+SEND", &v)) {
+    send(v, false);
+  } else if (command == "AT+NLC") {
+    send("", true);
+  } else if (isCommand(command, "+JOIN", &v)) {
+    uint32_t done;
+    if (joinRequest(&done)) {
+      reply("\r\nSuccessfully joined network\r\n\r\nOK\r\n", done);
+    } else {
+      reply("\r\nFailed to join network\r\n\r\nERROR\r\n", done);
+    }
+  } else if (command == "AT+TXS?") {
+    ok(number(space()));
+  } else if (command == "AT+TXN?") {
+    ok("0");
+  } else if (isCommand(command, "+ACK", &v)) {
+    retries = atoi(v.c_str());
+    ok();
+  } else if (command == "AT+ACK?") {
+    ok(number(retries));
+  } else if (isCommand(command, "+TXDR", &v)) {
+    dataRate = atoi(v.c_str());
+    ok();
+  } else if (command == "AT+TXDR?") {
+    ok("DR" + number(dataRate) + " - SF" + number(10 - dataRate) + "BW125");
+  } else if (isCommand(command, "+ADR", &v)) {
+    adr = atoi(v.c_str());
+    ok();
+  } else if (command == "AT+ADR?") {
+    ok(adr ? "1" : "0");
+  } else if (isCommand(command, "+AP", &v)) {
+    port = atoi(v.c_str());
+    ok();
+  } else if (command == "AT+AP?") {
+    ok(number(port));
+  } else if (isCommand(command, "+FSB", &v)) {
+    channels = LoRa_AT_ChannelMask::subBand(atoi(v.c_str()));
+    ok();
+  } else if (isCommand(command, "+CHM", &v)) {
+    // AT+CHM=1,00FF sets channels 16-31
+    int      offset = atoi(v.c_str());
+    uint16_t group  = strtol(v.c_str() + v.find(',') + 1, nullptr, 16);
+    for (uint8_t i = 0; i < 16 && offset * 16 + i < 72; i++) {
+      channels.set(offset * 16 + i, (group >> i) & 1);
+    }
+    ok();
+  } else if (command == "AT+CHM?") {
+    char hex[19];
+    ok(channels.toHex(hex));
+  } else if (command == "AT+RSSI") {
+    ok(number(rssi) + ", -120, -60, -90.5");
+  } else if (command == "AT+DC?") {
+    ok("A");
+  } else if (command == "AT+DUTY?") {
+    ok("Max 0");
+  } else if (command == "AT+PN?") {
+    ok("1");
+  } else if (command.compare(0, 3, "AT+") == 0 &&
+             command.find('=') != std::string::npos) {
+    // settings the simulation doesn't model
+    ok();
+  } else {
+    reply("\r\nERROR\r\n", latency);
+  }
+}
+
+void FakeMDOT::send(const std::string& payload, bool linkCheck) {
+  if (!joined) {
+    reply("\r\nNetwork Not Joined\r\n\r\nERROR\r\n", latency);
+    return;
+  }
+  if (payload.size() > space()) {
+    reply("\r\nData exceeds datarate max payload\r\n\r\nERROR\r\n", latency);
+    return;
+  }
+  if (linkCheck) { _linkCheck = true; }
+  bool      confirmed = retries > 0;
+  Reception rx        = uplink(payload.size(), confirmed);
+  if (confirmed && !rx.acked) {
+    reply("\r\nERROR\r\n", rx.done);
+    return;
+  }
+  std::string out;
+  if (rx.linkCheck) {
+    out += "\r\n" + number(linkMargin) + "," + number(gateways) + "\r\n";
+  }
+  // the module puts a fixed run of line breaks before any downlink
+  if (rx.hasDownlink) { out += "\r\r\n\r\r\n" + rx.payload + "\r\n"; }
+  reply(out.empty() ? "\r\n\r\nOK\r\n" : out + "\r\nOK\r\n", rx.done);
+}
@@ -0,0 +1,203 @@
+/**
+ * @file       FakeModem.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Simulated Wio-E5 and mDOT modules that answer the AT dialects the
+ * library speaks, on the virtual clock of the host shim.
+ */
+
+#ifndef EXTRAS_HOSTTESTS_FAKEMODEM_H_
+#define EXTRAS_HOSTTESTS_FAKEMODEM_H_
+
+#include <Arduino.h>
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LoRa_AT_ChannelMask.h"
+#include "LoRa_AT_Regions.h"
+
+/**
+ * @brief A simulated LoRa module behind a serial port.
+ *
+ * Everything the module prints is scheduled on the virtual clock: it answers
+ * each command after #latency, every byte takes as long as it would at the
+ * baud rate, and an uplink takes its time on air plus the receive windows.
+ * Reading from the module while nothing has arrived moves the clock forward,
+ * the same as a board waiting on its serial port.
+ *
+ * The network is modelled just far enough to exercise the library: joins can
+ * be made to fail, downlinks and MAC answers can be queued for the next
+ * uplinks, and confirmed uplinks can go unanswered.
+ *
+ * Every command is counted and kept, and a script can answer any command
+ * before the built-in dialect does.
+ */
+class FakeModem : public Stream {
+ public:
+  /// @brief The traffic and radio use since the last resetStats()
+  struct Stats {
+    uint32_t commands;      ///< AT commands the module heard
+    uint32_t ignored;       ///< AT commands lost because the module was asleep
+    uint32_t bytesWritten;  ///< bytes from the library to the module
+    uint32_t bytesRead;     ///< bytes from the module read by the library
+    uint32_t uplinks;       ///< frames sent over the air, including retries
+    uint32_t uplinkBytes;   ///< application bytes sent over the air
+    uint32_t airtime;       ///< milliseconds spent transmitting
+    uint32_t joinAttempts;  ///< join requests sent
+    uint32_t downlinks;     ///< application downlinks delivered
+  };
+
+  /**
+   * @brief A hook that sees each command before the built-in dialect.
+   *
+   * Return true if the script answered the command itself.
+   */
+  typedef std::function<bool(FakeModem& modem, const std::string& command)>
+      Script;
+
+  explicit FakeModem(uint32_t baud);
+  virtual ~FakeModem() {}
+
+  /*
+   * Stream functions
+   */
+  int    available() override;
+  int    read() override;
+  int    peek() override;
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  /*
+   * Scripting
+   */
+  /// @brief Print text from the module after a delay in milliseconds
+  void reply(const std::string& text, uint32_t delay_ms = 0);
+  /// @brief Queue a downlink to be delivered after the next uplink
+  void queueDownlink(uint8_t port, const std::string& payload);
+  /// @brief The number of downlinks still waiting for an uplink
+  size_t pendingDownlinks() const {
+    return _downlinks.size();
+  }
+  /// @brief Every command heard, without the line ending
+  const std::vector<std::string>& commands() const {
+    return _commands;
+  }
+  /// @brief Count the commands heard that start with a prefix
+  size_t count(const char* prefix) const;
+  /// @brief Clear the statistics and the list of commands
+  void resetStats();
+  /// @brief Drop anything the module was about to print
+  void clearOutput();
+
+  Script script;
+  Stats  stats;
+
+  /*
+   * The simulated module and network
+   */
+  LoRa_AT_Region      region;        ///< the band of the module
+  uint8_t             dataRate;      ///< the uplink data rate
+  bool                adr;           ///< adaptive data rate
+  bool                joined;        ///< joined to the network
+  uint8_t             joinFailures;  ///< how many of the next joins fail
+  uint8_t             port;          ///< the uplink port
+  uint8_t             retries;       ///< retries of confirmed uplinks
+  bool                networkAcks;   ///< the network acks confirmed uplinks
+  uint8_t             macPending;    ///< bytes of MAC answers to send next
+  int8_t              linkMargin;    ///< margin reported by link checks
+  uint8_t             gateways;      ///< gateways reported by link checks
+  int16_t             rssi;          ///< RSSI of downlinks
+  int8_t              snr;           ///< SNR of downlinks
+  uint32_t            latency;       ///< milliseconds to answer a command
+  LoRa_AT_ChannelMask channels;      ///< the enabled channels
+
+ protected:
+  virtual void handle(const std::string& command) = 0;
+
+  // Matches a command without a value, or with a value after an =
+  static bool isCommand(const std::string& line, const char* name,
+                        std::string* value = nullptr);
+
+  // The largest application payload of the next uplink
+  uint8_t space() const;
+  // Sends a frame and any queued MAC answers, returning the airtime in ms
+  uint32_t transmit(size_t len);
+  // What the module hears back after an uplink
+  struct Reception {
+    bool        acked;
+    bool        linkCheck;
+    bool        pending;
+    bool        hasDownlink;
+    uint8_t     port;
+    std::string payload;
+    uint32_t    at;    ///< ms from now when the downlink arrives
+    uint32_t    done;  ///< ms from now when the module is done
+  };
+  // Sends an uplink, with retries if it is confirmed and not acked
+  Reception uplink(size_t len, bool confirmed);
+  // A join request, returning whether it worked
+  bool joinRequest(uint32_t* done);
+
+  bool _linkCheck;  // a link check rides on the next uplink
+  bool _lowPower;   // commands need four 0xFF bytes to wake the module
+
+ private:
+  size_t ready() const;
+  void   idle();
+
+  uint32_t                                  _byteMicros;
+  std::deque<std::pair<uint64_t, uint8_t> > _out;
+  uint64_t                                  _lastOut;
+  std::string                               _line;
+  uint8_t                                   _wakeBytes;
+  std::vector<std::string>                  _commands;
+  std::deque<std::pair<uint8_t, std::string> > _downlinks;
+};
+
+/**
+ * @brief A simulated Seeed Wio-E5 (LoRa-E5)
+ */
+class FakeWioE5 : public FakeModem {
+ public:
+  FakeWioE5();
+  /// @brief Whether the module is in automatic low power mode
+  bool lowPower() const {
+    return _lowPower;
+  }
+
+ protected:
+  void handle(const std::string& command) override;
+
+ private:
+  void send(const std::string& name, const std::string& value, bool hex,
+            bool confirmed);
+};
+
+/**
+ * @brief A simulated MultiTech mDOT
+ */
+class FakeMDOT : public FakeModem {
+ public:
+  FakeMDOT();
+
+ protected:
+  void handle(const std::string& command) override;
+
+ private:
+  void ok(const std::string& value = "");
+  void send(const std::string& payload, bool linkCheck);
+};
+
+#if defined(LORA_AT_MDOT)
+typedef FakeMDOT FakeModule;
+#elif defined(LORA_AT_WIOE5) || defined(LORA_AT_LORAE5)
+typedef FakeWioE5 FakeModule;
+#endif
+
+#endif  // EXTRAS_HOSTTESTS_FAKEMODEM_H_
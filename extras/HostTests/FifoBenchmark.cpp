@@ -0,0 +1,120 @@
+/**
+ * @file       FifoBenchmark.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Prints how many bytes a microsecond of host time pass through the
+ * FIFO and through the FIFO as it was before the span functions and the
+ * power-of-two wrap, after checking that every byte comes out in order.
+ *
+ * Each run moves the same stream of bytes through a buffer of 256 positions,
+ * where the wrap is a mask, and of 250 positions, where it isn't: one item at
+ * a time, copied through a buffer on the stack with the bulk put() and get(),
+ * and, on the new FIFO only, written and read in place with reserve() /
+ * commit() and peek(int&) / consume().
+ */
+
+#include <chrono>
+
+#include "HostTest.h"
+#include "OldTinyGsmFifo.h"
+#include "TinyGsmFifo.h"
+
+static const int      CHUNK = 37;  // bytes a turn; not a divisor of the size
+static const uint32_t TOTAL = CHUNK * (1UL << 19);  // bytes through each FIFO
+
+// The byte at a position in the stream
+static inline uint8_t byteAt(uint32_t i) {
+  return static_cast<uint8_t>(i * 31 + 7);
+}
+
+// A checksum that depends on the order of the bytes
+static inline uint32_t mix(uint32_t sum, uint8_t c) {
+  return sum * 33 + c;
+}
+
+static uint32_t expectedSum() {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < TOTAL; i++) { sum = mix(sum, byteAt(i)); }
+  return sum;
+}
+
+// One item at a time
+template <class F>
+static uint32_t singleTurn(F& fifo, uint32_t& next, uint32_t sum) {
+  for (int i = 0; i < CHUNK; i++) { fifo.put(byteAt(next++)); }
+  uint8_t c;
+  while (fifo.get(&c)) { sum = mix(sum, c); }
+  return sum;
+}
+
+// Copied through a buffer on the stack with the bulk put() and get()
+template <class F>
+static uint32_t bulkTurn(F& fifo, uint32_t& next, uint32_t sum) {
+  uint8_t buf[CHUNK];
+  for (int i = 0; i < CHUNK; i++) { buf[i] = byteAt(next++); }
+  fifo.put(buf, CHUNK);
+  int got = fifo.get(buf, CHUNK);
+  for (int i = 0; i < got; i++) { sum = mix(sum, buf[i]); }
+  return sum;
+}
+
+// Written and read in place; only the new FIFO can do this
+template <class F>
+static uint32_t spanTurn(F& fifo, uint32_t& next, uint32_t sum) {
+  int left = CHUNK;
+  while (left) {
+    int      room;
+    uint8_t* span = fifo.reserve(room);
+    if (room > left) { room = left; }
+    for (int i = 0; i < room; i++) { span[i] = byteAt(next++); }
+    fifo.commit(room);
+    left -= room;
+  }
+  for (;;) {
+    int            count;
+    const uint8_t* span = fifo.peek(count);
+    if (!count) { break; }
+    for (int i = 0; i < count; i++) { sum = mix(sum, span[i]); }
+    fifo.consume(count);
+  }
+  return sum;
+}
+
+// Moves the whole stream through a FIFO and prints the bytes a microsecond
+template <class F, class Turn>
+static void run(const char* fifoName, const char* modeName, Turn oneTurn,
+                uint32_t expected) {
+  F        fifo;
+  uint32_t next  = 0;
+  uint32_t sum   = 0;
+  auto     start = std::chrono::steady_clock::now();
+  while (next < TOTAL) { sum = oneTurn(fifo, next, sum); }
+  double micros = std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+  printf("%-8s %-16s %10.1f\n", fifoName, modeName, TOTAL / micros);
+  CHECK_EQUAL(expected, sum);
+  CHECK_EQUAL(TOTAL, next);
+}
+
+template <unsigned N>
+static void runSize(const char* oldName, const char* newName,
+                    uint32_t expected) {
+  typedef OldTinyGsmFifo<uint8_t, N> Old;
+  typedef TinyGsmFifo<uint8_t, N>    New;
+  run<Old>(oldName, "one at a time", singleTurn<Old>, expected);
+  run<New>(newName, "one at a time", singleTurn<New>, expected);
+  run<Old>(oldName, "bulk", bulkTurn<Old>, expected);
+  run<New>(newName, "bulk", bulkTurn<New>, expected);
+  run<New>(newName, "spans", spanTurn<New>, expected);
+}
+
+int main() {
+  uint32_t expected = expectedSum();
+  printf("%-8s %-16s %10s\n", "fifo", "path", "bytes/us");
+  runSize<256>("old 256", "new 256", expected);
+  runSize<250>("old 250", "new 250", expected);
+  return hostTestResult("FifoBenchmark");
+}
@@ -0,0 +1,110 @@
+/**
+ * @file       FifoStressTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Runs a producer and a consumer thread through a single-producer/
+ * single-consumer TinyGsmFifo and checks that every item arrives once, in
+ * order and intact.
+ */
+
+#include <thread>
+
+#include "HostTest.h"
+#include "TinyGsmFifo.h"
+
+static const uint32_t ITEMS = 4000000UL;
+
+// The producer mixes single puts, bulk puts and writes into reserved spans;
+// the consumer mixes single gets, bulk gets and reads from peeked spans.
+template <class T, unsigned N>
+static void stress(const char* name) {
+  TinyGsmFifo<T, N, true> fifo;
+
+  std::thread producer([&fifo]() {
+    uint32_t next = 0;
+    while (next < ITEMS) {
+      uint32_t before = next;
+      uint32_t left   = ITEMS - next;
+      switch (next % 3) {
+        case 0: {
+          if (fifo.put(static_cast<T>(next))) { next++; }
+          break;
+        }
+        case 1: {
+          T   items[5];
+          int n = left < 5 ? left : 5;
+          for (int i = 0; i < n; i++) { items[i] = static_cast<T>(next + i); }
+          next += fifo.put(items, n);
+          break;
+        }
+        default: {
+          int n;
+          T*  span = fifo.reserve(n);
+          if (static_cast<uint32_t>(n) > left) { n = left; }
+          if (n > 7) { n = 7; }
+          for (int i = 0; i < n; i++) { span[i] = static_cast<T>(next + i); }
+          fifo.commit(n);
+          next += n;
+          break;
+        }
+      }
+      if (next == before) { std::this_thread::yield(); }
+    }
+  });
+
+  uint32_t expected = 0;
+  uint32_t wrong    = 0;
+  while (expected < ITEMS) {
+    uint32_t before = expected;
+    switch (expected % 3) {
+      case 0: {
+        T item;
+        if (fifo.get(&item)) {
+          if (item != static_cast<T>(expected)) { wrong++; }
+          expected++;
+        }
+        break;
+      }
+      case 1: {
+        T   items[6];
+        int n = fifo.get(items, 6);
+        for (int i = 0; i < n; i++) {
+          if (items[i] != static_cast<T>(expected + i)) { wrong++; }
+        }
+        expected += n;
+        break;
+      }
+      default: {
+        int      n;
+        const T* span = fifo.peek(n);
+        for (int i = 0; i < n; i++) {
+          if (span[i] != static_cast<T>(expected + i)) { wrong++; }
+        }
+        fifo.consume(n);
+        expected += n;
+        break;
+      }
+    }
+    if (expected == before) { std::this_thread::yield(); }
+  }
+  producer.join();
+
+  printf("%-24s %lu items, %lu wrong\n", name,
+         static_cast<unsigned long>(expected),
+         static_cast<unsigned long>(wrong));
+  CHECK_EQUAL(ITEMS, expected);
+  CHECK_EQUAL(0, wrong);
+  CHECK(!fifo.readable());
+}
+
+int main() {
+  // byte positions wrapped with a mask, int positions wrapped with a compare
+  // and byte positions wrapped with a compare
+  stress<uint8_t, 256>("uint8_t x 256");
+  stress<uint32_t, 64>("uint32_t x 64");
+  stress<uint32_t, 1000>("uint32_t x 1000");
+  stress<uint16_t, 255>("uint16_t x 255");
+  return hostTestResult("FifoStressTest");
+}
@@ -0,0 +1,92 @@
+/**
+ * @file       FileStorage.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Storage for a store-and-forward queue in a file on the host, which
+ * can be made to lose power part way through a write.
+ */
+
+#ifndef EXTRAS_HOSTTESTS_FILESTORAGE_H_
+#define EXTRAS_HOSTTESTS_FILESTORAGE_H_
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "LoRa_AT_Store.h"
+
+/**
+ * @brief A LoRa_AT_Storage kept in a file, with each sync() flushed to disk.
+ *
+ * After powerCut(bytes), only that many more bytes are written; the write
+ * that crosses the limit is torn and every later write is lost, as if the
+ * board lost power. Open the file again with a new object to see what
+ * survived.
+ */
+class FileStorage : public LoRa_AT_Storage {
+ public:
+  /**
+   * @brief Open a storage file, creating it filled with 0xFF if it doesn't
+   * exist or is the wrong size.
+   *
+   * @param path The path of the file
+   * @param size The size of the storage
+   */
+  FileStorage(const char* path, uint32_t size) : _size(size), _left(-1) {
+    _file = fopen(path, "r+b");
+    if (_file) {
+      fseek(_file, 0, SEEK_END);
+      if (static_cast<uint32_t>(ftell(_file)) != size) {
+        fclose(_file);
+        _file = nullptr;
+      }
+    }
+    if (!_file) {
+      _file = fopen(path, "w+b");
+      for (uint32_t i = 0; _file && i < size; i++) { fputc(0xFF, _file); }
+      sync();
+    }
+  }
+  ~FileStorage() {
+    if (_file) { fclose(_file); }
+  }
+
+  /// @brief Lose power after this many more bytes are written
+  void powerCut(long bytes) {
+    _left = bytes;
+  }
+  /// @brief Whether the power has been cut
+  bool powerLost() const {
+    return _left == 0;
+  }
+
+  uint32_t size() override {
+    return _file ? _size : 0;
+  }
+  bool read(uint32_t addr, uint8_t* buf, size_t len) override {
+    if (!_file || addr + len > _size) { return false; }
+    fseek(_file, addr, SEEK_SET);
+    return fread(buf, 1, len, _file) == len;
+  }
+  bool write(uint32_t addr, const uint8_t* buf, size_t len) override {
+    if (!_file || addr + len > _size || powerLost()) { return false; }
+    size_t n = len;
+    if (_left > 0 && static_cast<size_t>(_left) < n) { n = _left; }
+    fseek(_file, addr, SEEK_SET);
+    bool ok = fwrite(buf, 1, n, _file) == n;
+    if (_left > 0) { _left -= n; }
+    return ok && n == len;
+  }
+  bool sync() override {
+    if (!_file || powerLost()) { return false; }
+    return fflush(_file) == 0 && fsync(fileno(_file)) == 0;
+  }
+
+ private:
+  FILE*    _file;
+  uint32_t _size;
+  long     _left;
+};
+
+#endif  // EXTRAS_HOSTTESTS_FILESTORAGE_H_
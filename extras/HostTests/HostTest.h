@@ -0,0 +1,130 @@
+/**
+ * @file       HostTest.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks and measurements shared by the host tests and benchmarks.
+ */
+
+#ifndef EXTRAS_HOSTTESTS_HOSTTEST_H_
+#define EXTRAS_HOSTTESTS_HOSTTEST_H_
+
+#include <Arduino.h>
+
+#include <stdio.h>
+
+#include "FakeModem.h"
+
+static int host_test_failures = 0;
+
+/**
+ * @brief Check a condition, printing where it failed and carrying on.
+ */
+#define CHECK(condition)                                                 \
+  do {                                                                   \
+    if (!(condition)) {                                                  \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      host_test_failures++;                                              \
+    }                                                                    \
+  } while (0)
+
+/**
+ * @brief Check that two integers are equal, printing both if they aren't.
+ */
+#define CHECK_EQUAL(expected, actual)                                    \
+  do {                                                                   \
+    long long e_ = static_cast<long long>(expected);                     \
+    long long a_ = static_cast<long long>(actual);                       \
+    if (e_ != a_) {                                                      \
+      printf("%s:%d: CHECK_EQUAL(%s, %s) failed: %lld != %lld\n",        \
+             __FILE__, __LINE__, #expected, #actual, e_, a_);            \
+      host_test_failures++;                                              \
+    }                                                                    \
+  } while (0)
+
+/**
+ * @brief Print the result of the test and get the exit code for ctest.
+ *
+ * @param name The name of the test
+ * @return 0 if every check passed
+ */
+inline int hostTestResult(const char* name) {
+  if (host_test_failures) {
+    printf("%s: %d checks FAILED\n", name, host_test_failures);
+    return 1;
+  }
+  printf("%s: OK\n", name);
+  return 0;
+}
+
+/**
+ * @brief Measures what one library call costs: time on the device, AT
+ * commands and bytes on the serial port, and radio use.
+ *
+ * @code{.cpp}
+ * HostMeasurement::printHeader();
+ * HostMeasurement call(fake);
+ * modem.getPort();
+ * call.print("getPort");
+ * @endcode
+ */
+class HostMeasurement {
+ public:
+  explicit HostMeasurement(FakeModem& modem) : _modem(modem) {
+    restart();
+  }
+
+  /// @brief Start measuring again from now
+  void restart() {
+    _start = hostMicros();
+    _stats = _modem.stats;
+  }
+
+  /// @brief Virtual time on the device since the start, in milliseconds
+  uint32_t deviceMillis() const {
+    return static_cast<uint32_t>((hostMicros() - _start) / 1000);
+  }
+  /// @brief AT commands sent since the start
+  uint32_t commands() const {
+    return _modem.stats.commands - _stats.commands;
+  }
+  /// @brief Bytes written to and read from the module since the start
+  uint32_t serialBytes() const {
+    return _modem.stats.bytesWritten - _stats.bytesWritten +
+        _modem.stats.bytesRead - _stats.bytesRead;
+  }
+  /// @brief Frames sent over the air since the start
+  uint32_t uplinks() const {
+    return _modem.stats.uplinks - _stats.uplinks;
+  }
+  /// @brief Milliseconds on air since the start
+  uint32_t airtime() const {
+    return _modem.stats.airtime - _stats.airtime;
+  }
+
+  /// @brief Print the column names for print()
+  static void printHeader() {
+    printf("%-36s %10s %6s %8s %8s %8s %10s\n", "call", "device ms", "AT",
+           "tx bytes", "rx bytes", "uplinks", "airtime ms");
+  }
+  /// @brief Print one row of measurements
+  void print(const char* name) const {
+    printf("%-36s %10lu %6lu %8lu %8lu %8lu %10lu\n", name,
+           static_cast<unsigned long>(deviceMillis()),
+           static_cast<unsigned long>(commands()),
+           static_cast<unsigned long>(_modem.stats.bytesWritten -
+                                      _stats.bytesWritten),
+           static_cast<unsigned long>(_modem.stats.bytesRead -
+                                      _stats.bytesRead),
+           static_cast<unsigned long>(uplinks()),
+           static_cast<unsigned long>(airtime()));
+  }
+
+ private:
+  FakeModem&       _modem;
+  uint64_t         _start;
+  FakeModem::Stats _stats;
+};
+
+#endif  // EXTRAS_HOSTTESTS_HOSTTEST_H_
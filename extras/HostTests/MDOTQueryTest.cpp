@@ -0,0 +1,157 @@
+/**
+ * @file       MDOTQueryTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks that the mDOT asks for the uplink space during a send and for
+ * the wait for a free channel between join attempts without waiting on the
+ * answers, and that a send fails when the answer never comes, is an error or
+ * isn't a number.
+ */
+
+#include <LoRa_AT.h>
+
+#include <string>
+
+#include "HostTest.h"
+
+static const char TEST_APP_EUI[] = "8A598335072D2776";
+static const char TEST_APP_KEY[] = "DD8F3881F180151C739534C4EC56216F";
+static const char TEST_DEV_EUI[] = "15C3202192A4504A";
+
+// The query being answered, the answer the module gives to it, and how long
+// after the number the OK comes
+static std::string query;
+static std::string query_answer;
+static uint32_t    ok_delay = 0;
+// When the query and the last join request were heard
+static uint32_t query_heard = 0;
+static uint32_t join_heard  = 0;
+
+static bool answerQuery(FakeModem& modem, const std::string& command) {
+  if (command.compare(0, 7, "AT+JOIN") == 0) { join_heard = millis(); }
+  if (command != query) { return false; }
+  query_heard = millis();
+  if (query_answer.empty()) { return true; }  // never answer
+  modem.reply(query_answer, modem.latency);
+  if (ok_delay) { modem.reply("\r\nOK\r\n", modem.latency + ok_delay); }
+  return true;
+}
+
+// Sends a message to the end, returning the final status and the longest a
+// single poll took in device time
+static LoRa_AT_SendStatus sendAll(LoRa_AT& modem, const uint8_t* data,
+                                  size_t len, uint32_t* longest) {
+  *longest = 0;
+  if (!modem.beginSend(data, len)) { return LORA_AT_SEND_FAILED; }
+  bool busy = true;
+  while (busy) {
+    uint32_t start = millis();
+    busy           = modem.poll();
+    if (millis() - start > *longest) { *longest = millis() - start; }
+  }
+  return modem.sendStatus();
+}
+
+// Joins with one failed attempt, returning whether it joined and the longest
+// a single poll took
+static bool joinOnceFailed(LoRa_AT& modem, FakeModem& fake,
+                           uint32_t* longest) {
+  fake.joinFailures = 1;
+  *longest          = 0;
+  if (!modem.beginJoinOTAA(TEST_APP_EUI, TEST_APP_KEY, TEST_DEV_EUI, 3,
+                           1000L)) {
+    return false;
+  }
+  bool busy = true;
+  while (busy) {
+    uint32_t start = millis();
+    busy           = modem.poll();
+    if (millis() - start > *longest) { *longest = millis() - start; }
+  }
+  return modem.joinStatus() == LORA_AT_JOIN_JOINED;
+}
+
+int main() {
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+  LoRaStream loraStream(modem);
+
+  uint32_t longest;
+  fake.script = answerQuery;
+
+  // the next attempt of a failed join waits for a free channel, asked for
+  // without waiting on the OK
+  query        = "AT+TXN?";
+  query_answer = "\r\n5000\r\n";
+  ok_delay     = 500;
+  fake.resetStats();
+  CHECK(joinOnceFailed(modem, fake, &longest));
+  CHECK_EQUAL(1, fake.count("AT+TXN?"));
+  CHECK_EQUAL(2, fake.stats.joinAttempts);
+  CHECK(join_heard - query_heard > 5000);
+  CHECK(longest < ok_delay);
+
+  // without an answer, only the backoff is waited
+  query_answer = "";
+  fake.resetStats();
+  CHECK(joinOnceFailed(modem, fake, &longest));
+  CHECK_EQUAL(2, fake.stats.joinAttempts);
+  CHECK(join_heard - query_heard > 1000);
+  CHECK(join_heard - query_heard < 5000);
+  CHECK(longest < 1000);
+
+  uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  query           = "AT+TXS?";
+
+  // the OK comes long after the number; no poll waits for it
+  query_answer = "\r\n11\r\n";
+  ok_delay     = 500;
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_DONE, sendAll(modem, data, sizeof(data), &longest));
+  CHECK_EQUAL(1, fake.count("AT+TXS?"));
+  CHECK_EQUAL(1, fake.stats.uplinks);
+  CHECK_EQUAL(sizeof(data), fake.stats.uplinkBytes);
+  CHECK(longest < ok_delay);
+  ok_delay = 0;
+
+  // no answer at all
+  query_answer = "";
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_FAILED,
+              sendAll(modem, data, sizeof(data), &longest));
+  CHECK_EQUAL(1, fake.count("AT+TXS?"));
+  CHECK_EQUAL(0, fake.count("AT+SEND"));
+  CHECK_EQUAL(0, fake.stats.uplinks);
+
+  // an error
+  query_answer = "\r\nERROR\r\n";
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_FAILED,
+              sendAll(modem, data, sizeof(data), &longest));
+  CHECK_EQUAL(0, fake.count("AT+SEND"));
+
+  // something other than a number
+  query_answer = "\r\nbusy\r\n\r\nOK\r\n";
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_FAILED,
+              sendAll(modem, data, sizeof(data), &longest));
+  CHECK_EQUAL(0, fake.count("AT+SEND"));
+
+  // a count of 0 still flushes the MAC answers with an empty uplink
+  query_answer = "\r\n0\r\n\r\nOK\r\n";
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_FAILED,
+              sendAll(modem, data, sizeof(data), &longest));
+  CHECK(fake.count("AT+SEND") > 0);
+  CHECK_EQUAL(0, fake.stats.uplinkBytes);
+
+  // and the next send works again
+  fake.script = nullptr;
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_DONE, sendAll(modem, data, sizeof(data), &longest));
+  CHECK_EQUAL(sizeof(data), fake.stats.uplinkBytes);
+
+  return hostTestResult("MDOTQueryTest");
+}
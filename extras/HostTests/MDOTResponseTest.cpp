@@ -0,0 +1,98 @@
+/**
+ * @file       MDOTResponseTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Feeds recorded mDOT responses to sends and link checks through the
+ * response reader and checks what reaches the receive buffer.
+ */
+
+#include <LoRa_AT.h>
+
+#include <string>
+
+#include "HostTest.h"
+
+typedef TinyGsmFifo<uint8_t, 64> Fifo;
+typedef TinyGsmFifo<uint8_t, 16> SmallFifo;
+
+// The line breaks before a downlink, and the end of every response
+#define LEAD "\r\r\n\r\r\n"
+#define TAIL "\r\n\r\nOK\r\n"
+
+// Reads a whole response, returning the payload length the reader gives
+template <class F>
+static size_t feed(LoRa_AT_mDOTResponse<F>& response, F& fifo,
+                   const std::string& text, bool linkCheck = false) {
+  response.begin(&fifo, linkCheck);
+  for (char c : text) { response.append(c); }
+  return response.finish();
+}
+
+// Takes everything out of the buffer
+template <class F>
+static std::string drain(F& fifo) {
+  std::string out;
+  uint8_t     c;
+  while (fifo.get(&c, 1) == 1) { out += static_cast<char>(c); }
+  return out;
+}
+
+int main() {
+  Fifo                       fifo;
+  LoRa_AT_mDOTResponse<Fifo> response;
+  const std::string          binary("\r\n\x00\x0D\x0A\r", 6);
+
+  // no downlink, with and without the lead
+  CHECK_EQUAL(0, feed(response, fifo, TAIL));
+  CHECK_EQUAL(0, feed(response, fifo, LEAD TAIL));
+  CHECK_EQUAL(0, fifo.size());
+
+  // a text downlink
+  CHECK_EQUAL(5, feed(response, fifo, LEAD "hello" TAIL));
+  CHECK(drain(fifo) == "hello");
+
+  // a payload that starts with a line break and holds an OK and a blank line
+  std::string tricky = "\r\nOK\r\n\r\nX";
+  CHECK_EQUAL(tricky.size(), feed(response, fifo, LEAD + tricky + TAIL));
+  CHECK(drain(fifo) == tricky);
+
+  // a binary payload starting with a carriage return and line feed
+  CHECK_EQUAL(binary.size() + 1,
+              feed(response, fifo, LEAD + binary + "Z" + TAIL));
+  CHECK(drain(fifo) == binary + "Z");
+
+  // a link check without a downlink
+  CHECK_EQUAL(0, feed(response, fifo, "\r\n13,2\r\n\r\nOK\r\n", true));
+  CHECK(response.hasLinkCheck());
+  CHECK_EQUAL(13, response.linkMargin());
+  CHECK_EQUAL(2, response.gatewayCount());
+  CHECK_EQUAL(0, fifo.size());
+
+  // a link check with a downlink
+  CHECK_EQUAL(4, feed(response, fifo, "\r\n7,1\r\n" LEAD "\nabc" TAIL, true));
+  CHECK_EQUAL(7, response.linkMargin());
+  CHECK_EQUAL(1, response.gatewayCount());
+  CHECK(drain(fifo) == "\nabc");
+
+  // a link check that didn't get an answer
+  feed(response, fifo, "\r\nOK\r\n", true);
+  CHECK(!response.hasLinkCheck());
+
+  // a payload bigger than the buffer keeps what fits and counts the rest
+  SmallFifo                       small;
+  LoRa_AT_mDOTResponse<SmallFifo> smallResponse;
+  int                             room = small.free();
+  std::string                     big(40, 'b');
+  big[0] = '\r';
+  CHECK_EQUAL(big.size(), feed(smallResponse, small, LEAD + big + TAIL));
+  CHECK_EQUAL(room, small.size());
+  CHECK(drain(small) == big.substr(0, room));
+
+  // the next response starts again with an empty buffer
+  CHECK_EQUAL(2, feed(smallResponse, small, LEAD "ok" TAIL));
+  CHECK(drain(small) == "ok");
+
+  return hostTestResult("MDOTResponseTest");
+}
@@ -0,0 +1,123 @@
+/**
+ * @file       MatcherBenchmark.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Prints how many bytes a microsecond of host time the response
+ * matcher gets through, on its own and inside waitResponse(), over a long
+ * module transcript.
+ *
+ * The transcript is replayed from memory rather than from the simulated
+ * module, so the time is the library's alone.
+ */
+
+#include <LoRa_AT.h>
+
+#include <chrono>
+#include <string>
+
+#include "HostTest.h"
+
+static const int ROUNDS = 200;
+
+/**
+ * @brief A stream that plays the same text over and over.
+ */
+class ReplayStream : public Stream {
+ public:
+  explicit ReplayStream(const std::string& text) : _text(text), _pos(0) {}
+
+  /// @brief Start the text again from the beginning
+  void rewind() {
+    _pos = 0;
+  }
+
+  int available() override {
+    return static_cast<int>(_text.size() - _pos);
+  }
+  int read() override {
+    return _pos < _text.size() ? static_cast<uint8_t>(_text[_pos++]) : -1;
+  }
+  int peek() override {
+    return _pos < _text.size() ? static_cast<uint8_t>(_text[_pos]) : -1;
+  }
+  size_t write(uint8_t) override {
+    return 1;
+  }
+  using Print::write;
+
+ private:
+  const std::string& _text;
+  size_t             _pos;
+};
+
+// Lines a module prints that aren't the response being waited for
+static std::string transcript() {
+  std::string text;
+  for (int i = 0; i < 64; i++) {
+    text += "+MSG: Start\r\n+MSG: FPENDING\r\n";
+    text += "+MSG: RXWIN1, RSSI -97, SNR 6\r\n";
+    text += "+MSG: PORT: 2; RX: \"48656C6C6F\"\r\n2E6B3C1F0A9D4E55\r\n";
+  }
+  return text + AT_OK AT_NL;
+}
+
+static double microsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+static void print(const char* name, size_t bytes, double micros) {
+  printf("%-36s %10.1f\n", name, bytes / micros);
+}
+
+// Pushes the transcript through a matcher and prints the bytes a microsecond
+static void pushBench(const char* name, const std::string& text,
+                      LoRa_AT_ResponseMatcher& matcher) {
+  int8_t index = 0;
+  auto   start = std::chrono::steady_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    matcher.clear();
+    for (char c : text) { index = matcher.push(c); }
+  }
+  print(name, text.size() * ROUNDS, microsSince(start));
+  CHECK_EQUAL(1, index);
+}
+
+int main() {
+  std::string  text = transcript();
+  ReplayStream stream(text);
+  LoRa_AT      modem(stream);
+  LoRaStream   loraStream(modem);  // takes the downlinks in the transcript
+
+  printf("%-36s %10s\n", "matching", "bytes/us");
+
+  LoRa_AT_ResponseMatcher two(GFP(LORA_OK), GFP(LORA_ERROR));
+  pushBench("push, OK and ERROR", text, two);
+  LoRa_AT_ResponseMatcher seven(GFP(LORA_OK), GFP(LORA_ERROR), "+JOIN: Done",
+                                "+MSG: Done", "Network Not Joined",
+                                "+CMSGHEX: Done", "Failed to join network");
+  pushBench("push, seven responses", text, seven);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    stream.rewind();
+    CHECK_EQUAL(1, modem.waitResponse(1000L));
+  }
+  print("waitResponse()", text.size() * ROUNDS, microsSince(start));
+
+  static char            collected[LORA_AT_RX_BUFFER];
+  LoRa_AT_ResponseBuffer buffer(collected, sizeof(collected));
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    stream.rewind();
+    buffer.clear();
+    CHECK_EQUAL(1, modem.waitResponse(1000L, buffer));
+  }
+  print("waitResponse() into a buffer", text.size() * ROUNDS,
+        microsSince(start));
+
+  return hostTestResult("MatcherBenchmark");
+}
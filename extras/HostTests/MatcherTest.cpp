@@ -0,0 +1,92 @@
+/**
+ * @file       MatcherTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks which response the matcher reports when several could match,
+ * and that a response too long for the match window is refused at once
+ * instead of being waited for.
+ */
+
+#include <LoRa_AT.h>
+
+#include <string>
+
+#include "HostTest.h"
+
+// Pushes text through the matcher, returning the first index it reports and
+// where in the text it reported it
+static int8_t pushAll(LoRa_AT_ResponseMatcher& matcher, const std::string& text,
+                      size_t* at = nullptr) {
+  for (size_t i = 0; i < text.size(); i++) {
+    int8_t index = matcher.push(text[i]);
+    if (index) {
+      if (at) { *at = i + 1; }
+      return index;
+    }
+  }
+  return 0;
+}
+
+int main() {
+  // when two responses end together, the one listed first is reported
+  LoRa_AT_ResponseMatcher longFirst("+JOIN: Done", "Done");
+  CHECK_EQUAL(1, pushAll(longFirst, "\r\n+JOIN: Done"));
+  LoRa_AT_ResponseMatcher shortFirst("Done", "+JOIN: Done");
+  CHECK_EQUAL(1, pushAll(shortFirst, "\r\n+JOIN: Done"));
+
+  // a response inside a longer one is reported as soon as it ends
+  size_t                  at = 0;
+  LoRa_AT_ResponseMatcher inside("ERROR(-1)", "ERROR");
+  CHECK_EQUAL(2, pushAll(inside, "+MSG: ERROR(-1)", &at));
+  CHECK_EQUAL(sizeof("+MSG: ERROR") - 1, at);
+
+  // overlapping responses sharing their last character
+  LoRa_AT_ResponseMatcher shared("NOK", "OK");
+  CHECK_EQUAL(2, pushAll(shared, "\r\nOK"));
+  shared.clear();
+  CHECK_EQUAL(1, pushAll(shared, "\r\nNOK"));
+
+  // the index is the position in the argument list, skipping null responses
+  LoRa_AT_ResponseMatcher gaps(nullptr, "two", nullptr, nullptr, nullptr,
+                               nullptr, "seven");
+  CHECK_EQUAL(7, pushAll(gaps, "six seven"));
+  gaps.clear();
+  CHECK_EQUAL(2, pushAll(gaps, "one two"));
+
+  // a match across the end of the ring
+  LoRa_AT_ResponseMatcher wrapped("OK\r\n");
+  CHECK_EQUAL(0, pushAll(wrapped, std::string(LORA_AT_MATCH_WINDOW - 2, 'x')));
+  CHECK_EQUAL(1, pushAll(wrapped, "OK\r\n"));
+
+  // the longest response that fits the window
+  std::string             fits(LORA_AT_MATCH_WINDOW, 'f');
+  LoRa_AT_ResponseMatcher full(fits.c_str());
+  CHECK(full.valid());
+  CHECK_EQUAL(1, pushAll(full, "xx" + fits));
+
+  // one that doesn't, even alongside responses that do
+  std::string             tooLong(LORA_AT_MATCH_WINDOW + 1, 't');
+  LoRa_AT_ResponseMatcher over("OK", tooLong.c_str());
+  CHECK(!over.valid());
+
+  // waiting for it gives up at once, instead of after the timeout
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+  fake.reply(tooLong + AT_NL AT_OK AT_NL, 10);
+  uint32_t start = millis();
+  CHECK_EQUAL(0, modem.waitResponse(10000L, tooLong.c_str()));
+  CHECK(millis() - start < 10);
+  char                   text[16];
+  LoRa_AT_ResponseBuffer buffer(text, sizeof(text));
+  CHECK_EQUAL(0, modem.waitResponse(10000L, buffer, GFP(LORA_OK),
+                                    tooLong.c_str()));
+  CHECK(millis() - start < 10);
+  CHECK_EQUAL(0, buffer.length());
+
+  // and the reply is still there for the next wait
+  CHECK_EQUAL(1, modem.waitResponse(1000L));
+
+  return hostTestResult("MatcherTest");
+}
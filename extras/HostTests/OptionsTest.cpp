@@ -0,0 +1,116 @@
+/**
+ * @file       OptionsTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks that send options only change the message they are given
+ * with, and that only the setting writes the module accepts are counted.
+ */
+
+#include <LoRa_AT.h>
+
+#include "HostTest.h"
+
+static const char TEST_APP_EUI[] = "8A598335072D2776";
+static const char TEST_APP_KEY[] = "DD8F3881F180151C739534C4EC56216F";
+static const char TEST_DEV_EUI[] = "15C3202192A4504A";
+
+// Makes the module refuse every port
+static bool refusePort(FakeModem& modem, const std::string& command) {
+#if defined(LORA_AT_MDOT)
+  if (command.compare(0, 6, "AT+AP=") != 0) { return false; }
+  modem.reply("\r\nERROR\r\n", modem.latency);
+#else
+  if (command.compare(0, 8, "AT+PORT=") != 0) { return false; }
+  modem.reply("+PORT: ERROR(-1)\r\n", modem.latency);
+#endif
+  return true;
+}
+
+// Sends a message to the end, returning true if it was sent
+static bool sendAll(LoRa_AT& modem, const uint8_t* data, size_t len,
+                    const LoRa_AT_SendOptions& options) {
+  if (!modem.beginSend(data, len, options)) { return false; }
+  while (modem.poll()) {}
+  return modem.sendStatus() == LORA_AT_SEND_DONE;
+}
+static bool sendAll(LoRa_AT& modem, const uint8_t* data, size_t len) {
+  if (!modem.beginSend(data, len)) { return false; }
+  while (modem.poll()) {}
+  return modem.sendStatus() == LORA_AT_SEND_DONE;
+}
+
+int main() {
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+  LoRaStream loraStream(modem);
+
+  CHECK(modem.joinOTAA(TEST_APP_EUI, TEST_APP_KEY, TEST_DEV_EUI, 3, 1000L));
+  CHECK(modem.setPort(5));
+  modem.requireConfirmation(false);
+
+  uint8_t data[8];
+  for (uint8_t i = 0; i < sizeof(data); i++) { data[i] = i; }
+
+  // a confirmed message on its own port
+  fake.resetStats();
+  CHECK(sendAll(modem, data, sizeof(data), LoRa_AT_SendOptions(true, 2, 9)));
+  CHECK_EQUAL(9, fake.port);
+#if defined(LORA_AT_MDOT)
+  CHECK_EQUAL(2, fake.retries);
+#else
+  CHECK_EQUAL(1, fake.count("AT+CMSGHEX="));
+  CHECK_EQUAL(2, fake.retries);
+#endif
+
+  // ... leaves the settings for every other message alone
+  CHECK(!modem.isConfirmationRequired());
+  CHECK_EQUAL(5, modem.getPort());
+  fake.resetStats();
+  CHECK(sendAll(modem, data, sizeof(data)));
+  CHECK_EQUAL(5, fake.port);
+#if defined(LORA_AT_MDOT)
+  CHECK_EQUAL(0, fake.retries);
+#else
+  CHECK_EQUAL(1, fake.count("AT+MSGHEX="));
+  CHECK_EQUAL(0, fake.count("AT+CMSGHEX="));
+#endif
+
+  // the same through the stream
+  fake.resetStats();
+  CHECK_EQUAL(sizeof(data), loraStream.write(data, sizeof(data)));
+  CHECK_EQUAL(1, fake.stats.uplinks);
+  CHECK_EQUAL(0, fake.count("AT+PORT=") + fake.count("AT+AP="));
+
+  // a confirmed message that asks for no retries; the mDOT can't turn off
+  // the retries without turning off confirmation, so it makes one
+  CHECK(sendAll(modem, data, sizeof(data), LoRa_AT_SendOptions(true, 0)));
+  CHECK_EQUAL(5, fake.port);
+#if defined(LORA_AT_MDOT)
+  CHECK_EQUAL(1, fake.retries);
+#else
+  CHECK_EQUAL(0, fake.retries);
+#endif
+
+  // only the writes the module accepts are counted
+  modem.resetSettingWrites();
+  fake.script = refusePort;
+  CHECK(!modem.setPort(7));
+  CHECK_EQUAL(0, modem.settingWrites());
+  CHECK_EQUAL(0, modem.settingWritesAvoided());
+  fake.script = nullptr;
+  CHECK(modem.setPort(7));
+  CHECK(modem.setPort(7));
+  CHECK_EQUAL(1, modem.settingWrites());
+  CHECK_EQUAL(1, modem.settingWritesAvoided());
+
+  // a message on the port it would have had anyway writes no port
+  fake.resetStats();
+  CHECK(sendAll(modem, data, sizeof(data), LoRa_AT_SendOptions(false, -1, 7)));
+  CHECK(sendAll(modem, data, sizeof(data)));
+  CHECK_EQUAL(7, fake.port);
+  CHECK_EQUAL(0, fake.count("AT+PORT=") + fake.count("AT+AP="));
+
+  return hostTestResult("OptionsTest");
+}
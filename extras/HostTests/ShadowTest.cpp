@@ -0,0 +1,69 @@
+/**
+ * @file       ShadowTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks that the remembered module settings only hold values the
+ * module actually reported or accepted.
+ */
+
+#include <LoRa_AT.h>
+
+#include "HostTest.h"
+
+#if defined(LORA_AT_MDOT)
+static const char RETRIES_QUERY[] = "AT+ACK?";
+static const char RETRIES_WRITE[] = "AT+ACK=";
+static const char PORT_QUERY[]    = "AT+AP?";
+#else
+static const char RETRIES_QUERY[] = "AT+RETRY";
+static const char RETRIES_WRITE[] = "AT+RETRY=";
+static const char PORT_QUERY[]    = "AT+PORT";
+#endif
+
+// Makes the module ignore the queries of the confirmation retries and port
+static bool ignoreQueries(FakeModem&, const std::string& command) {
+  return command == RETRIES_QUERY || command == PORT_QUERY;
+}
+
+int main() {
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+
+  // a query that times out isn't remembered ...
+  fake.retries = 3;
+  fake.script  = ignoreQueries;
+  modem.getConfirmationRetries();
+  modem.getPort();
+  fake.script = nullptr;
+
+  // ... so writing what the failed read returned still reaches the module
+  fake.resetStats();
+  CHECK(modem.setConfirmationRetries(0));
+  CHECK_EQUAL(1, fake.count(RETRIES_WRITE));
+  CHECK_EQUAL(0, fake.retries);
+
+  // ... and the next read asks again
+  fake.resetStats();
+  CHECK_EQUAL(fake.port, modem.getPort());
+  CHECK_EQUAL(1, fake.count(PORT_QUERY));
+  CHECK_EQUAL(fake.port, modem.getPort());
+  CHECK_EQUAL(1, fake.count(PORT_QUERY));
+
+#if defined(LORA_AT_MDOT)
+  // turning off duty cycle on the mDOT sets its maximum to 0, which is one
+  // write that leaves both settings known
+  modem.forgetSettings();
+  modem.resetSettingWrites();
+  fake.resetStats();
+  CHECK(modem.enableDutyCycle(false));
+  CHECK_EQUAL(1, fake.count("AT+DUTY=0"));
+  CHECK_EQUAL(1, modem.settingWrites());
+  CHECK_EQUAL(0, modem.getMaxDutyCycle());
+  CHECK(!modem.isDutyCycleEnabled());
+  CHECK_EQUAL(1, fake.commands().size());
+#endif
+
+  return hostTestResult("ShadowTest");
+}
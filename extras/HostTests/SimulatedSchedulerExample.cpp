@@ -0,0 +1,32 @@
+/**
+ * @file       SimulatedSchedulerExample.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Runs the SimulatedScheduler example sketch on the host.
+ */
+
+#include "HostTest.h"
+
+#include "../../examples/SimulatedScheduler/SimulatedScheduler.ino"
+
+int main() {
+  setup();
+  for (uint8_t i = 0; i <= numPhases; i++) {
+    sim.resetStats();
+    loop();
+    // every phase sends each message at least once, and once the sketch is
+    // done further loops send nothing
+    if (i < numPhases) {
+      CHECK(sim.transmissions() >= SIM_MESSAGES);
+      // on a good link almost everything gets through
+      if (phases[i].snr > 0) {
+        CHECK(sim.delivered() * 10 >= SIM_MESSAGES * 9UL);
+      }
+    } else {
+      CHECK_EQUAL(0, sim.transmissions());
+    }
+  }
+  return hostTestResult("SimulatedSchedulerExample");
+}
@@ -0,0 +1,116 @@
+/**
+ * @file       StorePowerLossTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Cuts the power to a file-backed store-and-forward queue after every
+ * possible number of bytes written and checks that what survives is the
+ * queue from before or after the change being made, and never a damaged
+ * record.
+ */
+
+#include <vector>
+
+#include "FileStorage.h"
+#include "HostTest.h"
+
+// A modem that is always joined and takes every payload straight away
+class DrainModem {
+ public:
+  bool isJoined() {
+    return true;
+  }
+  uint32_t timeUntilSendAllowed(size_t) {
+    return 0;
+  }
+  bool beginSend(const uint8_t* buff, size_t len, bool = false) {
+    sent.push_back(std::vector<uint8_t>(buff, buff + len));
+    return true;
+  }
+  bool poll() {
+    return false;
+  }
+  LoRa_AT_SendStatus sendStatus() {
+    return LORA_AT_SEND_DONE;
+  }
+
+  std::vector<std::vector<uint8_t> > sent;
+};
+
+static const char     PATH[]  = "StorePowerLossTest.bin";
+static const uint32_t SIZE    = 28 + 160;
+static const uint16_t RECORDS = 40;
+
+// Each payload carries its number and is a length that makes the ring wrap at
+// a different place each time round
+static std::vector<uint8_t> payload(uint16_t number) {
+  std::vector<uint8_t> p(6 + number % 17, static_cast<uint8_t>(number * 7));
+  p[0] = number >> 8;
+  p[1] = number & 0xFF;
+  return p;
+}
+static uint16_t number(const std::vector<uint8_t>& p) {
+  return (p[0] << 8) | p[1];
+}
+
+// Stores the payloads until the power is cut after a number of bytes, or -1
+// to never cut it; returns how many were stored
+static uint16_t storeUntilCut(long cut) {
+  remove(PATH);
+  FileStorage                      storage(PATH, SIZE);
+  DrainModem                       modem;
+  LoRa_AT_StoreForward<DrainModem> queue(modem, storage);
+  if (!queue.begin()) { return 0; }
+  storage.powerCut(cut);
+  uint16_t stored = 0;
+  for (uint16_t i = 0; i < RECORDS; i++) {
+    std::vector<uint8_t> p = payload(i);
+    if (!queue.store(p.data(), p.size())) { break; }
+    stored++;
+  }
+  return stored;
+}
+
+int main() {
+  CHECK_EQUAL(RECORDS, storeUntilCut(-1));
+
+  // cut the power one byte later each time, until every payload is stored
+  uint32_t cuts = 0;
+  for (long cut = 0;; cut++) {
+    uint16_t done = storeUntilCut(cut);
+    if (done == RECORDS) { break; }
+    cuts++;
+
+    // power back on
+    FileStorage                      storage(PATH, SIZE);
+    DrainModem                       modem;
+    LoRa_AT_StoreForward<DrainModem> queue(modem, storage);
+    CHECK(queue.begin());
+    while (queue.maintain()) {}
+    CHECK_EQUAL(0, queue.pending());
+    CHECK_EQUAL(0, queue.dropped());
+
+    // every payload is intact, the survivors are the newest ones in order and
+    // the only one that may be missing is the one being stored at the cut
+    bool intact = true;
+    for (size_t i = 0; i < modem.sent.size(); i++) {
+      uint16_t n = number(modem.sent[i]);
+      if (modem.sent[i] != payload(n)) { intact = false; }
+      if (i && n != number(modem.sent[i - 1]) + 1) { intact = false; }
+    }
+    if (!intact) { printf("cut after %ld bytes\n", cut); }
+    CHECK(intact);
+    if (done > 0) {
+      CHECK(!modem.sent.empty());
+      if (modem.sent.empty()) { continue; }
+      uint16_t last = number(modem.sent.back());
+      CHECK(last == done - 1 || last == done);
+    }
+  }
+  remove(PATH);
+  printf("%lu power cuts\n", static_cast<unsigned long>(cuts));
+  CHECK(cuts > 0);
+
+  return hostTestResult("StorePowerLossTest");
+}
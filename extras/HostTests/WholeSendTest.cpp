@@ -0,0 +1,69 @@
+/**
+ * @file       WholeSendTest.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Checks that a buffer that must not be split is refused when it can
+ * never fit, fails when MAC commands leave too little room and waits out a
+ * full MAC queue with an empty uplink.
+ */
+
+#include <LoRa_AT.h>
+
+#include "HostTest.h"
+
+static const char TEST_APP_EUI[] = "8A598335072D2776";
+static const char TEST_APP_KEY[] = "DD8F3881F180151C739534C4EC56216F";
+static const char TEST_DEV_EUI[] = "15C3202192A4504A";
+
+// Sends a buffer as a single uplink and waits for the send to finish
+static LoRa_AT_SendStatus sendWhole(LoRa_AT& modem, const uint8_t* buff,
+                                    size_t len) {
+  if (!modem.beginSend(buff, len, true)) { return modem.sendStatus(); }
+  while (modem.poll()) {}
+  return modem.sendStatus();
+}
+
+int main() {
+  FakeModule fake;
+  LoRa_AT    modem(fake);
+  LoRaStream loraStream(modem);
+
+  CHECK(modem.joinOTAA(TEST_APP_EUI, TEST_APP_KEY, TEST_DEV_EUI, 3, 1000L));
+  // US915 DR0 carries 11 bytes
+  modem.setRegion(LORA_AT_REGION_US915);
+  CHECK(modem.setDataRate(0));
+  CHECK_EQUAL(11, modem.plannedPayloadSize());
+
+  uint8_t data[12] = {0};
+
+  // longer than any uplink at the data rate: refused without a command
+  fake.resetStats();
+  CHECK(!modem.beginSend(data, 12, true));
+  CHECK_EQUAL(LORA_AT_SEND_FAILED, modem.sendStatus());
+  CHECK_EQUAL(0, fake.stats.commands);
+
+  // MAC answers leave some room, but not enough: fails after asking once
+  // instead of sending empty uplinks that won't make more room
+  fake.macPending = 5;
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_FAILED, sendWhole(modem, data, 8));
+  CHECK_EQUAL(0, fake.stats.uplinks);
+  CHECK_EQUAL(0, modem.bytesSent());
+
+  // MAC answers fill the uplink: one empty uplink flushes them first
+  fake.macPending = 11;
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_DONE, sendWhole(modem, data, 8));
+  CHECK_EQUAL(2, fake.stats.uplinks);
+  CHECK_EQUAL(8, fake.stats.uplinkBytes);
+  CHECK_EQUAL(8, modem.bytesSent());
+
+  // a buffer that fits is sent at once
+  fake.resetStats();
+  CHECK_EQUAL(LORA_AT_SEND_DONE, sendWhole(modem, data, 11));
+  CHECK_EQUAL(1, fake.stats.uplinks);
+
+  return hostTestResult("WholeSendTest");
+}
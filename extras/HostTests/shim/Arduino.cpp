@@ -0,0 +1,45 @@
+/**
+ * @file       Arduino.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "Arduino.h"
+
+HardwareSerial Serial(stdout);
+HardwareSerial Serial1;
+
+static uint64_t virtual_us = 0;
+
+// Every look at the clock costs a microsecond, so a loop that only watches
+// the clock still runs out its timeout.
+unsigned long millis() {
+  virtual_us++;
+  return static_cast<unsigned long>(virtual_us / 1000);
+}
+
+unsigned long micros() {
+  virtual_us++;
+  return static_cast<unsigned long>(virtual_us);
+}
+
+void delay(unsigned long ms) {
+  virtual_us += static_cast<uint64_t>(ms) * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+  virtual_us += us;
+}
+
+uint64_t hostMicros() {
+  return virtual_us;
+}
+
+void hostAdvanceMicros(uint64_t us) {
+  virtual_us += us;
+}
+
+void hostResetClock() {
+  virtual_us = 0;
+}
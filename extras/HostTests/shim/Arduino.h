@@ -0,0 +1,430 @@
+/**
+ * @file       Arduino.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Just enough of the Arduino core to build the library on a Linux host.
+ *
+ * Time is virtual: it only moves when the library calls millis(), micros() or
+ * delay(), or when a simulated module moves it, so hours of module time run in
+ * a few milliseconds of host time and every run is repeatable.
+ */
+
+#ifndef EXTRAS_HOSTTESTS_SHIM_ARDUINO_H_
+#define EXTRAS_HOSTTESTS_SHIM_ARDUINO_H_
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+
+/*
+ * Virtual time
+ */
+unsigned long millis();
+unsigned long micros();
+void          delay(unsigned long ms);
+void          delayMicroseconds(unsigned int us);
+inline void   yield() {}
+
+/// The current virtual time in microseconds, without moving the clock
+uint64_t hostMicros();
+/// Move the virtual clock forward
+void hostAdvanceMicros(uint64_t us);
+/// Set the virtual clock back to zero
+void hostResetClock();
+
+template <typename T, typename L>
+inline auto min(const T& a, const L& b) -> decltype(b < a ? b : a) {
+  return (b < a) ? b : a;
+}
+template <typename T, typename L>
+inline auto max(const T& a, const L& b) -> decltype(b < a ? b : a) {
+  return (a < b) ? b : a;
+}
+
+class __FlashStringHelper;
+#define F(string_literal) \
+  (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+/*
+ * String
+ */
+class String {
+ public:
+  String() {}
+  String(const char* c) : _s(c ? c : "") {}  // NOLINT(runtime/explicit)
+  explicit String(char c) : _s(1, c) {}
+  explicit String(int v, int base = DEC) : _s(format(v, base)) {}
+  explicit String(unsigned v, int base = DEC) : _s(format(v, base)) {}
+  explicit String(long v, int base = DEC) : _s(format(v, base)) {}
+  explicit String(unsigned long v, int base = DEC) : _s(format(v, base)) {}
+  explicit String(double v, int digits = 2) {
+    char b[40];
+    snprintf(b, sizeof(b), "%.*f", digits, v);
+    _s = b;
+  }
+
+  unsigned int length() const {
+    return _s.size();
+  }
+  const char* c_str() const {
+    return _s.c_str();
+  }
+  bool reserve(unsigned int n) {
+    _s.reserve(n);
+    return true;
+  }
+  void trim() {
+    size_t first = _s.find_first_not_of(" \t\r\n");
+    size_t last  = _s.find_last_not_of(" \t\r\n");
+    _s = first == std::string::npos ? "" : _s.substr(first, last - first + 1);
+  }
+  bool startsWith(const String& o) const {
+    return _s.compare(0, o._s.size(), o._s) == 0;
+  }
+  bool endsWith(const String& o) const {
+    return _s.size() >= o._s.size() &&
+        _s.compare(_s.size() - o._s.size(), o._s.size(), o._s) == 0;
+  }
+  int indexOf(const String& o, unsigned int from = 0) const {
+    size_t p = _s.find(o._s, from);
+    return p == std::string::npos ? -1 : static_cast<int>(p);
+  }
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t p = _s.find(c, from);
+    return p == std::string::npos ? -1 : static_cast<int>(p);
+  }
+  String substring(unsigned int from) const {
+    return String(_s.substr(from).c_str());
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    return String(_s.substr(from, to - from).c_str());
+  }
+  void replace(const String& from, const String& to) {
+    for (size_t p = 0; (p = _s.find(from._s, p)) != std::string::npos;
+         p += to._s.size()) {
+      _s.replace(p, from._s.size(), to._s);
+    }
+  }
+  long toInt() const {
+    return atol(_s.c_str());
+  }
+  float toFloat() const {
+    return atof(_s.c_str());
+  }
+  char operator[](unsigned int i) const {
+    return _s[i];
+  }
+  String& operator+=(const String& o) {
+    _s += o._s;
+    return *this;
+  }
+  String& operator+=(const char* o) {
+    _s += o;
+    return *this;
+  }
+  String& operator+=(char o) {
+    _s += o;
+    return *this;
+  }
+  bool operator==(const String& o) const {
+    return _s == o._s;
+  }
+  bool operator==(const char* o) const {
+    return _s == o;
+  }
+
+ private:
+  static std::string format(long v, int base) {
+    char b[40];
+    snprintf(b, sizeof(b), base == HEX ? "%lx" : "%ld", v);
+    return b;
+  }
+  static std::string format(unsigned long v, int base) {
+    char b[40];
+    snprintf(b, sizeof(b), base == HEX ? "%lx" : "%lu", v);
+    return b;
+  }
+  static std::string format(int v, int base) {
+    return format(static_cast<long>(v), base);
+  }
+  static std::string format(unsigned v, int base) {
+    return format(static_cast<unsigned long>(v), base);
+  }
+
+  std::string _s;
+};
+
+inline String operator+(const String& a, const String& b) {
+  String r = a;
+  r += b;
+  return r;
+}
+
+/*
+ * Print
+ */
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) { n += write(*buffer++); }
+    return n;
+  }
+  size_t write(const char* str) {
+    return str ? write(reinterpret_cast<const uint8_t*>(str), strlen(str))
+               : 0;
+  }
+  size_t write(const char* buffer, size_t size) {
+    return write(reinterpret_cast<const uint8_t*>(buffer), size);
+  }
+  virtual int availableForWrite() {
+    return 0;
+  }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper* s) {
+    return write(reinterpret_cast<const char*>(s));
+  }
+  size_t print(const char* s) {
+    return write(s);
+  }
+  size_t print(const String& s) {
+    return write(s.c_str());
+  }
+  size_t print(char c) {
+    return write(static_cast<uint8_t>(c));
+  }
+  size_t print(unsigned char v, int base = DEC) {
+    return print(static_cast<unsigned long>(v), base);
+  }
+  size_t print(int v, int base = DEC) {
+    return print(static_cast<long>(v), base);
+  }
+  size_t print(unsigned int v, int base = DEC) {
+    return print(static_cast<unsigned long>(v), base);
+  }
+  size_t print(long v, int base = DEC) {
+    char b[40];
+    snprintf(b, sizeof(b), base == HEX ? "%lX" : "%ld", v);
+    return write(b);
+  }
+  size_t print(unsigned long v, int base = DEC) {
+    char b[40];
+    snprintf(b, sizeof(b), base == HEX ? "%lX" : "%lu", v);
+    return write(b);
+  }
+  size_t print(long long v, int base = DEC) {
+    return print(static_cast<long>(v), base);
+  }
+  size_t print(unsigned long long v, int base = DEC) {
+    return print(static_cast<unsigned long>(v), base);
+  }
+  size_t print(double v, int digits = 2) {
+    char b[40];
+    snprintf(b, sizeof(b), "%.*f", digits, v);
+    return write(b);
+  }
+
+  size_t println() {
+    return write("\r\n");
+  }
+  template <typename T>
+  size_t println(T v) {
+    size_t n = print(v);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(T v, int format) {
+    size_t n = print(v, format);
+    return n + println();
+  }
+};
+
+/*
+ * Stream
+ */
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read()      = 0;
+  virtual int peek()      = 0;
+
+  void setTimeout(unsigned long timeout) {
+    _timeout = timeout;
+  }
+  unsigned long getTimeout() {
+    return _timeout;
+  }
+
+  bool find(const char* target) {
+    return find(target, strlen(target));
+  }
+  bool find(char* target) {
+    return find(const_cast<const char*>(target));
+  }
+  bool find(const char* target, size_t length) {
+    size_t i = 0;
+    for (int c; (c = timedRead()) >= 0;) {
+      if (c == target[i]) {
+        if (++i == length) { return true; }
+      } else {
+        i = c == target[0] ? 1 : 0;
+      }
+    }
+    return false;
+  }
+  bool find(char* target, size_t length) {
+    return find(const_cast<const char*>(target), length);
+  }
+  bool find(char target) {
+    return find(&target, 1);
+  }
+
+  long parseInt() {
+    int c;
+    while ((c = timedPeek()) >= 0 && c != '-' && !isdigit(c)) { read(); }
+    bool negative = c == '-';
+    if (negative) { read(); }
+    long value = 0;
+    while ((c = timedPeek()) >= 0 && isdigit(c)) {
+      value = value * 10 + c - '0';
+      read();
+    }
+    return negative ? -value : value;
+  }
+  float parseFloat() {
+    return static_cast<float>(parseInt());
+  }
+
+  size_t readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0) { break; }
+      buffer[count++] = static_cast<char>(c);
+    }
+    return count;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) {
+    return readBytes(reinterpret_cast<char*>(buffer), length);
+  }
+  size_t readBytesUntil(char terminator, char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0 || c == terminator) { break; }
+      buffer[count++] = static_cast<char>(c);
+    }
+    return count;
+  }
+  String readString() {
+    String r;
+    for (int c; (c = timedRead()) >= 0;) { r += static_cast<char>(c); }
+    return r;
+  }
+  String readStringUntil(char terminator) {
+    String r;
+    for (int c; (c = timedRead()) >= 0 && c != terminator;) {
+      r += static_cast<char>(c);
+    }
+    return r;
+  }
+
+ protected:
+  int timedRead() {
+    unsigned long start = millis();
+    do {
+      int c = read();
+      if (c >= 0) { return c; }
+    } while (millis() - start < _timeout);
+    return -1;
+  }
+  int timedPeek() {
+    unsigned long start = millis();
+    do {
+      int c = peek();
+      if (c >= 0) { return c; }
+    } while (millis() - start < _timeout);
+    return -1;
+  }
+
+  unsigned long _timeout = 1000;
+};
+
+/*
+ * Serial ports
+ */
+// Serial prints to standard output; the other ports are not connected
+class HardwareSerial : public Stream {
+ public:
+  explicit HardwareSerial(FILE* out = nullptr) : _out(out) {}
+  void begin(unsigned long) {}
+  void end() {}
+  int  available() override {
+    return 0;
+  }
+  int read() override {
+    return -1;
+  }
+  int peek() override {
+    return -1;
+  }
+  size_t write(uint8_t c) override {
+    if (_out) { fputc(c, _out); }
+    return 1;
+  }
+  using Print::write;
+  operator bool() const {
+    return true;
+  }
+
+ private:
+  FILE* _out;
+};
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+/*
+ * Everything else
+ */
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define LOW 0x0
+#define HIGH 0x1
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int  digitalRead(uint8_t) {
+  return LOW;
+}
+inline int analogRead(uint8_t) {
+  return 0;
+}
+inline void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+inline long random(long howbig) {
+  return howbig ? rand() % howbig : 0;
+}
+inline long random(long howsmall, long howbig) {
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+#endif  // EXTRAS_HOSTTESTS_SHIM_ARDUINO_H_
@@ -22,4 +22,11 @@ typedef LoRa_AT_WioE5::LoRaStream_WioE5 LoRaStream;
 #error "Please define LoRa Radio model"
 #endif
 
+#include "LoRa_AT_Batch.h"
+#include "LoRa_AT_Codec.h"
+#include "LoRa_AT_Fragment.h"
+#include "LoRa_AT_Scheduler.h"
+#include "LoRa_AT_Schema.h"
+#include "LoRa_AT_Store.h"
+
 #endif  // SRC_LORA_AT_H_
@@ -0,0 +1,340 @@
+/**
+ * @file       LoRa_AT_Airtime.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_AIRTIME_H_
+#define SRC_LORA_AT_AIRTIME_H_
+
+#include "LoRa_AT_Common.h"
+#include "LoRa_AT_Regions.h"
+
+/**
+ * @def LORA_AT_AIRTIME_SUBBANDS
+ * @brief The number of sub-bands an airtime budget keeps track of.
+ */
+#ifndef LORA_AT_AIRTIME_SUBBANDS
+#define LORA_AT_AIRTIME_SUBBANDS 3
+#endif
+
+/**
+ * @def LORA_AT_AIRTIME_HISTORY
+ * @brief The number of uplinks remembered for each sub-band of an airtime
+ * budget.
+ *
+ * When more uplinks than this are sent within the window, the oldest two are
+ * counted as one that happened at the time of the newer, so the budget is
+ * never under-counted but may wait a little longer than it needs to.
+ */
+#ifndef LORA_AT_AIRTIME_HISTORY
+#define LORA_AT_AIRTIME_HISTORY 8
+#endif
+
+/**
+ * @def LORA_AT_AIRTIME_WINDOW
+ * @brief The default length of the sliding window of an airtime budget, in
+ * milliseconds; one hour, as used by ETSI for the EU868 limits.
+ */
+#ifndef LORA_AT_AIRTIME_WINDOW
+#define LORA_AT_AIRTIME_WINDOW 3600000UL
+#endif
+
+/**
+ * @brief Calculate the time on air of a LoRa frame, from the formula in the
+ * Semtech SX1276 datasheet.
+ *
+ * Low data rate optimization is used when a symbol is longer than 16 ms, as
+ * LoRaWAN requires.
+ *
+ * @param sf The spreading factor, 7-12; 0 for FSK
+ * @param bw The bandwidth in kHz (125, 250 or 500), or the bit rate in kbps
+ * for FSK
+ * @param phyLen The length of the PHY payload; for LoRaWAN, the application
+ * payload plus #LORA_AT_LORAWAN_OVERHEAD
+ * @param cr The coding rate, 1-4 for 4/5 to 4/8; optional with a default of 1
+ * @param explicitHeader True if the frame has an explicit header; optional
+ * with a default of true
+ * @param preamble The number of preamble symbols; optional with a default of
+ * 8
+ * @param crc True if the frame has a payload CRC; optional with a default of
+ * true, as in LoRaWAN uplinks
+ * @return The time on air in microseconds
+ */
+inline uint32_t LoRa_AT_TimeOnAir(uint8_t sf, uint16_t bw, uint16_t phyLen,
+                                  uint8_t cr = 1, bool explicitHeader = true,
+                                  uint16_t preamble = 8, bool crc = true) {
+  if (sf == 0) {
+    // 5 bytes of preamble, 3 of sync word, 1 of length and 2 of CRC
+    return (static_cast<uint32_t>(phyLen) + 11) * 8000UL / bw;
+  }
+  uint32_t symbol   = (1UL << sf) * 1000UL / bw;
+  bool     lowDR    = symbol > 16000;
+  int32_t  perBlock = 4L * (sf - (lowDR ? 2 : 0));
+  int32_t  bits     = 8L * phyLen - 4L * sf + 28;
+  if (crc) { bits += 16; }
+  if (!explicitHeader) { bits -= 20; }
+  uint32_t payload = 8;
+  if (bits > 0) { payload += (bits + perBlock - 1) / perBlock * (cr + 4); }
+  // count in quarter symbols for the extra 4.25 symbols of the preamble
+  uint32_t quarters = 4UL * preamble + 17 + 4 * payload;
+  return quarters * symbol / 4;
+}
+
+/**
+ * @brief Calculate the time on air of a LoRaWAN uplink with no MAC commands.
+ *
+ * @param region The region
+ * @param dataRate The data rate number
+ * @param len The length of the application payload
+ * @return The time on air in milliseconds, rounded up; 0 if the data rate is
+ * not valid in the region
+ */
+inline uint32_t LoRa_AT_UplinkAirtime(LoRa_AT_Region region, uint8_t dataRate,
+                                      uint16_t len) {
+  LoRa_AT_Modulation mod = LoRa_AT_DataRateModulation(region, dataRate);
+  if (!mod.bw) { return 0; }
+  // the PHY payload of a full 242 byte or longer payload is past 255 bytes
+  uint32_t us = LoRa_AT_TimeOnAir(mod.sf, mod.bw,
+                                  len + LORA_AT_LORAWAN_OVERHEAD);
+  return (us + 999) / 1000;
+}
+
+/**
+ * @brief Keeps track of the airtime used on each sub-band and works out when
+ * the next uplink fits within the duty-cycle limit.
+ *
+ * The airtime of each uplink is added to the sub-band it is counted against
+ * and stays there for the length of the sliding window. A sub-band limited
+ * to 1% with a one hour window can therefore be used for 36 seconds in any
+ * hour.
+ *
+ * The modules choose the channel of each uplink themselves and do not report
+ * it, so every uplink is counted against the sub-band chosen with
+ * setSubBand(). For EU868, sub-band 0 is the 1% band holding the three
+ * default channels, sub-band 1 is the 0.1% band and sub-band 2 is the 10%
+ * band. Only the first transmission of a confirmed uplink is counted.
+ *
+ * Attach a budget to the modem with setAirtimeBudget() and each uplink is
+ * checked against it before it is sent and counted once it is sent.
+ *
+ * @code{.cpp}
+ * LoRa_AT_AirtimeBudget budget(LORA_AT_REGION_EU868);
+ * modem.setAirtimeBudget(&budget);
+ * ...
+ * if (modem.timeUntilSendAllowed(sizeof(reading)) == 0) {
+ *   loraStream.write(reading, sizeof(reading));
+ * }
+ * @endcode
+ */
+class LoRa_AT_AirtimeBudget {
+ public:
+  /**
+   * @brief Construct a new airtime budget with the default limits for a
+   * region.
+   *
+   * EU868 is limited to 1%, 0.1% and 10% on sub-bands 0, 1 and 2 and AS923
+   * to 1% on sub-band 0. The airtime on other regions and sub-bands is only
+   * counted.
+   *
+   * @param region The region
+   * @param window_ms The length of the sliding window in milliseconds;
+   * optional with a default value of #LORA_AT_AIRTIME_WINDOW
+   */
+  explicit LoRa_AT_AirtimeBudget(LoRa_AT_Region region,
+                                 uint32_t window_ms = LORA_AT_AIRTIME_WINDOW) {
+    _region   = region;
+    _window   = window_ms;
+    _dataRate = 0;
+    _subBand  = 0;
+    _total    = 0;
+    for (uint8_t i = 0; i < LORA_AT_AIRTIME_SUBBANDS; i++) {
+      _bands[i].divisor = 0;
+      _bands[i].first   = 0;
+      _bands[i].count   = 0;
+    }
+    if (region == LORA_AT_REGION_EU868) {
+      setLimit(0, 100);
+      setLimit(1, 1000);
+      setLimit(2, 10);
+    } else if (region == LORA_AT_REGION_AS923) {
+      setLimit(0, 100);
+    }
+  }
+
+  /**
+   * @brief Set the duty-cycle limit of a sub-band.
+   *
+   * @param subBand The sub-band
+   * @param divisor The limit as a fraction of the window; 100 for 1%, 1000
+   * for 0.1%, or 0 for no limit
+   */
+  void setLimit(uint8_t subBand, uint16_t divisor) {
+    if (subBand < LORA_AT_AIRTIME_SUBBANDS) {
+      _bands[subBand].divisor = divisor;
+    }
+  }
+
+  /**
+   * @brief Choose the sub-band later uplinks are counted against.
+   *
+   * @param subBand The sub-band
+   */
+  void setSubBand(uint8_t subBand) {
+    if (subBand < LORA_AT_AIRTIME_SUBBANDS) { _subBand = subBand; }
+  }
+
+  /**
+   * @brief Set the data rate used to work out the airtime of later uplinks.
+   *
+   * The modem sets this before each send.
+   *
+   * @param dataRate The data rate number
+   */
+  void setDataRate(uint8_t dataRate) {
+    _dataRate = dataRate;
+  }
+
+  /**
+   * @brief Get the data rate used to work out the airtime of uplinks.
+   *
+   * @return The data rate number
+   */
+  uint8_t getDataRate() const {
+    return _dataRate;
+  }
+
+  /**
+   * @brief Get the airtime of an uplink at the current data rate.
+   *
+   * @param len The length of the application payload
+   * @return The time on air in milliseconds
+   */
+  uint32_t airtime(size_t len) const {
+    return LoRa_AT_UplinkAirtime(_region, _dataRate,
+                                 LoRa_AT_Min<size_t>(len, 255));
+  }
+
+  /**
+   * @brief Count an uplink that was just sent against the current sub-band.
+   *
+   * @param len The length of the application payload
+   */
+  void record(size_t len) {
+    recordAirtime(airtime(len));
+  }
+
+  /**
+   * @brief Count airtime that was just used against the current sub-band.
+   *
+   * @param airtime_ms The time on air in milliseconds
+   */
+  void recordAirtime(uint32_t airtime_ms) {
+    SubBand& band = _bands[_subBand];
+    uint32_t now  = LORA_AT_MILLIS();
+    expire(band, now);
+    if (band.count == LORA_AT_AIRTIME_HISTORY) {
+      // count the oldest uplink as part of the next one
+      uint8_t next = nextIndex(band.first);
+      band.uplinks[next].airtime += band.uplinks[band.first].airtime;
+      band.first = next;
+      band.count--;
+    }
+    Uplink& slot = band.uplinks[index(band, band.count)];
+    slot.start   = now;
+    slot.airtime = airtime_ms;
+    band.count++;
+    _total += airtime_ms;
+  }
+
+  /**
+   * @brief Get the airtime used on the current sub-band within the window.
+   *
+   * @return The airtime in milliseconds
+   */
+  uint32_t used() {
+    SubBand& band = _bands[_subBand];
+    expire(band, LORA_AT_MILLIS());
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < band.count; i++) {
+      sum += band.uplinks[index(band, i)].airtime;
+    }
+    return sum;
+  }
+
+  /**
+   * @brief Get all of the airtime counted since the budget was created.
+   *
+   * @return The airtime in milliseconds
+   */
+  uint32_t total() const {
+    return _total;
+  }
+
+  /**
+   * @brief Get how long until an uplink can be sent on the current sub-band
+   * without going over its limit.
+   *
+   * @param len The length of the application payload
+   * @return The time in milliseconds; 0 if it can be sent now, or 0xFFFFFFFF
+   * if it is too long to ever fit within the limit
+   */
+  uint32_t timeUntilAllowed(size_t len) {
+    SubBand& band = _bands[_subBand];
+    if (!band.divisor) { return 0; }
+    uint32_t need    = airtime(len);
+    uint32_t allowed = _window / band.divisor;
+    if (need > allowed) { return 0xFFFFFFFF; }
+    uint32_t sum = used();
+    uint32_t now = LORA_AT_MILLIS();
+    // wait for the oldest uplinks to leave the window until there's room
+    for (uint8_t i = 0; i < band.count; i++) {
+      if (sum + need <= allowed) { return i ? wait(band, i - 1, now) : 0; }
+      sum -= band.uplinks[index(band, i)].airtime;
+    }
+    return band.count ? wait(band, band.count - 1, now) : 0;
+  }
+
+ protected:
+  struct Uplink {
+    uint32_t start;
+    uint32_t airtime;
+  };
+  struct SubBand {
+    uint16_t divisor;
+    uint8_t  first;
+    uint8_t  count;
+    Uplink   uplinks[LORA_AT_AIRTIME_HISTORY];
+  };
+
+  static uint8_t nextIndex(uint8_t i) {
+    return i + 1 < LORA_AT_AIRTIME_HISTORY ? i + 1 : 0;
+  }
+  static uint8_t index(const SubBand& band, uint8_t n) {
+    uint16_t i = band.first + n;
+    return i < LORA_AT_AIRTIME_HISTORY ? i : i - LORA_AT_AIRTIME_HISTORY;
+  }
+
+  // Forgets the uplinks that have left the window
+  void expire(SubBand& band, uint32_t now) {
+    while (band.count && now - band.uplinks[band.first].start >= _window) {
+      band.first = nextIndex(band.first);
+      band.count--;
+    }
+  }
+
+  // The time until the n-th oldest uplink leaves the window
+  uint32_t wait(const SubBand& band, uint8_t n, uint32_t now) const {
+    return _window - (now - band.uplinks[index(band, n)].start);
+  }
+
+  LoRa_AT_Region _region;
+  uint32_t       _window;
+  uint8_t        _dataRate;
+  uint8_t        _subBand;
+  uint32_t       _total;
+  SubBand        _bands[LORA_AT_AIRTIME_SUBBANDS];
+};
+
+#endif  // SRC_LORA_AT_AIRTIME_H_
@@ -0,0 +1,243 @@
+/**
+ * @file       LoRa_AT_Batch.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_BATCH_H_
+#define SRC_LORA_AT_BATCH_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @def LORA_AT_BATCH_BUFFER
+ * @brief The default number of bytes a batch can hold; the largest LoRaWAN
+ * payload in any region.
+ */
+#ifndef LORA_AT_BATCH_BUFFER
+#define LORA_AT_BATCH_BUFFER 242
+#endif
+
+/**
+ * @def LORA_AT_BATCH_MIN_PAYLOAD
+ * @brief The payload size assumed for a batch if the module reports no space;
+ * the smallest uplink allowed in any region.
+ */
+#ifndef LORA_AT_BATCH_MIN_PAYLOAD
+#define LORA_AT_BATCH_MIN_PAYLOAD 11
+#endif
+
+/**
+ * @brief Packs small records together so that each uplink carries as many of
+ * them as the current data rate allows.
+ *
+ * The space for the batch is set when the first record is added, from the
+ * regional parameters if the data rate is known or otherwise by asking the
+ * module. Records are then added until the next one would not fit, at which
+ * point the batch is sent as a single uplink and a new batch is started. A
+ * batch is also sent once its oldest record reaches the maximum age (checked
+ * by maintain()) or when flush() is called. Records are never split between
+ * uplinks.
+ *
+ * @code{.cpp}
+ * LoRa_AT_Batcher<LoRa_AT> batch(modem);
+ * batch.setMaxAge(15L * 60L * 1000L);
+ * ...
+ * batch.add(reading, sizeof(reading));
+ * batch.maintain();
+ * @endcode
+ *
+ * @tparam modemType The LoRa modem class
+ * @tparam N The number of bytes the batch can hold
+ */
+template <class modemType, unsigned N = LORA_AT_BATCH_BUFFER>
+class LoRa_AT_Batcher {
+ public:
+  /**
+   * @brief Construct a new batching queue.
+   *
+   * @param modem The modem to send the batches with
+   */
+  explicit LoRa_AT_Batcher(modemType& modem) : _modem(modem) {
+    _maxAge = 0;
+    _used   = 0;
+    resetStats();
+  }
+
+  /**
+   * @brief Set how long a record may wait in the batch.
+   *
+   * @param maxAge_ms The longest time in milliseconds from adding the first
+   * record of a batch until maintain() sends it; 0 to never send a batch
+   * because of its age.
+   */
+  void setMaxAge(uint32_t maxAge_ms) {
+    _maxAge = maxAge_ms;
+  }
+
+  /**
+   * @brief Add a record to the batch, first sending the batch if the record
+   * does not fit.
+   *
+   * If the record fills the batch, the batch is sent straight away. The record
+   * is kept whether or not that send works; a batch that could not be sent is
+   * counted by sendFailures() and stays to be sent again.
+   *
+   * @param record The record
+   * @param len The length of the record
+   * @return True if the record was added; false if the record can never fit
+   * in a single uplink or the full batch before it could not be sent, in
+   * which case the record was not added.
+   */
+  bool add(const uint8_t* record, size_t len) {
+    if (len == 0) { return true; }
+    bool   fresh    = !_used || _used + len > _capacity;
+    size_t capacity = fresh ? freshCapacity() : _capacity;
+    // refuse a record that can't fit before sending anything for it
+    if (len > capacity) {
+      DBG(GF("### Record of"), len, GF("bytes can't fit in a batch of"),
+          capacity);
+      return false;
+    }
+    if (_used && fresh && !flush()) { return false; }
+    if (fresh) {
+      _capacity = capacity;
+      _started  = LORA_AT_MILLIS();
+    }
+    memcpy(_buf + _used, record, len);
+    _used += len;
+    _records++;
+    _batchRecords++;
+    // don't wait for another record that can't fit
+    if (_used == _capacity) { flush(); }
+    return true;
+  }
+
+  /**
+   * @brief Send the batch if its oldest record has reached the maximum age.
+   *
+   * @return False if a batch was due and could not be sent.
+   */
+  bool maintain() {
+    if (_used && _maxAge && LORA_AT_MILLIS() - _started >= _maxAge) {
+      return flush();
+    }
+    return true;
+  }
+
+  /**
+   * @brief Send whatever is in the batch now.
+   *
+   * @return True if the batch was sent or was empty; false if it could not
+   * be sent, in which case it is kept to try again.
+   */
+  bool flush() {
+    if (!_used) { return true; }
+    if (!_modem.beginSend(_buf, _used, true)) {
+      _sendFailures++;
+      return false;
+    }
+    while (_modem.poll()) { LORA_AT_YIELD(); }
+    if (_modem.sendStatus() != LORA_AT_SEND_DONE) {
+      DBG(GF("### Failed to send batch of"), _batchRecords, GF("records"));
+      _sendFailures++;
+      return false;
+    }
+    _frames++;
+    _bytesSent += _used;
+    _capacitySent += _capacity;
+    _used         = 0;
+    _batchRecords = 0;
+    return true;
+  }
+
+  /**
+   * @brief Get the number of bytes waiting in the batch.
+   *
+   * @return The number of bytes waiting
+   */
+  size_t size() const {
+    return _used;
+  }
+
+  /**
+   * @brief Set all of the statistics back to zero.
+   */
+  void resetStats() {
+    _records      = 0;
+    _batchRecords = 0;
+    _frames       = 0;
+    _bytesSent    = 0;
+    _capacitySent = 0;
+    _sendFailures = 0;
+  }
+
+  /**
+   * @brief Get the number of uplinks sent since the statistics were reset.
+   *
+   * @return The number of uplinks
+   */
+  uint32_t frames() const {
+    return _frames;
+  }
+
+  /**
+   * @brief Get the number of uplinks saved by batching since the statistics
+   * were reset; that is, the number of records sent less the number of
+   * uplinks used to send them.
+   *
+   * @return The number of uplinks saved
+   */
+  uint32_t framesSaved() const {
+    return _records - _batchRecords - _frames;
+  }
+
+  /**
+   * @brief Get the number of times a batch could not be sent since the
+   * statistics were reset, whether by add(), maintain() or flush().
+   *
+   * @return The number of failed sends
+   */
+  uint32_t sendFailures() const {
+    return _sendFailures;
+  }
+
+  /**
+   * @brief Get how full the uplinks sent since the statistics were reset
+   * were, compared to the space available for each.
+   *
+   * @return The fill ratio, from 0 to 1
+   */
+  float fillRatio() const {
+    if (!_capacitySent) { return 0; }
+    return static_cast<float>(_bytesSent) / _capacitySent;
+  }
+
+ protected:
+  // The space for a new batch, from the regional parameters if the data rate
+  // is known or otherwise from the module
+  size_t freshCapacity() {
+    int16_t space = _modem.plannedPayloadSize();
+    if (space < 0) { space = _modem.getMaxPayloadSize(); }
+    if (space < LORA_AT_BATCH_MIN_PAYLOAD) {
+      space = LORA_AT_BATCH_MIN_PAYLOAD;
+    }
+    return LoRa_AT_Min<size_t>(space, N);
+  }
+
+  modemType& _modem;
+  uint8_t    _buf[N];
+  size_t     _used;
+  size_t     _capacity;
+  uint32_t   _started;
+  uint32_t   _maxAge;
+  uint32_t   _records;
+  uint16_t   _batchRecords;
+  uint32_t   _frames;
+  uint32_t   _bytesSent;
+  uint32_t   _capacitySent;
+  uint32_t   _sendFailures;
+};
+
+#endif  // SRC_LORA_AT_BATCH_H_
@@ -0,0 +1,249 @@
+/**
+ * @file       LoRa_AT_ChannelMask.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_CHANNELMASK_H_
+#define SRC_LORA_AT_CHANNELMASK_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @brief A mask of up to 72 LoRaWAN channels; bit n is channel n.
+ *
+ * Masks are written as hex, most significant byte first, as the modules
+ * report them. A mask of 4 characters covers channels 0-15, 18 characters
+ * cover all 72 channels and the mDOT adds two zeros in front for 20.
+ *
+ * @code{.cpp}
+ * // US915 sub-band 2: channels 8-15 and 65
+ * constexpr LoRa_AT_ChannelMask sb2 =
+ *     LoRa_AT_ChannelMask::fromHex("02000000000000FF00");
+ * modem.setChannelMask(sb2);  // only sends the channels that change
+ * @endcode
+ */
+class LoRa_AT_ChannelMask {
+ public:
+  /**
+   * @brief Construct a mask from its raw bits.
+   *
+   * @param low Channels 0-63
+   * @param high Channels 64-71
+   */
+  constexpr explicit LoRa_AT_ChannelMask(uint64_t low = 0, uint8_t high = 0)
+      : _low(low),
+        _high(high) {}
+
+  /**
+   * @brief Make a mask from hex, most significant byte first.
+   *
+   * This can be used for masks known when compiling; the characters are
+   * not checked. Use parse() for masks from the module or the user.
+   *
+   * @param hex The mask in hex; up to 20 characters
+   * @return The mask
+   */
+  static constexpr LoRa_AT_ChannelMask fromHex(const char* hex) {
+    return fromHex(hex, length(hex));
+  }
+
+  /**
+   * @brief Make the mask of a US915 or AU915 sub-band: eight of the 125 kHz
+   * channels and one of the 500 kHz channels.
+   *
+   * @param subBand The sub-band, 1-8; 0 for all 72 channels
+   * @return The mask; empty if the sub-band is not valid
+   */
+  static constexpr LoRa_AT_ChannelMask subBand(uint8_t subBand) {
+    return subBand == 0 ? ~LoRa_AT_ChannelMask()
+        : subBand <= 8  ? LoRa_AT_ChannelMask(static_cast<uint64_t>(0xFF)
+                                                 << (8 * (subBand - 1)),
+                                             1 << (subBand - 1))
+                        : LoRa_AT_ChannelMask();
+  }
+
+  /**
+   * @brief Read a mask from hex, most significant byte first.
+   *
+   * @param hex The mask in hex; 1-20 characters, which may be surrounded by
+   * white space
+   * @param mask The mask, set if the hex is valid
+   * @return True if the hex was a valid mask
+   */
+  static bool parse(const char* hex, LoRa_AT_ChannelMask* mask) {
+    if (hex == nullptr) { return false; }
+    while (isspace(*hex)) { hex++; }
+    size_t len = 0;
+    while (hex[len] && !isspace(hex[len])) {
+      if (digit(hex[len]) < 0) { return false; }
+      len++;
+    }
+    if (len == 0 || len > 20) { return false; }
+    // anything above channel 71 must be zero
+    for (size_t i = 0; i + 18 < len; i++) {
+      if (digit(hex[i]) != 0) { return false; }
+    }
+    *mask = fromHex(hex, len);
+    return true;
+  }
+
+  /**
+   * @brief Write the mask as hex, most significant byte first.
+   *
+   * @param buff The buffer to write to; at least one more than the number of
+   * digits
+   * @param digits The number of hex characters to write, from the right;
+   * optional with a default of 18 for all 72 channels
+   * @return The buffer
+   */
+  char* toHex(char* buff, uint8_t digits = 18) const {
+    static const char hex[] = "0123456789ABCDEF";
+    for (uint8_t i = 0; i < digits; i++) {
+      uint8_t nibble = digits - 1 - i;
+      uint8_t n      = nibble < 16 ? (_low >> (4 * nibble)) & 0x0F
+                                   : (_high >> (4 * (nibble - 16))) & 0x0F;
+      buff[i]        = nibble < 18 ? hex[n] : '0';
+    }
+    buff[digits] = '\0';
+    return buff;
+  }
+
+  /**
+   * @brief Check if a channel is in the mask.
+   *
+   * @param channel The channel number
+   * @return True if the channel is enabled
+   */
+  constexpr bool test(uint8_t channel) const {
+    return channel < 64 ? (_low >> channel) & 1
+                        : channel < 72 && ((_high >> (channel - 64)) & 1);
+  }
+
+  /**
+   * @brief Add or remove a channel.
+   *
+   * @param channel The channel number; channels above 71 are ignored
+   * @param enable True to add the channel, false to remove it
+   * @return This mask
+   */
+  LoRa_AT_ChannelMask& set(uint8_t channel, bool enable = true) {
+    if (channel < 64) {
+      uint64_t bit = static_cast<uint64_t>(1) << channel;
+      _low         = enable ? _low | bit : _low & ~bit;
+    } else if (channel < 72) {
+      uint8_t bit = 1 << (channel - 64);
+      _high       = enable ? _high | bit : _high & ~bit;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Remove a channel.
+   *
+   * @param channel The channel number
+   * @return This mask
+   */
+  LoRa_AT_ChannelMask& reset(uint8_t channel) {
+    return set(channel, false);
+  }
+
+  /**
+   * @brief Get the channels that are in one mask but not the other.
+   *
+   * @param other The other mask
+   * @return A mask of the channels that differ
+   */
+  constexpr LoRa_AT_ChannelMask diff(const LoRa_AT_ChannelMask& other) const {
+    return *this ^ other;
+  }
+
+  /**
+   * @brief Count the channels in the mask.
+   *
+   * @return The number of channels enabled
+   */
+  uint8_t count() const {
+    uint8_t  n   = 0;
+    uint64_t low = _low;
+    for (; low; n++) { low &= low - 1; }
+    for (uint8_t high = _high; high; n++) { high &= high - 1; }
+    return n;
+  }
+
+  /**
+   * @brief Check if any channel is in the mask.
+   *
+   * @return True if at least one channel is enabled
+   */
+  constexpr bool any() const {
+    return _low || _high;
+  }
+
+  /**
+   * @brief Get 16 channels of the mask, starting from a multiple of 16.
+   *
+   * @param group The group of 16 channels; 0 for channels 0-15 up to 4 for
+   * channels 64-71
+   * @return The channels of the group; bit 0 is the first
+   */
+  constexpr uint16_t group(uint8_t group) const {
+    return group < 4 ? static_cast<uint16_t>(_low >> (16 * group)) : _high;
+  }
+
+  /// @brief The channels in either mask
+  constexpr LoRa_AT_ChannelMask operator|(const LoRa_AT_ChannelMask& o) const {
+    return LoRa_AT_ChannelMask(_low | o._low, _high | o._high);
+  }
+  /// @brief The channels in both masks
+  constexpr LoRa_AT_ChannelMask operator&(const LoRa_AT_ChannelMask& o) const {
+    return LoRa_AT_ChannelMask(_low & o._low, _high & o._high);
+  }
+  /// @brief The channels in only one of the masks
+  constexpr LoRa_AT_ChannelMask operator^(const LoRa_AT_ChannelMask& o) const {
+    return LoRa_AT_ChannelMask(_low ^ o._low, _high ^ o._high);
+  }
+  /// @brief The channels not in the mask
+  constexpr LoRa_AT_ChannelMask operator~() const {
+    return LoRa_AT_ChannelMask(~_low, static_cast<uint8_t>(~_high));
+  }
+  /// @brief True if the masks have the same channels
+  constexpr bool operator==(const LoRa_AT_ChannelMask& o) const {
+    return _low == o._low && _high == o._high;
+  }
+  /// @brief True if the masks have different channels
+  constexpr bool operator!=(const LoRa_AT_ChannelMask& o) const {
+    return !(*this == o);
+  }
+
+ private:
+  static constexpr int8_t digit(char c) {
+    return c >= '0' && c <= '9' ? c - '0'
+        : c >= 'A' && c <= 'F'  ? c - 'A' + 10
+        : c >= 'a' && c <= 'f'  ? c - 'a' + 10
+                                : -1;
+  }
+  static constexpr size_t length(const char* s) {
+    return *s ? 1 + length(s + 1) : 0;
+  }
+  // Reads the hex characters from begin up to end into a number
+  static constexpr uint64_t value(const char* s, size_t begin, size_t end,
+                                  uint64_t acc = 0) {
+    return begin >= end ? acc
+                        : value(s, begin + 1, end,
+                                (acc << 4) | (digit(s[begin]) & 0x0F));
+  }
+  // The last 16 characters are channels 0-63 and the two before those are
+  // channels 64-71
+  static constexpr LoRa_AT_ChannelMask fromHex(const char* hex, size_t len) {
+    return LoRa_AT_ChannelMask(
+        value(hex, len > 16 ? len - 16 : 0, len),
+        len > 16 ? value(hex, len > 18 ? len - 18 : 0, len - 16) : 0);
+  }
+
+  uint64_t _low;
+  uint8_t  _high;
+};
+
+#endif  // SRC_LORA_AT_CHANNELMASK_H_
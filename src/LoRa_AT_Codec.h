@@ -0,0 +1,478 @@
+/**
+ * @file       LoRa_AT_Codec.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_CODEC_H_
+#define SRC_LORA_AT_CODEC_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @def LORA_AT_CODEC_BUFFER
+ * @brief The default number of encoded bytes an encoder can hold; the largest
+ * LoRaWAN payload in any region.
+ */
+#ifndef LORA_AT_CODEC_BUFFER
+#define LORA_AT_CODEC_BUFFER 242
+#endif
+
+/**
+ * @brief Map a signed number to an unsigned one so that numbers close to zero,
+ * either side, become small: 0, -1, 1, -2 become 0, 1, 2, 3.
+ *
+ * @param value The signed number
+ * @return The zig-zag encoded number
+ */
+inline uint32_t LoRa_AT_ZigZag(int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^
+      static_cast<uint32_t>(value < 0 ? -1 : 0);
+}
+
+/**
+ * @brief Undo LoRa_AT_ZigZag().
+ *
+ * @param value The zig-zag encoded number
+ * @return The signed number
+ */
+inline int32_t LoRa_AT_UnZigZag(uint32_t value) {
+  return static_cast<int32_t>((value >> 1) ^ (0 - (value & 1)));
+}
+
+/**
+ * @brief Write a number as a varint: seven bits per byte, least significant
+ * first, with the top bit set on every byte but the last.
+ *
+ * @param value The number
+ * @param out The buffer to write to
+ * @param size The space left in the buffer
+ * @return The number of bytes written, 1-5; 0 if there was not enough space
+ */
+inline size_t LoRa_AT_PutVarint(uint32_t value, uint8_t* out, size_t size) {
+  size_t n = 0;
+  do {
+    if (n == size) { return 0; }
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    out[n++] = value ? byte | 0x80 : byte;
+  } while (value);
+  return n;
+}
+
+/**
+ * @brief Read a varint written by LoRa_AT_PutVarint().
+ *
+ * @param in The buffer to read from
+ * @param len The number of bytes left in the buffer
+ * @param value The number read
+ * @return The number of bytes read; 0 if the varint was cut short or longer
+ * than five bytes
+ */
+inline size_t LoRa_AT_GetVarint(const uint8_t* in, size_t len,
+                                uint32_t* value) {
+  uint32_t result = 0;
+  for (size_t n = 0; n < len && n < 5; n++) {
+    result |= static_cast<uint32_t>(in[n] & 0x7F) << (7 * n);
+    if (!(in[n] & 0x80)) {
+      *value = result;
+      return n + 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief The interface of a payload codec, which makes a message smaller
+ * before it is sent and restores it after it is received.
+ *
+ * Codecs encode in a single pass, writing each part of the output as soon as
+ * the input for it has been read, and keep no more than a few values of state
+ * between them; nothing is allocated. The decode functions are the reference
+ * for the application server.
+ */
+class LoRa_AT_Codec {
+ public:
+  virtual ~LoRa_AT_Codec() {}
+
+  /**
+   * @brief Encode a message.
+   *
+   * @param in The message
+   * @param len The length of the message
+   * @param out The buffer to write the encoded message to
+   * @param size The size of the buffer
+   * @return The length of the encoded message; 0 if it did not fit in the
+   * buffer or the message is not valid for the codec
+   */
+  virtual size_t encode(const uint8_t* in, size_t len, uint8_t* out,
+                        size_t size) = 0;
+
+  /**
+   * @brief Decode a message made by encode().
+   *
+   * @param in The encoded message
+   * @param len The length of the encoded message
+   * @param out The buffer to write the message to
+   * @param size The size of the buffer
+   * @return The length of the message; 0 if it did not fit in the buffer or
+   * the encoded message is not valid
+   */
+  virtual size_t decode(const uint8_t* in, size_t len, uint8_t* out,
+                        size_t size) = 0;
+};
+
+/**
+ * @brief Encodes a message of integer samples as zig-zag varints, so that
+ * samples close to zero take a single byte.
+ *
+ * The message is a packed array of samples in the byte order of the host.
+ *
+ * @tparam T The type of the samples; a signed integer of up to 32 bits
+ */
+template <typename T>
+class LoRa_AT_VarintCodec : public LoRa_AT_Codec {
+ public:
+  size_t encode(const uint8_t* in, size_t len, uint8_t* out,
+                size_t size) override {
+    if (len % sizeof(T)) { return 0; }
+    size_t used = 0;
+    for (size_t i = 0; i < len; i += sizeof(T)) {
+      T sample;
+      memcpy(&sample, in + i, sizeof(T));
+      size_t n = LoRa_AT_PutVarint(LoRa_AT_ZigZag(sample), out + used,
+                                   size - used);
+      if (!n) { return 0; }
+      used += n;
+    }
+    return used;
+  }
+
+  size_t decode(const uint8_t* in, size_t len, uint8_t* out,
+                size_t size) override {
+    size_t written = 0;
+    for (size_t i = 0; i < len;) {
+      uint32_t value;
+      size_t   n = LoRa_AT_GetVarint(in + i, len - i, &value);
+      if (!n || written + sizeof(T) > size) { return 0; }
+      T sample = static_cast<T>(LoRa_AT_UnZigZag(value));
+      memcpy(out + written, &sample, sizeof(T));
+      written += sizeof(T);
+      i += n;
+    }
+    return written;
+  }
+};
+
+/**
+ * @brief Encodes a series of integer samples taken at a steady rate by the
+ * change in their change (delta-of-delta), as zig-zag varints.
+ *
+ * The first sample is written in full and the second as the difference from
+ * the first. Every later sample is written as the difference between its
+ * change and the change before it, which is zero for timestamps at a fixed
+ * interval and small for slowly drifting readings, so most samples take a
+ * single byte. The message is a packed array of samples in the byte order of
+ * the host.
+ *
+ * @tparam T The type of the samples; an integer of up to 32 bits
+ */
+template <typename T>
+class LoRa_AT_DeltaDeltaCodec : public LoRa_AT_Codec {
+ public:
+  size_t encode(const uint8_t* in, size_t len, uint8_t* out,
+                size_t size) override {
+    if (len % sizeof(T)) { return 0; }
+    // the differences wrap around as unsigned numbers, so every sample can be
+    // restored exactly
+    uint32_t prev  = 0;
+    uint32_t delta = 0;
+    size_t   used  = 0;
+    for (size_t i = 0; i < len; i += sizeof(T)) {
+      T sample;
+      memcpy(&sample, in + i, sizeof(T));
+      uint32_t value = static_cast<uint32_t>(static_cast<int32_t>(sample));
+      uint32_t diff  = value - prev;
+      size_t   n     = LoRa_AT_PutVarint(
+          LoRa_AT_ZigZag(static_cast<int32_t>(diff - delta)), out + used,
+          size - used);
+      if (!n) { return 0; }
+      used += n;
+      // the first sample is written as its difference from zero
+      delta = i ? diff : 0;
+      prev  = value;
+    }
+    return used;
+  }
+
+  size_t decode(const uint8_t* in, size_t len, uint8_t* out,
+                size_t size) override {
+    uint32_t prev    = 0;
+    uint32_t delta   = 0;
+    size_t   written = 0;
+    for (size_t i = 0; i < len;) {
+      uint32_t value;
+      size_t   n = LoRa_AT_GetVarint(in + i, len - i, &value);
+      if (!n || written + sizeof(T) > size) { return 0; }
+      uint32_t diff = delta + static_cast<uint32_t>(LoRa_AT_UnZigZag(value));
+      prev += diff;
+      delta    = written ? diff : 0;
+      T sample = static_cast<T>(prev);
+      memcpy(out + written, &sample, sizeof(T));
+      written += sizeof(T);
+      i += n;
+    }
+    return written;
+  }
+};
+
+/**
+ * @brief A small LZ77 codec that can copy from a fixed dictionary as well as
+ * from the earlier part of the message.
+ *
+ * The dictionary is the same on the device and the application server and
+ * holds text the messages are likely to repeat, such as field names or a
+ * typical message, so that even the first occurrence in a short message can
+ * be copied. The encoded message is a series of tokens:
+ * - `0xxxxxxx`: the next x + 1 bytes are copied as they are
+ * - `1xxxxxxx` and a varint distance: copy x + 3 bytes starting the given
+ * distance back, where the dictionary comes just before the message; the copy
+ * may overlap the bytes it is writing, to repeat a run
+ *
+ * Matches are found by searching the dictionary and the message directly, so
+ * no tables are kept; the time taken grows with the length of the dictionary
+ * and the message.
+ */
+class LoRa_AT_DictionaryCodec : public LoRa_AT_Codec {
+ public:
+  /**
+   * @brief Construct a new dictionary codec.
+   *
+   * @param dict The dictionary; it must stay unchanged while the codec is in
+   * use. Optional; without one, only repeats within a message are copied.
+   * @param dictLen The length of the dictionary
+   */
+  explicit LoRa_AT_DictionaryCodec(const uint8_t* dict = nullptr,
+                                   size_t         dictLen = 0)
+      : _dict(dict),
+        _dictLen(dict ? dictLen : 0) {}
+
+  size_t encode(const uint8_t* in, size_t len, uint8_t* out,
+                size_t size) override {
+    size_t used    = 0;
+    size_t literal = 0;  // the start of the bytes waiting to be copied as-is
+    size_t pos     = 0;
+    while (pos < len) {
+      size_t distance = 0;
+      size_t best     = longestMatch(in, len, pos, &distance);
+      if (best < MIN_MATCH) {
+        pos++;
+        if (pos - literal == MAX_LITERAL) {
+          if (!putLiteral(in + literal, pos - literal, out, size, &used)) {
+            return 0;
+          }
+          literal = pos;
+        }
+        continue;
+      }
+      if (!putLiteral(in + literal, pos - literal, out, size, &used)) {
+        return 0;
+      }
+      if (used == size) { return 0; }
+      out[used++] = 0x80 | (best - MIN_MATCH);
+      size_t n    = LoRa_AT_PutVarint(distance, out + used, size - used);
+      if (!n) { return 0; }
+      used += n;
+      pos += best;
+      literal = pos;
+    }
+    if (!putLiteral(in + literal, pos - literal, out, size, &used)) {
+      return 0;
+    }
+    return used;
+  }
+
+  size_t decode(const uint8_t* in, size_t len, uint8_t* out,
+                size_t size) override {
+    size_t written = 0;
+    for (size_t i = 0; i < len;) {
+      uint8_t token = in[i++];
+      if (!(token & 0x80)) {
+        size_t count = token + 1;
+        if (count > len - i || count > size - written) { return 0; }
+        memcpy(out + written, in + i, count);
+        written += count;
+        i += count;
+        continue;
+      }
+      uint32_t distance;
+      size_t   n     = LoRa_AT_GetVarint(in + i, len - i, &distance);
+      size_t   count = (token & 0x7F) + MIN_MATCH;
+      if (!n || distance == 0 || distance > _dictLen + written ||
+          count > size - written) {
+        return 0;
+      }
+      i += n;
+      // copy one byte at a time so an overlapping copy repeats a run
+      size_t from = _dictLen + written - distance;
+      for (size_t k = 0; k < count; k++, from++) {
+        out[written] = from < _dictLen ? _dict[from] : out[from - _dictLen];
+        written++;
+      }
+    }
+    return written;
+  }
+
+ protected:
+  static constexpr size_t MIN_MATCH   = 3;
+  static constexpr size_t MAX_MATCH   = 0x7F + MIN_MATCH;
+  static constexpr size_t MAX_LITERAL = 0x80;
+
+  // The byte at a position of the dictionary followed by the message
+  uint8_t at(const uint8_t* in, size_t pos) const {
+    return pos < _dictLen ? _dict[pos] : in[pos - _dictLen];
+  }
+
+  // Finds the longest earlier copy of the bytes at pos
+  size_t longestMatch(const uint8_t* in, size_t len, size_t pos,
+                      size_t* distance) const {
+    size_t here = _dictLen + pos;
+    size_t most = len - pos < MAX_MATCH ? len - pos : MAX_MATCH;
+    size_t best = 0;
+    for (size_t from = 0; from < here && best < most; from++) {
+      size_t n = 0;
+      while (n < most && at(in, from + n) == in[pos + n]) { n++; }
+      if (n > best || (n == best && n)) {
+        // prefer the closest copy, which has the shortest distance
+        best      = n;
+        *distance = here - from;
+      }
+    }
+    return best;
+  }
+
+  // Writes the bytes waiting to be copied as-is
+  static bool putLiteral(const uint8_t* lit, size_t count, uint8_t* out,
+                         size_t size, size_t* used) {
+    if (!count) { return true; }
+    if (count + 1 > size - *used) { return false; }
+    out[(*used)++] = count - 1;
+    memcpy(out + *used, lit, count);
+    *used += count;
+    return true;
+  }
+
+  const uint8_t* _dict;
+  size_t         _dictLen;
+};
+
+/**
+ * @brief Encodes each message with a codec before sending it, as a single
+ * uplink.
+ *
+ * @code{.cpp}
+ * LoRa_AT_DeltaDeltaCodec<int16_t> codec;
+ * LoRa_AT_Encoder<LoRa_AT>         encoder(modem, codec);
+ * ...
+ * encoder.send(reinterpret_cast<uint8_t*>(readings), sizeof(readings));
+ * @endcode
+ *
+ * @tparam modemType The LoRa modem class
+ * @tparam N The number of encoded bytes the encoder can hold
+ */
+template <class modemType, unsigned N = LORA_AT_CODEC_BUFFER>
+class LoRa_AT_Encoder {
+ public:
+  /**
+   * @brief Construct a new encoder.
+   *
+   * @param modem The modem to send the encoded messages with
+   * @param codec The codec to encode the messages with
+   */
+  LoRa_AT_Encoder(modemType& modem, LoRa_AT_Codec& codec)
+      : _modem(modem),
+        _codec(&codec) {
+    resetStats();
+  }
+
+  /**
+   * @brief Change the codec used for later messages.
+   *
+   * @param codec The codec
+   */
+  void setCodec(LoRa_AT_Codec& codec) {
+    _codec = &codec;
+  }
+
+  /**
+   * @brief Encode a message and send it as a single uplink.
+   *
+   * @param buff The message
+   * @param len The length of the message
+   * @return True if the message was sent; false if it could not be encoded
+   * into the buffer or could not be sent.
+   */
+  bool send(const uint8_t* buff, size_t len) {
+    size_t encoded = _codec->encode(buff, len, _buf, N);
+    if (len && !encoded) {
+      DBG(GF("### Message of"), len, GF("bytes could not be encoded"));
+      return false;
+    }
+    if (!_modem.beginSend(_buf, encoded, true)) { return false; }
+    while (_modem.poll()) { LORA_AT_YIELD(); }
+    if (_modem.sendStatus() != LORA_AT_SEND_DONE) { return false; }
+    _bytesIn += len;
+    _bytesOut += encoded;
+    return true;
+  }
+
+  /**
+   * @brief Set all of the statistics back to zero.
+   */
+  void resetStats() {
+    _bytesIn  = 0;
+    _bytesOut = 0;
+  }
+
+  /**
+   * @brief Get the number of message bytes sent since the statistics were
+   * reset, before encoding.
+   *
+   * @return The number of message bytes
+   */
+  uint32_t bytesIn() const {
+    return _bytesIn;
+  }
+
+  /**
+   * @brief Get the number of bytes actually sent since the statistics were
+   * reset, after encoding.
+   *
+   * @return The number of encoded bytes
+   */
+  uint32_t bytesOut() const {
+    return _bytesOut;
+  }
+
+  /**
+   * @brief Get the size of the encoded messages compared to the messages,
+   * since the statistics were reset.
+   *
+   * @return The compression ratio; 2 if the messages were halved, or 0 if
+   * nothing has been sent
+   */
+  float ratio() const {
+    if (!_bytesOut) { return 0; }
+    return static_cast<float>(_bytesIn) / _bytesOut;
+  }
+
+ protected:
+  modemType&     _modem;
+  LoRa_AT_Codec* _codec;
+  uint8_t        _buf[N];
+  uint32_t       _bytesIn;
+  uint32_t       _bytesOut;
+};
+
+#endif  // SRC_LORA_AT_CODEC_H_
@@ -21,6 +21,30 @@
 #endif
 #endif
 
+/**
+ * @def LORA_AT_MILLIS
+ * @brief The clock used for all timeouts and time stamps in the library.
+ *
+ * This defaults to the Arduino millis() function. Define it (and
+ * #LORA_AT_DELAY) before including the library to drive the library from a
+ * different clock - for example a virtual clock that lets a simulated module
+ * run hours of module time in a few milliseconds.
+ */
+#ifndef LORA_AT_MILLIS
+#define LORA_AT_MILLIS() millis()
+#endif
+
+/**
+ * @def LORA_AT_DELAY
+ * @brief The function used for all delays in the library.
+ *
+ * This defaults to the Arduino delay() function. It must advance the clock
+ * returned by #LORA_AT_MILLIS.
+ */
+#ifndef LORA_AT_DELAY
+#define LORA_AT_DELAY(ms) delay(ms)
+#endif
+
 /**
  * @def LORA_AT_YIELD_MS
  * @brief The length of time in milliseconds to "yield" waiting for a new
@@ -37,7 +61,7 @@
  */
 #ifndef LORA_AT_YIELD
 #define LORA_AT_YIELD() \
-  { delay(LORA_AT_YIELD_MS); }
+  { LORA_AT_DELAY(LORA_AT_YIELD_MS); }
 #endif
 
 /**
@@ -48,6 +72,17 @@
 #define LORA_AT_RX_BUFFER 256
 #endif
 
+/**
+ * @def LORA_AT_RX_FIFO_SPSC
+ * @brief Set to true to make the receiving buffer safe to read from a
+ * different context (such as another core) than the one that fills it.
+ *
+ * @see TinyGsmFifo
+ */
+#if !defined(LORA_AT_RX_FIFO_SPSC)
+#define LORA_AT_RX_FIFO_SPSC false
+#endif
+
 /**
  * @def LORA_AT_DL_CHECK
  * @brief How frequently to check for downlinks in the maintain function.
@@ -106,6 +141,37 @@ typedef const char* GsmConstStr;
 #define LORA_AT_PROGMEM TINY_GSM_PROGMEM
 #endif
 
+/**
+ * @brief Get the length of a string that may be stored in flash memory.
+ *
+ * @param str The string
+ * @return The number of characters in the string, not including the
+ * terminating null.
+ */
+inline size_t LoRa_AT_ConstStrLen(const char* str) {
+  return strlen(str);
+}
+/**
+ * @brief Get a single character of a string that may be stored in flash
+ * memory.
+ *
+ * @param str The string
+ * @param i The position of the character to read
+ * @return The character at the position
+ */
+inline char LoRa_AT_ConstStrChar(const char* str, size_t i) {
+  return str[i];
+}
+#if (defined(__AVR__) || defined(ARDUINO_ARCH_AVR)) && \
+    !defined(__AVR_ATmega4809__)
+inline size_t LoRa_AT_ConstStrLen(const __FlashStringHelper* str) {
+  return strlen_P(reinterpret_cast<const char*>(str));
+}
+inline char LoRa_AT_ConstStrChar(const __FlashStringHelper* str, size_t i) {
+  return pgm_read_byte(reinterpret_cast<const char*>(str) + i);
+}
+#endif
+
 #ifdef LORA_AT_DEBUG
 namespace {
 template <typename T>
@@ -123,7 +189,7 @@ static void DBG_PLAIN(T head, Args... tail) {
 template <typename... Args>
 static void DBG(Args... args) {
   LORA_AT_DEBUG.print(GF("["));
-  LORA_AT_DEBUG.print(millis());
+  LORA_AT_DEBUG.print(LORA_AT_MILLIS());
   LORA_AT_DEBUG.print(GF("] "));
   DBG_PLAIN(args...);
 }
@@ -144,6 +210,27 @@ const T& LoRa_AT_Max(const T& a, const T& b) {
 }
 
 
+/**
+ * @brief The state of an uplink started with LoRa_AT_Radio::beginSend().
+ */
+enum LoRa_AT_SendStatus {
+  LORA_AT_SEND_IDLE = 0,  ///< No send has been started
+  LORA_AT_SEND_BUSY,      ///< A send is in progress; keep calling poll()
+  LORA_AT_SEND_DONE,      ///< The last send finished and sent every byte
+  LORA_AT_SEND_FAILED,    ///< The last send stopped before every byte was sent
+};
+
+/**
+ * @brief The state of a network join started with LoRa_AT_Radio::beginJoin().
+ */
+enum LoRa_AT_JoinStatus {
+  LORA_AT_JOIN_IDLE = 0,  ///< No join has been started
+  LORA_AT_JOIN_BUSY,      ///< A join is in progress; keep calling poll()
+  LORA_AT_JOIN_JOINED,    ///< The last join succeeded
+  LORA_AT_JOIN_FAILED,    ///< Every attempt of the last join failed
+};
+
+
 /*
  * Automatically find baud rate
  */
@@ -159,7 +246,7 @@ uint32_t LoRa_AT_AutoBaud(T& SerialAT, uint32_t minimum = 9600,
 
     DBG("Trying baud rate", rate, "...");
     SerialAT.begin(rate);
-    delay(10);
+    LORA_AT_DELAY(10);
     for (int j = 0; j < 10; j++) {
       SerialAT.print("AT\r\n");
       String input = SerialAT.readString();
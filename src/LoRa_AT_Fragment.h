@@ -0,0 +1,355 @@
+/**
+ * @file       LoRa_AT_Fragment.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_FRAGMENT_H_
+#define SRC_LORA_AT_FRAGMENT_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @def LORA_AT_FRAGMENT_SIZE
+ * @brief The default number of message bytes carried in each uplink fragment.
+ *
+ * With the two byte fragment header, the default of 9 fits in the smallest
+ * uplink allowed in any region (11 bytes). Use a larger size with faster data
+ * rates.
+ */
+#ifndef LORA_AT_FRAGMENT_SIZE
+#define LORA_AT_FRAGMENT_SIZE 9
+#endif
+
+/**
+ * @def LORA_AT_MAX_FRAGMENT_SIZE
+ * @brief The largest number of message bytes that can be put in a single
+ * uplink fragment.
+ */
+#ifndef LORA_AT_MAX_FRAGMENT_SIZE
+#define LORA_AT_MAX_FRAGMENT_SIZE 240
+#endif
+
+/**
+ * @def LORA_AT_REASSEMBLY_BUFFER
+ * @brief The number of message bytes the reassembler can hold.
+ */
+#ifndef LORA_AT_REASSEMBLY_BUFFER
+#define LORA_AT_REASSEMBLY_BUFFER LORA_AT_RX_BUFFER
+#endif
+
+/**
+ * @brief The length of the header at the start of each fragment.
+ */
+#define LORA_AT_FRAGMENT_HEADER 2
+
+/**
+ * @brief The maximum number of fragments in a message.
+ */
+#define LORA_AT_MAX_FRAGMENTS 16
+
+/**
+ * @brief Splits messages that are too long for a single uplink into numbered
+ * fragments that the application server can put back together.
+ *
+ * Each fragment is sent as a single uplink, never split by the modem, and
+ * starts with a two byte header:
+ * - byte 0: the message id, which increases by one for each new message
+ * - byte 1: the fragment index in the upper four bits and the index of the
+ * last fragment in the lower four bits
+ *
+ * Every fragment but the last carries exactly the fragment size in message
+ * bytes, so a message can be up to 16 times the fragment size.
+ *
+ * @tparam modemType The LoRa modem class
+ */
+template <class modemType>
+class LoRa_AT_Fragmenter {
+ public:
+  /**
+   * @brief Construct a new fragmenter.
+   *
+   * @param modem The modem to send the fragments with
+   * @param fragmentSize The number of message bytes to put in each fragment;
+   * optional with a default value of #LORA_AT_FRAGMENT_SIZE
+   */
+  explicit LoRa_AT_Fragmenter(modemType& modem,
+                              uint8_t fragmentSize = LORA_AT_FRAGMENT_SIZE)
+      : _modem(modem) {
+    _messageId = 0;
+    setFragmentSize(fragmentSize);
+  }
+
+  /**
+   * @brief Set the number of message bytes to put in each fragment.
+   *
+   * @param fragmentSize The number of message bytes per fragment; limited to
+   * #LORA_AT_MAX_FRAGMENT_SIZE
+   */
+  void setFragmentSize(uint8_t fragmentSize) {
+    _fragmentSize = LoRa_AT_Max<uint8_t>(
+        1, LoRa_AT_Min<uint8_t>(fragmentSize, LORA_AT_MAX_FRAGMENT_SIZE));
+  }
+
+  /**
+   * @brief Send a message as a new set of fragments.
+   *
+   * @param buff The message to send
+   * @param len The length of the message; no more than 16 times the fragment
+   * size
+   * @return The number of message bytes in the fragments that were sent; the
+   * sending stops at the first fragment that fails.
+   */
+  size_t write(const uint8_t* buff, size_t len) {
+    _messageId++;
+    return send(buff, len, 0xFFFF);
+  }
+
+  /**
+   * @brief Send some of the fragments of the last message again, with the
+   * same message id.
+   *
+   * @param buff The same message given to the last write()
+   * @param len The length of the message
+   * @param fragments A bitmap of the fragments to send; bit n is fragment n
+   * @return The number of message bytes in the fragments that were sent
+   */
+  size_t resend(const uint8_t* buff, size_t len, uint16_t fragments) {
+    return send(buff, len, fragments);
+  }
+
+  /**
+   * @brief Get the number of fragments a message would be sent in.
+   *
+   * @param len The length of the message
+   * @return The number of fragments; 0 if the message is too long to
+   * fragment
+   */
+  uint8_t fragmentCount(size_t len) const {
+    size_t count = (len + _fragmentSize - 1) / _fragmentSize;
+    return count > LORA_AT_MAX_FRAGMENTS ? 0 : count;
+  }
+
+  /**
+   * @brief Get the id of the last message written.
+   *
+   * @return The message id
+   */
+  uint8_t messageId() const {
+    return _messageId;
+  }
+
+ protected:
+  size_t send(const uint8_t* buff, size_t len, uint16_t fragments) {
+    if (len == 0) { return 0; }
+    uint8_t count = fragmentCount(len);
+    if (!count) {
+      DBG(GF("### Message too long to fragment:"), len, GF("bytes"));
+      return 0;
+    }
+    uint8_t last = count - 1;
+    size_t  sent = 0;
+    for (uint8_t i = 0; i <= last; i++) {
+      if (!(fragments & (1 << i))) { continue; }
+      size_t offset = i * _fragmentSize;
+      size_t n      = LoRa_AT_Min<size_t>(_fragmentSize, len - offset);
+      _frag[0]      = _messageId;
+      _frag[1]      = (i << 4) | last;
+      memcpy(_frag + LORA_AT_FRAGMENT_HEADER, buff + offset, n);
+      if (!_modem.beginSend(_frag, n + LORA_AT_FRAGMENT_HEADER, true)) {
+        break;
+      }
+      while (_modem.poll()) { LORA_AT_YIELD(); }
+      if (_modem.sendStatus() != LORA_AT_SEND_DONE) {
+        DBG(GF("### Failed to send fragment"), i, GF("of message"),
+            _messageId);
+        break;
+      }
+      sent += n;
+    }
+    return sent;
+  }
+
+  modemType& _modem;
+  uint8_t    _messageId;
+  uint8_t    _fragmentSize;
+  uint8_t    _frag[LORA_AT_FRAGMENT_HEADER + LORA_AT_MAX_FRAGMENT_SIZE];
+};
+
+/**
+ * @brief Puts fragmented downlink messages back together, in order.
+ *
+ * Downlink fragments use the same two byte header as the uplink fragments
+ * from LoRa_AT_Fragmenter, but the fragments of a message do not all need to
+ * be the same size. Fragments may arrive in any order; a fragment with a new
+ * message id discards any incomplete message. Once every fragment has arrived
+ * the message can be read out in fragment order.
+ */
+class LoRa_AT_Reassembler {
+ public:
+  LoRa_AT_Reassembler() {
+    clear();
+  }
+
+  /**
+   * @brief Discard the current message and all of its fragments.
+   */
+  void clear() {
+    _received  = 0;
+    _last      = 0;
+    _messageId = 0;
+    _used      = 0;
+    _started   = false;
+  }
+
+  /**
+   * @brief Add a single fragment, including its header.
+   *
+   * @param frame The fragment
+   * @param len The length of the fragment, including the header
+   * @return True if the message the fragment belongs to is now complete
+   */
+  bool push(const uint8_t* frame, size_t len) {
+    if (len < LORA_AT_FRAGMENT_HEADER) { return complete(); }
+    int8_t index = startFragment(frame);
+    size_t n     = len - LORA_AT_FRAGMENT_HEADER;
+    if (index < 0) { return complete(); }
+    if (_used + n > LORA_AT_REASSEMBLY_BUFFER) {
+      DBG(GF("### Reassembly buffer overflow, dropped fragment"), index);
+      return complete();
+    }
+    memcpy(_buf + _used, frame + LORA_AT_FRAGMENT_HEADER, n);
+    return finishFragment(index, n);
+  }
+
+  /**
+   * @brief Read everything waiting in a stream as a single fragment.
+   *
+   * A Class A device gets at most one downlink after each uplink, so calling
+   * this after each send reads exactly one downlink. The fragment is read
+   * straight into the reassembly buffer.
+   *
+   * @param stream The stream to read from; usually the LoRaStream
+   * @return True if the message the fragment belongs to is now complete
+   */
+  bool receive(Stream& stream) {
+    if (stream.available() < LORA_AT_FRAGMENT_HEADER) { return complete(); }
+    uint8_t header[LORA_AT_FRAGMENT_HEADER];
+    stream.readBytes(header, LORA_AT_FRAGMENT_HEADER);
+    int8_t index    = startFragment(header);
+    size_t n        = 0;
+    bool   overflow = false;
+    while (stream.available()) {
+      int c = stream.read();
+      if (c < 0) { break; }
+      if (index < 0) { continue; }
+      if (_used + n < LORA_AT_REASSEMBLY_BUFFER) {
+        _buf[_used + n++] = c;
+      } else {
+        overflow = true;
+      }
+    }
+    if (index < 0) { return complete(); }
+    if (overflow) {
+      DBG(GF("### Reassembly buffer overflow, dropped fragment"), index);
+      return complete();
+    }
+    return finishFragment(index, n);
+  }
+
+  /**
+   * @brief Check if every fragment of the current message has arrived.
+   *
+   * @return True if the message is complete
+   */
+  bool complete() const {
+    return _started && missing() == 0;
+  }
+
+  /**
+   * @brief Get the fragments of the current message that have not arrived.
+   *
+   * @return A bitmap of the missing fragments; bit n is fragment n
+   */
+  uint16_t missing() const {
+    if (!_started) { return 0; }
+    uint16_t all = _last == 15 ? 0xFFFF : (1 << (_last + 1)) - 1;
+    return all & ~_received;
+  }
+
+  /**
+   * @brief Get the id of the current message.
+   *
+   * @return The message id
+   */
+  uint8_t messageId() const {
+    return _messageId;
+  }
+
+  /**
+   * @brief Get the number of message bytes received so far.
+   *
+   * @return The number of bytes held
+   */
+  size_t length() const {
+    return _used;
+  }
+
+  /**
+   * @brief Copy a complete message out in fragment order and clear it.
+   *
+   * @param buff The buffer to copy the message into
+   * @param size The size of the buffer; any part of the message that does not
+   * fit is lost
+   * @return The number of bytes copied; 0 if the message is not complete
+   */
+  size_t read(uint8_t* buff, size_t size) {
+    if (!complete()) { return 0; }
+    size_t copied = 0;
+    for (uint8_t i = 0; i <= _last && copied < size; i++) {
+      size_t n = LoRa_AT_Min<size_t>(_length[i], size - copied);
+      memcpy(buff + copied, _buf + _offset[i], n);
+      copied += n;
+    }
+    clear();
+    return copied;
+  }
+
+ private:
+  // Checks the header of a new fragment, starting a new message if needed;
+  // returns the fragment index, or -1 if the fragment should be ignored
+  int8_t startFragment(const uint8_t* header) {
+    uint8_t id    = header[0];
+    uint8_t index = header[1] >> 4;
+    uint8_t last  = header[1] & 0x0F;
+    if (!_started || id != _messageId || last != _last) {
+      clear();
+      _started   = true;
+      _messageId = id;
+      _last      = last;
+    }
+    if (index > _last || (_received & (1 << index))) { return -1; }
+    return index;
+  }
+
+  // Records a fragment that was copied in at the end of the buffer
+  bool finishFragment(uint8_t index, size_t n) {
+    _offset[index] = _used;
+    _length[index] = n;
+    _used += n;
+    _received |= 1 << index;
+    return complete();
+  }
+
+  uint8_t  _buf[LORA_AT_REASSEMBLY_BUFFER];
+  uint16_t _offset[LORA_AT_MAX_FRAGMENTS];
+  uint8_t  _length[LORA_AT_MAX_FRAGMENTS];
+  uint16_t _received;
+  uint16_t _used;
+  uint8_t  _last;
+  uint8_t  _messageId;
+  bool     _started;
+};
+
+#endif  // SRC_LORA_AT_FRAGMENT_H_
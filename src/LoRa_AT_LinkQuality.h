@@ -0,0 +1,280 @@
+/**
+ * @file       LoRa_AT_LinkQuality.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_LINKQUALITY_H_
+#define SRC_LORA_AT_LINKQUALITY_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @def LORA_AT_LINK_HISTORY
+ * @brief The number of link quality reports remembered.
+ */
+#ifndef LORA_AT_LINK_HISTORY
+#define LORA_AT_LINK_HISTORY 8
+#endif
+
+/**
+ * @def LORA_AT_LINK_EWMA_SHIFT
+ * @brief The weight of each new report in the moving averages of the link
+ * quality, as a power of two: each report counts for 1/2^n of the average.
+ */
+#ifndef LORA_AT_LINK_EWMA_SHIFT
+#define LORA_AT_LINK_EWMA_SHIFT 2
+#endif
+
+/**
+ * @def LORA_AT_LINK_STALENESS
+ * @brief The default age in milliseconds after which the link quality
+ * reports are too old to answer getSignalQuality() and isNetworkConnected()
+ * without asking the network again; 15 minutes.
+ */
+#ifndef LORA_AT_LINK_STALENESS
+#define LORA_AT_LINK_STALENESS 900000UL
+#endif
+
+/**
+ * @brief The measures of link quality kept by LoRa_AT_LinkHistory.
+ */
+enum LoRa_AT_LinkMetric : uint8_t {
+  /// The RSSI of a downlink, in dBm
+  LORA_AT_LINK_RSSI = 0,
+  /// The SNR of a downlink, in dB
+  LORA_AT_LINK_SNR = 1,
+  /// The link margin of an uplink reported by a LinkCheckAns, in dB
+  LORA_AT_LINK_MARGIN = 2,
+  /// The number of gateways that heard an uplink, from a LinkCheckAns
+  LORA_AT_LINK_GATEWAYS = 3,
+};
+
+/**
+ * @brief Remembers the last few signal and link check reports from the
+ * module, so the quality of the link can be known without sending uplinks to
+ * measure it.
+ *
+ * The modem adds every report it sees on its own: the RSSI and SNR of each
+ * downlink and the margin and gateway count of each LinkCheckAns. For each
+ * measure, the newest, lowest and highest value among the remembered reports
+ * are available, as is an exponentially weighted moving average over every
+ * report since the history was cleared.
+ */
+class LoRa_AT_LinkHistory {
+ public:
+  LoRa_AT_LinkHistory() {
+    clear();
+  }
+
+  /**
+   * @brief Forget every report.
+   */
+  void clear() {
+    _first = 0;
+    _count = 0;
+    for (uint8_t m = 0; m < METRICS; m++) {
+      _updates[m] = 0;
+      _average[m] = 0;
+    }
+  }
+
+  /**
+   * @brief Add the RSSI of a downlink.
+   *
+   * @param rssi The RSSI in dBm
+   */
+  void recordSignal(int16_t rssi) {
+    Report& r = add();
+    r.value[LORA_AT_LINK_RSSI] = rssi;
+    r.has                      = flag(LORA_AT_LINK_RSSI);
+    blend(LORA_AT_LINK_RSSI, rssi);
+  }
+
+  /**
+   * @brief Add the RSSI and SNR of a downlink.
+   *
+   * @param rssi The RSSI in dBm
+   * @param snr The SNR in dB
+   */
+  void recordSignal(int16_t rssi, int16_t snr) {
+    recordSignal(rssi);
+    Report& r                 = _reports[index(_count - 1)];
+    r.value[LORA_AT_LINK_SNR] = snr;
+    r.has |= flag(LORA_AT_LINK_SNR);
+    blend(LORA_AT_LINK_SNR, snr);
+  }
+
+  /**
+   * @brief Add the answer to a link check.
+   *
+   * @param margin The link margin in dB
+   * @param gateways The number of gateways that heard the link check
+   */
+  void recordLinkCheck(uint8_t margin, uint8_t gateways) {
+    Report& r                      = add();
+    r.value[LORA_AT_LINK_MARGIN]   = margin;
+    r.value[LORA_AT_LINK_GATEWAYS] = gateways;
+    r.has = flag(LORA_AT_LINK_MARGIN) | flag(LORA_AT_LINK_GATEWAYS);
+    blend(LORA_AT_LINK_MARGIN, margin);
+    blend(LORA_AT_LINK_GATEWAYS, gateways);
+  }
+
+  /**
+   * @brief Check if any remembered report has a measure.
+   *
+   * @param metric The measure
+   * @return True if the measure is known
+   */
+  bool has(LoRa_AT_LinkMetric metric) const {
+    return newest(metric) != nullptr;
+  }
+
+  /**
+   * @brief Get how long ago the newest report of a measure was added.
+   *
+   * @param metric The measure
+   * @return The age in milliseconds; 0xFFFFFFFF if the measure is not known
+   */
+  uint32_t age(LoRa_AT_LinkMetric metric) const {
+    const Report* r = newest(metric);
+    return r ? LORA_AT_MILLIS() - r->time : 0xFFFFFFFF;
+  }
+
+  /**
+   * @brief Get the newest value of a measure.
+   *
+   * @param metric The measure
+   * @return The value; 0 if it is not known
+   */
+  int16_t latest(LoRa_AT_LinkMetric metric) const {
+    const Report* r = newest(metric);
+    return r ? r->value[metric] : 0;
+  }
+
+  /**
+   * @brief Get the lowest value of a measure among the remembered reports.
+   *
+   * @param metric The measure
+   * @return The value; 0 if it is not known
+   */
+  int16_t lowest(LoRa_AT_LinkMetric metric) const {
+    return extreme(metric, false);
+  }
+
+  /**
+   * @brief Get the highest value of a measure among the remembered reports.
+   *
+   * @param metric The measure
+   * @return The value; 0 if it is not known
+   */
+  int16_t highest(LoRa_AT_LinkMetric metric) const {
+    return extreme(metric, true);
+  }
+
+  /**
+   * @brief Get the moving average of a measure.
+   *
+   * @param metric The measure
+   * @return The average, rounded to a whole number; 0 if it is not known
+   */
+  int16_t average(LoRa_AT_LinkMetric metric) const {
+    // the average is kept in 16ths
+    int32_t a = _average[metric];
+    return (a + (a < 0 ? -8 : 8)) / 16;
+  }
+
+  /**
+   * @brief Get the number of reports of a measure added since the history
+   * was cleared, including those no longer remembered.
+   *
+   * Comparing this before and after a send tells whether the send brought a
+   * new report, without relying on the clock.
+   *
+   * @param metric The measure
+   * @return The number of reports, wrapping around to 1 after 65535
+   */
+  uint16_t updates(LoRa_AT_LinkMetric metric) const {
+    return _updates[metric];
+  }
+
+  /**
+   * @brief Get the number of reports remembered.
+   *
+   * @return The number of reports
+   */
+  uint8_t size() const {
+    return _count;
+  }
+
+ protected:
+  static constexpr uint8_t METRICS = 4;
+
+  struct Report {
+    uint32_t time;
+    int16_t  value[METRICS];
+    uint8_t  has;  ///< A bit for each measure in the report
+  };
+
+  static uint8_t flag(LoRa_AT_LinkMetric metric) {
+    return 1 << metric;
+  }
+  uint8_t index(uint8_t n) const {
+    uint16_t i = _first + n;
+    return i < LORA_AT_LINK_HISTORY ? i : i - LORA_AT_LINK_HISTORY;
+  }
+
+  // Makes room for a new report, forgetting the oldest if the ring is full
+  Report& add() {
+    if (_count == LORA_AT_LINK_HISTORY) {
+      _first = index(1);
+      _count--;
+    }
+    Report& r = _reports[index(_count++)];
+    r.time    = LORA_AT_MILLIS();
+    r.has     = 0;
+    return r;
+  }
+
+  const Report* newest(LoRa_AT_LinkMetric metric) const {
+    for (uint8_t n = _count; n > 0; n--) {
+      const Report& r = _reports[index(n - 1)];
+      if (r.has & flag(metric)) { return &r; }
+    }
+    return nullptr;
+  }
+
+  int16_t extreme(LoRa_AT_LinkMetric metric, bool high) const {
+    bool    found = false;
+    int16_t best  = 0;
+    for (uint8_t n = 0; n < _count; n++) {
+      const Report& r = _reports[index(n)];
+      if (!(r.has & flag(metric))) { continue; }
+      int16_t v = r.value[metric];
+      if (!found || (high ? v > best : v < best)) { best = v; }
+      found = true;
+    }
+    return best;
+  }
+
+  void blend(LoRa_AT_LinkMetric metric, int16_t value) {
+    int32_t v = static_cast<int32_t>(value) * 16;
+    bool first = _updates[metric] == 0;
+    // the count skips 0 when it wraps, so 0 always means no report yet
+    if (++_updates[metric] == 0) { _updates[metric] = 1; }
+    if (first) {
+      _average[metric] = v;
+      return;
+    }
+    _average[metric] += (v - _average[metric]) / (1 << LORA_AT_LINK_EWMA_SHIFT);
+  }
+
+  Report   _reports[LORA_AT_LINK_HISTORY];
+  uint8_t  _first;
+  uint8_t  _count;
+  uint16_t _updates[METRICS];
+  int32_t  _average[METRICS];
+};
+
+#endif  // SRC_LORA_AT_LINKQUALITY_H_
@@ -9,6 +9,10 @@
 #define SRC_LORA_AT_MODEM_H_
 
 #include "LoRa_AT_Common.h"
+#include "LoRa_AT_ChannelMask.h"
+#include "LoRa_AT_LinkQuality.h"
+#include "LoRa_AT_ResponseMatcher.h"
+#include "LoRa_AT_StreamStats.h"
 
 #ifndef DEFAULT_JOIN_ATTEMPTS
 #define DEFAULT_JOIN_ATTEMPTS 10
@@ -51,9 +55,53 @@
 #endif
 #endif
 
+/**
+ * @def LORA_AT_HEX_CHUNK
+ * @brief The number of hex characters collected on the stack before they are
+ * written to the modem when sending data as hex. This must be even.
+ */
+#ifndef LORA_AT_HEX_CHUNK
+#define LORA_AT_HEX_CHUNK 32
+#endif
+
+#if LORA_AT_HEX_CHUNK < 2 || (LORA_AT_HEX_CHUNK % 2) != 0
+#error "LORA_AT_HEX_CHUNK must be an even number"
+#endif
+
+/**
+ * @def LORA_AT_STRING_BUFFER
+ * @brief The size of the buffer on the stack used by the functions that return
+ * a String, such as getDevEUI(); long enough for a key written with
+ * separators between the bytes.
+ */
+#ifndef LORA_AT_STRING_BUFFER
+#define LORA_AT_STRING_BUFFER 64
+#endif
+
 static char const hex_chars[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
                                    '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
 
+// The value of each hex character, indexed by the low five bits of the
+// character; 0xFF where no hex character has those bits
+static const uint8_t hex_values[32] = {
+    0xFF, 10,   11,   12,   13,   14,   15,   0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0,    1,    2,    3,    4,    5,
+    6,    7,    8,    9,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+/**
+ * @brief Convert a single hex character to its value.
+ *
+ * @param c The character; upper or lower case
+ * @return The value of the character (0-15); -1 if it is not a hex character
+ */
+static inline int8_t LoRa_AT_HexValue(char c) {
+  uint8_t v = hex_values[c & 0x1F];
+  if (v == 0xFF) { return -1; }
+  // digits are 0x30-0x39, letters are 0x41-0x46 or 0x61-0x66
+  if (v < 10 ? (c & 0xE0) != 0x20 : (c & 0xC0) != 0x40) { return -1; }
+  return v;
+}
+
 static const char LORA_OK[] LORA_AT_PROGMEM    = AT_OK AT_NL;
 static const char LORA_ERROR[] LORA_AT_PROGMEM = AT_ERROR AT_NL;
 
@@ -122,15 +170,65 @@ class LoRa_AT_Modem {
    * failed in module set up
    */
   bool begin() {
+    forgetSettings();
     return thisModem().initImpl();
   }
   /**
    * @copydoc LoRa_AT_Modem::begin()
    */
   bool init() {
+    forgetSettings();
     return thisModem().initImpl();
   }
 
+  /**
+   * @brief Forget every setting remembered from the module, so the next read
+   * of each one asks the module again.
+   *
+   * The settings are read from the module once and then remembered, along
+   * with every setting written, so that reading a setting again or writing
+   * the value it already has doesn't need a command. They are forgotten by
+   * begin(), restart(), factoryDefault() and setBand() and, for the settings
+   * the network can change, by each send or join. Call this if the module
+   * may have been reset or reconfigured without the library knowing.
+   */
+  void forgetSettings() {
+    forgetShadow(SHADOW_ALL);
+  }
+
+  /**
+   * @brief Get the number of settings written to the module since the counts
+   * were reset.
+   *
+   * This counts the settings the library remembers that the module accepted,
+   * including those changed for each message by send options; writes the
+   * module refused are not counted, and the channel mask is counted by
+   * channelCommandsSent() instead.
+   *
+   * @return The number of settings written
+   */
+  uint32_t settingWrites() const {
+    return _settingWrites;
+  }
+
+  /**
+   * @brief Get the number of settings that were not written to the module
+   * since the counts were reset, because the module already had the value.
+   *
+   * @return The number of writes avoided
+   */
+  uint32_t settingWritesAvoided() const {
+    return _settingWritesAvoided;
+  }
+
+  /**
+   * @brief Set the counts of settings written and avoided back to zero.
+   */
+  void resetSettingWrites() {
+    _settingWrites        = 0;
+    _settingWritesAvoided = 0;
+  }
+
   /**
    * @brief Recursive variadic template to send AT commands
    *
@@ -187,7 +285,8 @@ class LoRa_AT_Modem {
    * of NULL
    * @param r7 The seventh output to test against, optional with a default value
    * of NULL
-   * @return The index of the response input
+   * @return The index of the response input; 0 if none arrives in time, or at
+   * once if any is longer than #LORA_AT_MATCH_WINDOW
    */
   int8_t waitResponse(uint32_t timeout_ms, String& data,
                       GsmConstStr r1 = GFP(LORA_OK),
@@ -195,7 +294,42 @@ class LoRa_AT_Modem {
                       GsmConstStr r3 = nullptr, GsmConstStr r4 = nullptr,
                       GsmConstStr r5 = nullptr, GsmConstStr r6 = nullptr,
                       GsmConstStr r7 = nullptr) {
-    return thisModem().waitResponseImpl(timeout_ms, data, r1, r2, r3, r4, r5,
+    data.reserve(LORA_AT_RX_BUFFER);
+    return thisModem().waitResponseImpl(timeout_ms, &data, r1, r2, r3, r4, r5,
+                                        r6, r7);
+  }
+
+  /**
+   * @brief Listen for responses to commands and handle URCs, collecting the
+   * text of the response in a buffer instead of a String.
+   *
+   * @param timeout_ms The time to wait for a response
+   * @param data A buffer to add the response text to; emptied if none of the
+   * outputs is found
+   * @param r1 The first output to test against, optional with a default value
+   * of "OK"
+   * @param r2 The second output to test against, optional with a default value
+   * of "ERROR"
+   * @param r3 The third output to test against, optional with a default value
+   * of NULL
+   * @param r4 The fourth output to test against, optional with a default value
+   * of NULL
+   * @param r5 The fifth output to test against, optional with a default value
+   * of NULL
+   * @param r6 The sixth output to test against, optional with a default value
+   * of NULL
+   * @param r7 The seventh output to test against, optional with a default value
+   * of NULL
+   * @return The index of the response input; 0 if none arrives in time, or at
+   * once if any is longer than #LORA_AT_MATCH_WINDOW
+   */
+  int8_t waitResponse(uint32_t timeout_ms, LoRa_AT_ResponseBuffer& data,
+                      GsmConstStr r1 = GFP(LORA_OK),
+                      GsmConstStr r2 = GFP(LORA_ERROR),
+                      GsmConstStr r3 = nullptr, GsmConstStr r4 = nullptr,
+                      GsmConstStr r5 = nullptr, GsmConstStr r6 = nullptr,
+                      GsmConstStr r7 = nullptr) {
+    return thisModem().waitResponseImpl(timeout_ms, &data, r1, r2, r3, r4, r5,
                                         r6, r7);
   }
 
@@ -217,15 +351,17 @@ class LoRa_AT_Modem {
    * of NULL
    * @param r7 The seventh output to test against, optional with a default value
    * of NULL
-   * @return The index of the response input
+   * @return The index of the response input; 0 if none arrives in time, or at
+   * once if any is longer than #LORA_AT_MATCH_WINDOW
    */
   int8_t waitResponse(uint32_t timeout_ms, GsmConstStr r1 = GFP(LORA_OK),
                       GsmConstStr r2 = GFP(LORA_ERROR),
                       GsmConstStr r3 = nullptr, GsmConstStr r4 = nullptr,
                       GsmConstStr r5 = nullptr, GsmConstStr r6 = nullptr,
                       GsmConstStr r7 = nullptr) {
-    String data;
-    return waitResponse(timeout_ms, data, r1, r2, r3, r4, r5, r6, r7);
+    return thisModem().waitResponseImpl(timeout_ms,
+                                        static_cast<String*>(nullptr), r1, r2,
+                                        r3, r4, r5, r6, r7);
   }
 
   /**
@@ -246,7 +382,8 @@ class LoRa_AT_Modem {
    * of NULL
    * @param r7 The seventh output to test against, optional with a default value
    * of NULL
-   * @return The index of the response input
+   * @return The index of the response input; 0 if none arrives in time, or at
+   * once if any is longer than #LORA_AT_MATCH_WINDOW
    */
   int8_t waitResponse(GsmConstStr r1 = GFP(LORA_OK),
                       GsmConstStr r2 = GFP(LORA_ERROR),
@@ -263,7 +400,22 @@ class LoRa_AT_Modem {
    * @return The device EUI
    */
   String getDevEUI() {
-    return thisModem().getDevEUIImpl();
+    char buff[LORA_AT_STRING_BUFFER];
+    getDevEUI(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get the LoRa module's device EUI into a buffer, without using a
+   * String.
+   *
+   * @param buff The buffer to write the device EUI to; it is cut short if it
+   * doesn't fit
+   * @param size The size of the buffer
+   * @return True if the device EUI was read; false if it could not be read, in
+   * which case the buffer holds the text the String version would return
+   */
+  bool getDevEUI(char* buff, size_t size) {
+    return thisModem().getDevEUIImpl(buff, size);
   }
 
   /**
@@ -273,7 +425,21 @@ class LoRa_AT_Modem {
    * @return Some info about the LoRa module.
    */
   String getModuleInfo() {
-    return thisModem().getModuleInfoImpl();
+    char buff[2 * LORA_AT_STRING_BUFFER];
+    getModuleInfo(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get information about the LoRa module into a buffer, without using
+   * a String.
+   *
+   * @param buff The buffer to write the information to; it is cut short if it
+   * doesn't fit
+   * @param size The size of the buffer
+   * @return True if the information was read
+   */
+  bool getModuleInfo(char* buff, size_t size) {
+    return thisModem().getModuleInfoImpl(buff, size);
   }
 
   /**
@@ -285,6 +451,8 @@ class LoRa_AT_Modem {
    * module failed to reset to default.
    */
   bool factoryDefault() {
+    forgetSettings();
+    thisModem().forgetPlan(true);
     return thisModem().factoryDefaultImpl();
   }
   /**@}*/
@@ -302,6 +470,8 @@ class LoRa_AT_Modem {
    * an error in restarting the module.
    */
   bool restart() {
+    forgetSettings();
+    thisModem().forgetPlan(true);
     return thisModem().restartImpl();
   }
   /**
@@ -340,7 +510,14 @@ class LoRa_AT_Modem {
    * false if the module failed to set the network mode
    */
   bool setPublicNetwork(bool isPublic) {
-    return thisModem().setPublicNetworkImpl(isPublic);
+    if (shadowKept(SHADOW_PUBLIC_NETWORK, _shadowPublic == isPublic)) {
+      return true;
+    }
+    forgetShadow(SHADOW_PUBLIC_NETWORK);
+    if (!thisModem().setPublicNetworkImpl(isPublic)) { return false; }
+    _shadowPublic = isPublic;
+    shadowWritten(SHADOW_PUBLIC_NETWORK);
+    return true;
   }
   /**
    * @brief Report whether the module is using public network mode
@@ -349,7 +526,11 @@ class LoRa_AT_Modem {
    * if the module is set up to connect to a private MTS network
    */
   bool getPublicNetwork() {
-    return thisModem().getPublicNetworkImpl();
+    if (!shadowed(SHADOW_PUBLIC_NETWORK) &&
+        thisModem().getPublicNetworkImpl(_shadowPublic)) {
+      shadowStore(SHADOW_PUBLIC_NETWORK);
+    }
+    return _shadowPublic;
   }
 
   /**
@@ -359,13 +540,17 @@ class LoRa_AT_Modem {
    * @note Requiring acknowledgement of every send can significantly slow down
    * the send time.
    *
+   * These are also the retries for confirmed messages sent with send options
+   * that don't give their own.
+   *
    * @param numAckRetries The number of retries to attempt to
    * get acknowledgement [0-15].
    * @return True if the module accepting the acknowledgement setting; false if
    * there was an error in setting the acknowledgement setting.
    */
   bool setConfirmationRetries(int8_t numAckRetries) {
-    return thisModem().setConfirmationRetriesImpl(numAckRetries);
+    _confirmRetries = numAckRetries;
+    return writeConfirmationRetries(numAckRetries);
   }
   /**
    * @brief Check the number of retries to attempt when sending a message and
@@ -375,7 +560,11 @@ class LoRa_AT_Modem {
    * [0-15].
    */
   int8_t getConfirmationRetries() {
-    return thisModem().getConfirmationRetriesImpl();
+    if (!shadowed(SHADOW_ACK_RETRIES) &&
+        thisModem().getConfirmationRetriesImpl(_shadowAckRetries)) {
+      shadowStore(SHADOW_ACK_RETRIES);
+    }
+    return _shadowAckRetries;
   }
 
   /**
@@ -407,10 +596,43 @@ class LoRa_AT_Modem {
                 int8_t   attempts       = DEFAULT_JOIN_ATTEMPTS,
                 uint32_t initialBackoff = DEFAULT_INITIAL_BACKOFF,
                 bool     useHex         = true) {
+    forgetLinkQuality();  // link checks from an old session prove nothing
     return thisModem().joinOTAAImpl(appEui, appKey, devEui, attempts,
                                     initialBackoff, useHex);
   }
 
+  /**
+   * @brief Set the keys for an OTAA join and start joining the network
+   * without waiting for the module to finish.
+   *
+   * The keys are set before this returns; the join attempts and the backoff
+   * between them are carried out by later calls to poll(). Use joinStatus()
+   * to check the result and timeUntilNextJoin() to find how long the host can
+   * sleep between attempts.
+   *
+   * @param appEui The App EUI (aka JoinEUI or Network ID); see joinOTAA()
+   * @param appKey The app key (Network key); see joinOTAA()
+   * @param devEui The device EUI; see joinOTAA()
+   * @param attempts The number of attempts to make for successful join;
+   * optional with a default value of #DEFAULT_JOIN_ATTEMPTS.
+   * @param initialBackoff The initial backoff delay before retrying after a
+   * failed join attempt; optional, with a default value of
+   * #DEFAULT_INITIAL_BACKOFF
+   * @param useHex True if the appKey and appEUI are in hex; false for standard
+   * strings; optional with a default value of true.
+   * @return True if the join was started; false if another send or join is
+   * still in progress.
+   */
+  bool beginJoinOTAA(const char* appEui, const char* appKey,
+                     const char* devEui,
+                     int8_t      attempts       = DEFAULT_JOIN_ATTEMPTS,
+                     uint32_t    initialBackoff = DEFAULT_INITIAL_BACKOFF,
+                     bool        useHex         = true) {
+    forgetLinkQuality();  // link checks from an old session prove nothing
+    return thisModem().beginJoinOTAAImpl(appEui, appKey, devEui, attempts,
+                                         initialBackoff, useHex);
+  }
+
   /**
    * @brief Join a network using OTAA (Over The Air Activation)
    *
@@ -507,6 +729,7 @@ class LoRa_AT_Modem {
                int uplinkCounter = 1, int downlinkCounter = 0,
                int8_t   attempts       = DEFAULT_JOIN_ATTEMPTS,
                uint32_t initialBackoff = DEFAULT_INITIAL_BACKOFF) {
+    forgetLinkQuality();  // link checks from an old session prove nothing
     return thisModem().joinABPImpl(devAddr, nwkSKey, appSKey, uplinkCounter,
                                    downlinkCounter, attempts, initialBackoff);
   }
@@ -548,25 +771,91 @@ class LoRa_AT_Modem {
    * @brief Confirm whether the module is currently connected to the LoRaWAN
    * network.
    *
+   * If the module is joined and a link check was answered more recently than
+   * the staleness set by setLinkStaleness(), that answer is trusted and no
+   * link check is sent.
+   *
    * @return True if the module is connected to the network; false if the module
    * is not connected to the network
    */
   bool isNetworkConnected(int8_t   attempts       = DEFAULT_JOIN_ATTEMPTS,
                           uint32_t initialBackoff = DEFAULT_INITIAL_BACKOFF) {
+    if (_networkConnected &&
+        _linkHistory.age(LORA_AT_LINK_MARGIN) < _linkStaleness) {
+      return true;
+    }
     bool isConnected  = thisModem().isNetworkConnectedImpl(attempts,
                                                            initialBackoff);
     _networkConnected = isConnected;
     return isConnected;
   }
 
+  /**
+   * @brief Check whether the library last knew the module to be connected to
+   * the LoRaWAN network, without asking the module.
+   *
+   * This is set by a successful join or network check and cleared when the
+   * module reports that it is not joined.
+   *
+   * @return True if the module was last known to be connected to the network
+   */
+  bool isJoined() {
+    return _networkConnected;
+  }
+
   /**
    * @brief Get the signal quality report
    *
+   * If a downlink was received more recently than the staleness set by
+   * setLinkStaleness(), its RSSI is returned without asking the module or
+   * sending anything.
+   *
    * @return A measure of the signal quality (probably the RSSI)
    */
   int16_t getSignalQuality() {
+    if (_linkHistory.age(LORA_AT_LINK_RSSI) < _linkStaleness) {
+      return _linkHistory.latest(LORA_AT_LINK_RSSI);
+    }
     return thisModem().getSignalQualityImpl();
   }
+
+  /**
+   * @brief Get the signal and link check reports remembered from the module.
+   *
+   * Every downlink and every link check answer seen by the library is added,
+   * whether it was asked for or arrived with other traffic.
+   *
+   * @code{.cpp}
+   * const LoRa_AT_LinkHistory& link = modem.linkHistory();
+   * if (link.has(LORA_AT_LINK_SNR) && link.lowest(LORA_AT_LINK_SNR) < -10) {
+   *   // the link has been poor lately
+   * }
+   * @endcode
+   *
+   * @return The history of the link quality
+   */
+  const LoRa_AT_LinkHistory& linkHistory() const {
+    return _linkHistory;
+  }
+
+  /**
+   * @brief Set how old the remembered link quality can be and still answer
+   * getSignalQuality() and isNetworkConnected() without asking the network.
+   *
+   * @param staleness The age in milliseconds; 0 to always ask
+   */
+  void setLinkStaleness(uint32_t staleness) {
+    _linkStaleness = staleness;
+  }
+
+  /**
+   * @brief Forget every signal and link check report.
+   *
+   * This is done by each join, since a new session starts a new link.
+   */
+  void forgetLinkQuality() {
+    _linkHistory.clear();
+  }
   /**@}*/
 
   /**
@@ -585,7 +874,12 @@ class LoRa_AT_Modem {
    * module did not accept the device class
    */
   bool setClass(_lora_class _class) {
-    return thisModem().setClassImpl(_class);
+    if (shadowKept(SHADOW_CLASS, _shadowClass == _class)) { return true; }
+    forgetShadow(SHADOW_CLASS);
+    if (!thisModem().setClassImpl(_class)) { return false; }
+    _shadowClass = _class;
+    shadowWritten(SHADOW_CLASS);
+    return true;
   }
   /**
    * @brief Get the modules current LoRaWAN device class
@@ -593,7 +887,10 @@ class LoRa_AT_Modem {
    * @return The device class from the ::_lora_class enum
    */
   _lora_class getClass() {
-    return thisModem().getClassImpl();
+    if (!shadowed(SHADOW_CLASS) && thisModem().getClassImpl(_shadowClass)) {
+      shadowStore(SHADOW_CLASS);
+    }
+    return _shadowClass;
   }
 
   /**
@@ -602,20 +899,29 @@ class LoRa_AT_Modem {
    *  Port 0 is reserved for MAC commands, ports 1-223 are available for
    * application use, and port 233-255 are reserved for future LoRaWAN use.
    *
+   * This is the port of every message sent without a port of its own in its
+   * send options.
+   *
    * @param uint8_t The outgoing application port, must be a number from 1-255
    * @return True if the port was successfully configured; false if the module
    * did not accept the port
    */
   bool setPort(uint8_t _port) {
-    return thisModem().setPortImpl(_port);
+    _restorePort = -1;
+    return writePort(_port);
   }
   /**
    * @brief Get the LoRaWAN outgoing application port
    *
-   * @return The outgoing application port
+   * @return The outgoing application port of messages sent without a port of
+   * their own
    */
   uint8_t getPort() {
-    return thisModem().getPortImpl();
+    if (_restorePort >= 0) { return _restorePort; }
+    if (!shadowed(SHADOW_PORT) && thisModem().getPortImpl(_shadowPort)) {
+      shadowStore(SHADOW_PORT);
+    }
+    return _shadowPort;
   }
 
   /**
@@ -628,7 +934,11 @@ class LoRa_AT_Modem {
    * module did not accept the device band
    */
   bool setBand(const char* band) {
-    return thisModem().setBandImpl(band);
+    // the band sets the defaults for almost everything else
+    forgetSettings();
+    bool success = thisModem().setBandImpl(band);
+    if (success) { thisModem().planBand(band); }
+    return success;
   }
   /**
    * @brief Set the LoRa band. The band should be appropriate to your
@@ -648,7 +958,22 @@ class LoRa_AT_Modem {
    * @return The current LoRa frequency band the module is using.
    */
   String getBand() {
-    return thisModem().getBandImpl();
+    char buff[LORA_AT_STRING_BUFFER];
+    getBand(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get the current LoRa frequency band into a buffer, without using a
+   * String.
+   *
+   * @param buff The buffer to write the band to
+   * @param size The size of the buffer
+   * @return True if the band was read
+   */
+  bool getBand(char* buff, size_t size) {
+    bool success = thisModem().getBandImpl(buff, size);
+    thisModem().planBand(buff);
+    return success;
   }
 
   /**
@@ -661,7 +986,19 @@ class LoRa_AT_Modem {
    * the module did not accept the device sub-band
    */
   bool setFrequencySubBand(int8_t subBand) {
-    return thisModem().setFrequencySubBandImpl(subBand);
+    _channelCommands = 0;
+    if (shadowKept(SHADOW_SUB_BAND, _shadowSubBand == subBand)) {
+      return true;
+    }
+    // the module forgets the channel mask if it changes it
+    forgetShadow(SHADOW_SUB_BAND);
+    if (!thisModem().setFrequencySubBandImpl(subBand)) {
+      forgetShadow(SHADOW_CHANNEL_MASK);
+      return false;
+    }
+    _shadowSubBand = subBand;
+    shadowWritten(SHADOW_SUB_BAND);
+    return true;
   }
   /**
    * @brief Get the  frequency sub-band the module is operating on. This only
@@ -671,16 +1008,61 @@ class LoRa_AT_Modem {
    * documentation
    */
   int8_t getFrequencySubBand() {
-    return thisModem().getFrequencySubBandImpl();
+    if (!shadowed(SHADOW_SUB_BAND) &&
+        thisModem().getFrequencySubBandImpl(_shadowSubBand)) {
+      shadowStore(SHADOW_SUB_BAND);
+    }
+    return _shadowSubBand;
   }
 
+  /**
+   * @brief Get the channel mask.
+   *
+   * The mask is remembered after it is first read, so later calls don't ask
+   * the module again until something may have changed it.
+   *
+   * @param mask The channel mask
+   * @return True if the channel mask could be read
+   */
+  bool getChannelMask(LoRa_AT_ChannelMask& mask) {
+    if (!shadowed(SHADOW_CHANNEL_MASK)) {
+      if (!thisModem().getChannelMaskImpl(_shadowChannelMask)) {
+        return false;
+      }
+      shadowStore(SHADOW_CHANNEL_MASK);
+    }
+    mask = _shadowChannelMask;
+    return true;
+  }
   /**
    * @brief Get the 16 or 72 bit channel mask
    *
-   * @return The 16 or 72 bit channel mask - most significant bytefirst (MSB)
+   * @return The 16 or 72 bit channel mask - most significant bytefirst (MSB);
+   * empty if the mask could not be read
    */
   String getChannelMask() {
-    return thisModem().getChannelMaskImpl();
+    char buff[modemType::CHANNEL_MASK_DIGITS + 1];
+    getChannelMask(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get the 16 or 72 bit channel mask as hex into a buffer, without
+   * using a String.
+   *
+   * @param buff The buffer to write the mask to; it must have room for the
+   * number of characters the module uses and a terminating null
+   * @param size The size of the buffer
+   * @return True if the mask was read; false if it could not be read or the
+   * buffer is too small, in which case the buffer is left empty
+   */
+  bool getChannelMask(char* buff, size_t size) {
+    if (size) { buff[0] = '\0'; }
+    LoRa_AT_ChannelMask mask;
+    if (size <= modemType::CHANNEL_MASK_DIGITS || !getChannelMask(mask)) {
+      return false;
+    }
+    mask.toHex(buff, modemType::CHANNEL_MASK_DIGITS);
+    return true;
   }
 
   /**
@@ -691,7 +1073,8 @@ class LoRa_AT_Modem {
    * was not enabled.
    */
   bool isChannelEnabled(int pos) {
-    return thisModem().isChannelEnabledImpl(pos);
+    LoRa_AT_ChannelMask mask;
+    return getChannelMask(mask) && mask.test(pos);
   }
 
   /**
@@ -702,7 +1085,10 @@ class LoRa_AT_Modem {
    * was not enabled.
    */
   bool enableChannel(int pos, bool enable = true) {
-    return thisModem().enableChannelImpl(pos, enable);
+    if (pos < 0 || pos >= MAX_LORA_CHANNELS) { return false; }
+    LoRa_AT_ChannelMask mask;
+    if (!getChannelMask(mask)) { return false; }
+    return setChannelMask(mask.set(pos, enable));
   }
 
   /**
@@ -713,9 +1099,34 @@ class LoRa_AT_Modem {
    * was not disabled.
    */
   bool disableChannel(int pos) {
-    return thisModem().enableChannelImpl(pos, false);
+    return enableChannel(pos, false);
   }
 
+  /**
+   * @brief Sends a new channel mask to the device
+   *
+   * If the current mask is remembered, the new mask is compared to it and
+   * only the channels that change are sent to the module. Otherwise the
+   * module reads or replaces the whole mask, whichever takes fewer commands.
+   *
+   * @param newMask The new channel mask
+   * @return True if the module accepted the new channel mask; false if there
+   * was an error in changing the channel mask.
+   */
+  bool setChannelMask(const LoRa_AT_ChannelMask& newMask) {
+    _channelCommands = 0;
+    bool                known   = shadowed(SHADOW_CHANNEL_MASK);
+    LoRa_AT_ChannelMask current = _shadowChannelMask;
+    if (known && current == newMask) { return true; }
+    forgetShadow(SHADOW_SUB_BAND | SHADOW_CHANNEL_MASK);
+    if (!thisModem().applyChannelMaskImpl(newMask,
+                                          known ? &current : nullptr)) {
+      return false;
+    }
+    _shadowChannelMask = newMask;
+    shadowStore(SHADOW_CHANNEL_MASK);
+    return true;
+  }
   /**
    * @brief Sends a new channel mask to the device
    *
@@ -724,7 +1135,12 @@ class LoRa_AT_Modem {
    * was an error in changing the channel mask.
    */
   bool setChannelMask(const char* newMask) {
-    return thisModem().setChannelMaskImpl(newMask);
+    LoRa_AT_ChannelMask mask;
+    if (!LoRa_AT_ChannelMask::parse(newMask, &mask)) {
+      DBG(GF("### Invalid channel mask:"), newMask);
+      return false;
+    }
+    return setChannelMask(mask);
   }
   /**
    * @brief Sends a new channel mask to the device
@@ -736,6 +1152,17 @@ class LoRa_AT_Modem {
   bool setChannelMask(String newMask) {
     return setChannelMask(newMask.c_str());
   }
+
+  /**
+   * @brief Get the number of commands sent to the module by the last call to
+   * setChannelMask(), enableChannel(), disableChannel() or
+   * setFrequencySubBand().
+   *
+   * @return The number of commands sent; 0 if nothing needed to change
+   */
+  uint8_t channelCommandsSent() {
+    return _channelCommands;
+  }
   /**@}*/
 
   /**
@@ -756,7 +1183,15 @@ class LoRa_AT_Modem {
    * cycle.
    */
   bool enableDutyCycle(bool dutyCycle) {
-    return thisModem().enableDutyCycleImpl(dutyCycle);
+    if (shadowKept(SHADOW_DUTY_CYCLE, _shadowDutyCycle == dutyCycle)) {
+      return true;
+    }
+    // on some modules the limit and whether it's enabled are the same setting
+    forgetShadow(SHADOW_DUTY_CYCLE | SHADOW_MAX_DUTY_CYCLE);
+    if (!thisModem().enableDutyCycleImpl(dutyCycle)) { return false; }
+    _shadowDutyCycle = dutyCycle;
+    shadowWritten(SHADOW_DUTY_CYCLE);
+    return true;
   }
   /**
    * @brief Checks if duty cycle limitations are enabled
@@ -765,7 +1200,11 @@ class LoRa_AT_Modem {
    * limitations are not enabled
    */
   bool isDutyCycleEnabled() {
-    return thisModem().isDutyCycleEnabledImpl();
+    if (!shadowed(SHADOW_DUTY_CYCLE) &&
+        thisModem().isDutyCycleEnabledImpl(_shadowDutyCycle)) {
+      shadowStore(SHADOW_DUTY_CYCLE);
+    }
+    return _shadowDutyCycle;
   }
 
   /**
@@ -782,7 +1221,15 @@ class LoRa_AT_Modem {
    * there was an error in changing the maximum duty cycle.
    */
   bool setMaxDutyCycle(int8_t maxDutyCycle) {
-    return thisModem().setMaxDutyCycleImpl(maxDutyCycle);
+    if (shadowKept(SHADOW_MAX_DUTY_CYCLE,
+                   _shadowMaxDutyCycle == maxDutyCycle)) {
+      return true;
+    }
+    forgetShadow(SHADOW_DUTY_CYCLE | SHADOW_MAX_DUTY_CYCLE);
+    if (!thisModem().setMaxDutyCycleImpl(maxDutyCycle)) { return false; }
+    _shadowMaxDutyCycle = maxDutyCycle;
+    shadowWritten(SHADOW_MAX_DUTY_CYCLE);
+    return true;
   }
   /**
    * @brief Get the current duty cycle for the LoRa module
@@ -792,7 +1239,11 @@ class LoRa_AT_Modem {
    * @return An int representing the duty cycle, per the module documentation
    */
   int8_t getMaxDutyCycle() {
-    return thisModem().getMaxDutyCycleImpl();
+    if (!shadowed(SHADOW_MAX_DUTY_CYCLE) &&
+        thisModem().getMaxDutyCycleImpl(_shadowMaxDutyCycle)) {
+      shadowStore(SHADOW_MAX_DUTY_CYCLE);
+    }
+    return _shadowMaxDutyCycle;
   }
 
   /**
@@ -804,15 +1255,32 @@ class LoRa_AT_Modem {
    * an error in changing the data rate.
    */
   bool setDataRate(uint8_t dataRate) {
-    return thisModem().setDataRateImpl(dataRate);
+    if (shadowKept(SHADOW_DATA_RATE, _shadowDataRate == dataRate)) {
+      return true;
+    }
+    forgetShadow(SHADOW_DATA_RATE);
+    bool success = thisModem().setDataRateImpl(dataRate);
+    thisModem().planDataRate(success ? dataRate : -1);
+    if (success) {
+      _settingWrites++;
+      shadowDataRate(dataRate);
+    }
+    return success;
   }
   /**
    * @brief Get the current Tx data rate for the LoRa module
    *
-   * @return An int representing the Tx data rate, per the module documentation
+   * @return An int representing the Tx data rate, per the module
+   * documentation; -1 if it could not be read
    */
   int8_t getDataRate() {
-    return thisModem().getDataRateImpl();
+    int8_t dataRate = _shadowDataRate;
+    if (!shadowed(SHADOW_DATA_RATE) && !thisModem().getDataRateImpl(dataRate)) {
+      return -1;
+    }
+    thisModem().planDataRate(dataRate);
+    shadowDataRate(dataRate);
+    return dataRate;
   }
 
   /**
@@ -826,7 +1294,12 @@ class LoRa_AT_Modem {
    * false if there was an error in changing the adaptive data rate setting.
    */
   bool setAdaptiveDataRate(bool useADR) {
-    return thisModem().setAdaptiveDataRateImpl(useADR);
+    if (shadowKept(SHADOW_ADR, _shadowADR == useADR)) { return true; }
+    forgetShadow(SHADOW_ADR | SHADOW_DATA_RATE);
+    if (!thisModem().setAdaptiveDataRateImpl(useADR)) { return false; }
+    _shadowADR = useADR;
+    shadowWritten(SHADOW_ADR);
+    return true;
   }
   /**
    * @brief Checks whether adaptive data rate is currently enabled for the LoRa
@@ -839,7 +1312,11 @@ class LoRa_AT_Modem {
    * is disabled
    */
   bool getAdaptiveDataRate() {
-    return thisModem().getAdaptiveDataRateImpl();
+    if (!shadowed(SHADOW_ADR) &&
+        thisModem().getAdaptiveDataRateImpl(_shadowADR)) {
+      shadowStore(SHADOW_ADR);
+    }
+    return _shadowADR;
   }
   /**@}*/
 
@@ -856,7 +1333,20 @@ class LoRa_AT_Modem {
    * @return The device address (network address)
    */
   String getDevAddr() {
-    return thisModem().getDevAddrImpl();
+    char buff[LORA_AT_STRING_BUFFER];
+    getDevAddr(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get the device address (network address) into a buffer, without
+   * using a String.
+   *
+   * @param buff The buffer to write to
+   * @param size The size of the buffer
+   * @return True if the value was read
+   */
+  bool getDevAddr(char* buff, size_t size) {
+    return thisModem().getDevAddrImpl(buff, size);
   }
   // network session key
   /**
@@ -867,7 +1357,19 @@ class LoRa_AT_Modem {
    * @return The network session key
    */
   String getNwkSKey() {
-    return thisModem().getNwkSKeyImpl();
+    char buff[LORA_AT_STRING_BUFFER];
+    getNwkSKey(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get the network session key into a buffer, without using a String.
+   *
+   * @param buff The buffer to write to
+   * @param size The size of the buffer
+   * @return True if the value was read
+   */
+  bool getNwkSKey(char* buff, size_t size) {
+    return thisModem().getNwkSKeyImpl(buff, size);
   }
   // aka data session key
   /**
@@ -878,7 +1380,20 @@ class LoRa_AT_Modem {
    * @return The App Session Key (data session key)
    */
   String getAppSKey() {
-    return thisModem().getAppSKeyImpl();
+    char buff[LORA_AT_STRING_BUFFER];
+    getAppSKey(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get the App Session Key (data session key) into a buffer, without
+   * using a String.
+   *
+   * @param buff The buffer to write to
+   * @param size The size of the buffer
+   * @return True if the value was read
+   */
+  bool getAppSKey(char* buff, size_t size) {
+    return thisModem().getAppSKeyImpl(buff, size);
   }
   /**@}*/
 
@@ -895,7 +1410,19 @@ class LoRa_AT_Modem {
    * @return The App EUI
    */
   String getAppEUI() {
-    return thisModem().getAppEUIImpl();
+    char buff[LORA_AT_STRING_BUFFER];
+    getAppEUI(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get the App EUI into a buffer, without using a String.
+   *
+   * @param buff The buffer to write to
+   * @param size The size of the buffer
+   * @return True if the value was read
+   */
+  bool getAppEUI(char* buff, size_t size) {
+    return thisModem().getAppEUIImpl(buff, size);
   }
   /**
    * @brief Get the App Key (network key)
@@ -905,7 +1432,19 @@ class LoRa_AT_Modem {
    * @return The App Key
    */
   String getAppKey() {
-    return thisModem().getAppKeyImpl();
+    char buff[LORA_AT_STRING_BUFFER];
+    getAppKey(buff, sizeof(buff));
+    return String(buff);
+  }
+  /**
+   * @brief Get the App Key into a buffer, without using a String.
+   *
+   * @param buff The buffer to write to
+   * @param size The size of the buffer
+   * @return True if the value was read
+   */
+  bool getAppKey(char* buff, size_t size) {
+    return thisModem().getAppKeyImpl(buff, size);
   }
   /**@}*/
 
@@ -942,110 +1481,136 @@ class LoRa_AT_Modem {
   }
 
   bool testATImpl(uint32_t timeout_ms) {
-    for (uint32_t start = millis(); millis() - start < timeout_ms;) {
+    for (uint32_t start = LORA_AT_MILLIS();
+         LORA_AT_MILLIS() - start < timeout_ms;) {
       thisModem().sendAT(GF(""));
       if (thisModem().waitResponse(200) == 1) { return true; }
-      delay(100);
+      LORA_AT_DELAY(100);
     }
     return false;
   }
 
-  // TODO(vshymanskyy): Optimize this!
-  int8_t waitResponseImpl(uint32_t timeout_ms, String& data, GsmConstStr r1,
+  // The response text is collected into a String, or handed one character at
+  // a time to any other reader with append(char) and clear()
+  static void responseAppend(String* data, char c) {
+    *data += c;
+  }
+  static void responseClear(String* data) {
+    *data = "";
+  }
+  template <typename Reader>
+  static void responseAppend(Reader* reader, char c) {
+    reader->append(c);
+  }
+  template <typename Reader>
+  static void responseClear(Reader* reader) {
+    reader->clear();
+  }
+#ifdef LORA_AT_DEBUG
+  static String responseText(String* data) {
+    return *data;
+  }
+  static String responseText(LoRa_AT_ResponseBuffer* data) {
+    return String(data->c_str());
+  }
+#endif
+
+  // Reads everything the modem has already sent, handling URCs, and returns
+  // the index of the first expected response matched; 0 if none has been
+  // matched yet. This never waits for more characters to arrive.
+  template <typename Data>
+  int8_t pollResponseImpl(LoRa_AT_ResponseMatcher& matcher, Data* data) {
+    while (thisModem().stream.available() > 0) {
+      LORA_AT_YIELD();
+      int8_t a = thisModem().stream.read();
+      if (a <= 0) continue;  // Skip 0x00 bytes, just in case
+      if (data) { responseAppend(data, static_cast<char>(a)); }
+      int8_t index = matcher.push(static_cast<char>(a));
+      if (index) { return index; }
+#if defined LORA_AT_DEBUG
+      else if (matcher.endsWith(GFP(LORA_VERBOSE))) {
+        // check how long the new line is
+        // should be either 1 ('\r' or '\n') or 2 ("\r\n"))
+        int len_atnl = strnlen(AT_NL, 3);
+        // Read out the verbose message, until the last character of the new
+        // line.  Use AT_NL[len_atnl-1], not AT_NL[len_atnl], because we're
+        // looking for the last character, not the closing '\0' of the string
+        // buffer.
+        String verbose = thisModem().stream.readStringUntil(
+            AT_NL[len_atnl - 1]);
+#if defined(LORA_AT_DEBUG) and !defined(DUMP_LORA_AT_COMMANDS)
+        verbose.trim();
+        DBG(GF("Verbose details <<<"), GFP(LORA_VERBOSE), verbose, GF(">>>"));
+#endif
+        matcher.clear();
+        if (data) { responseClear(data); }
+        // NOTE: Do **NOT** return!  Keep listening for the requested
+        // response!
+      }
+#endif
+      else if (thisModem().handleURCs(matcher)) {
+        matcher.clear();
+        if (data) { responseClear(data); }
+      }
+    }
+    return 0;
+  }
+
+  // NOTE: The data is only collected if a String or buffer is given; matching
+  // and URC handling never depend on it.
+  template <typename Data>
+  int8_t waitResponseImpl(uint32_t timeout_ms, Data* data, GsmConstStr r1,
                           GsmConstStr r2, GsmConstStr r3, GsmConstStr r4,
                           GsmConstStr r5, GsmConstStr r6, GsmConstStr r7) {
-    data.reserve(LORA_AT_RX_BUFFER);
 #ifdef LORA_AT_DEBUG_DEEP
     DBG(GF("r1 <"), r1 ? r1 : GF("NULL"), GF("> r2 <"), r2 ? r2 : GF("NULL"),
         GF("> r3 <"), r3 ? r3 : GF("NULL"), GF("> r4 <"), r4 ? r4 : GF("NULL"),
         GF("> r5 <"), r5 ? r5 : GF("NULL"), GF("> r6 <"), r6 ? r6 : GF("NULL"),
         GF("> r7 <"), r7 ? r7 : GF("NULL"), '>');
 #endif
-    uint8_t  index       = 0;
-    uint32_t startMillis = millis();
+    LoRa_AT_ResponseMatcher matcher(r1, r2, r3, r4, r5, r6, r7);
+    if (!matcher.valid()) {
+      DBG(GF("### Response longer than LORA_AT_MATCH_WINDOW, not waiting"));
+      if (data) { responseClear(data); }
+      return 0;
+    }
+    int8_t   index       = 0;
+    uint32_t startMillis = LORA_AT_MILLIS();
     do {
       LORA_AT_YIELD();
-      while (thisModem().stream.available() > 0) {
-        LORA_AT_YIELD();
-        int8_t a = thisModem().stream.read();
-        if (a <= 0) continue;  // Skip 0x00 bytes, just in case
-        data += static_cast<char>(a);
-        if (r1 && data.endsWith(r1)) {
-          index = 1;
-          goto finish;
-        } else if (r2 && data.endsWith(r2)) {
-          index = 2;
-          goto finish;
-        } else if (r3 && data.endsWith(r3)) {
-          index = 3;
-          goto finish;
-        } else if (r4 && data.endsWith(r4)) {
-          index = 4;
-          goto finish;
-        } else if (r5 && data.endsWith(r5)) {
-          index = 5;
-          goto finish;
-        } else if (r6 && data.endsWith(r6)) {
-          index = 6;
-          goto finish;
-        } else if (r7 && data.endsWith(r7)) {
-          index = 7;
-          goto finish;
-        }
-#if defined LORA_AT_DEBUG
-        else if (data.endsWith(GFP(LORA_VERBOSE))) {
-          // check how long the new line is
-          // should be either 1 ('\r' or '\n') or 2 ("\r\n"))
-          int len_atnl = strnlen(AT_NL, 3);
-          // Read out the verbose message, until the last character of the new
-          // line.  Use AT_NL[len_atnl-1], not AT_NL[len_atnl], because we're
-          // looking for the last character, not the closing '\0' of the string
-          // buffer.
-          data += thisModem().stream.readStringUntil(AT_NL[len_atnl - 1]);
-#if defined(LORA_AT_DEBUG) and !defined(DUMP_LORA_AT_COMMANDS)
-          data.trim();
-          DBG(GF("Verbose details <<<"), data, GF(">>>"));
-#endif
-          data = "";
-          // NOTE: Do **NOT** go to finish!  Keep listening for the requested
-          // response!
-        }
-#endif
-        else if (thisModem().handleURCs(data)) {
-          data = "";
-        }
-      }
-    } while (millis() - startMillis < timeout_ms);
+      index = thisModem().pollResponseImpl(matcher, data);
+      if (index) { goto finish; }
+    } while (LORA_AT_MILLIS() - startMillis < timeout_ms);
   finish:
+#ifdef LORA_AT_DEBUG
+    String dbg_data = data ? responseText(data) : matcher.toString();
 #ifdef LORA_AT_DEBUG_DEEP
-    data.replace("\r", "←");
-    data.replace("\n", "↓");
+    dbg_data.replace("\r", "←");
+    dbg_data.replace("\n", "↓");
 #endif
     if (!index) {
-      data.trim();
-      if (data.length()) { DBG("### Unhandled:", data); }
-      data = "";
+      dbg_data.trim();
+      if (dbg_data.length()) { DBG("### Unhandled:", dbg_data); }
     } else {
 #ifdef LORA_AT_DEBUG_DEEP
-      DBG('<', index, '>', data);
+      DBG('<', index, '>', dbg_data);
 #endif
     }
+#endif
+    if (!index && data) { responseClear(data); }
     return index;
   }
 
-  String getDevEUIImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  // The buffer versions of the getters write the text the String versions
+  // would return, even on failure, so the String versions are only wrappers
+  bool getDevEUIImpl(char* buff, size_t size) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
-  String getModuleInfoImpl() {
+  bool getModuleInfoImpl(char* buff, size_t size) {
+    LoRa_AT_ResponseBuffer res(buff, size);
     thisModem().sendAT(GF("I"));
-    String res;
-    if (thisModem().waitResponse(1000L, res) != 1) { return ""; }
-    // Do the replaces twice so we cover both \r and \r\n type endings
-    res.replace("\r\nOK\r\n", "");
-    res.replace("\rOK\r", "");
-    res.replace("\r\n", " ");
-    res.replace("\r", " ");
-    res.trim();
-    return res;
+    if (thisModem().waitResponse(1000L, res) != 1) { return false; }
+    res.joinLines();
+    return true;
   }
 
   bool factoryDefaultImpl() {
@@ -1070,18 +1635,24 @@ class LoRa_AT_Modem {
    */
  protected:
   bool setPublicNetworkImpl(bool isPublic) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  bool getPublicNetworkImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getPublicNetworkImpl(bool& isPublic) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
   bool
   setConfirmationRetriesImpl(int8_t numAckRetries) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  int8_t getConfirmationRetriesImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getConfirmationRetriesImpl(int8_t& numAckRetries)
+      LORA_AT_ATTR_NOT_IMPLEMENTED;
 
   bool joinOTAAImpl(const char* appEui, const char* appKey, const char* devEui,
                     int8_t attempts, uint32_t initialBackoff,
                     bool useHex) LORA_AT_ATTR_NOT_IMPLEMENTED;
-
-  bool joinABPImpl(String devAddr, String nwkSKey, String appSKey,
-                   int uplinkCounter, int downlinkCounter, int8_t attempts,
+  bool beginJoinOTAAImpl(const char* appEui, const char* appKey,
+                         const char* devEui, int8_t attempts,
+                         uint32_t initialBackoff,
+                         bool     useHex) LORA_AT_ATTR_NOT_IMPLEMENTED;
+
+  bool joinABPImpl(const char* devAddr, const char* nwkSKey,
+                   const char* appSKey, int uplinkCounter, int downlinkCounter,
+                   int8_t   attempts,
                    uint32_t initialBackoff) LORA_AT_ATTR_NOT_IMPLEMENTED;
   bool isNetworkConnectedImpl(int8_t attempts, uint32_t initialBackoff)
       LORA_AT_ATTR_NOT_IMPLEMENTED;
@@ -1093,110 +1664,57 @@ class LoRa_AT_Modem {
    * LoRa Class and Band functions
    */
 
-  bool        setClassImpl(_lora_class _class) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  _lora_class getClassImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
-
-  bool    setPortImpl(uint8_t _port) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  uint8_t getPortImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
-
-  bool   setBandImpl(const char* band) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  String getBandImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
-
-  bool   setFrequencySubBandImpl(int8_t subBand) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  int8_t getFrequencySubBandImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool setClassImpl(_lora_class _class) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getClassImpl(_lora_class& _class) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
-  String getChannelMaskImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool setPortImpl(uint8_t _port) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getPortImpl(uint8_t& _port) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
-  bool isChannelEnabledImpl(int pos) {
-    // Populate channelsMask array
-    int    max_retry        = 3;
-    int    retry            = 0;
-    String channel_mask_str = "";
-    while (retry < max_retry) {
-      channel_mask_str = thisModem().getChannelMask();
-      if (channel_mask_str.length() > 1) { break; }
-      retry++;
-    }
-    uint8_t channelsMask[LORA_CHANNEL_BYTES];
-    // parse the hex mask into a bit array
-    parseChannelMask(channel_mask_str.c_str(), channelsMask);
-    // get the channel position in the array
-    int row = getChannelOffset(pos);
-    // convert the channel position into a mask
-    uint8_t channel = getChannelBitMask(pos);
-
-    bool channelEnabled = (channelsMask[row] & channel) > 0;
-
-    return channelEnabled;
-  }
-
-  bool enableChannelImpl(int pos, bool enable) {
-    // Populate channelsMask array
-    int    max_retry        = 3;
-    int    retry            = 0;
-    String channel_mask_str = "";
-    while (retry < max_retry) {
-      channel_mask_str = thisModem().getChannelMask();
-      if (channel_mask_str != "0") { break; }
-      retry++;
-    }
-
-    uint8_t channelsMask[LORA_CHANNEL_BYTES] = {0};
-    // parse the hex mask into a bit array
-    parseChannelMask(channel_mask_str.c_str(), channelsMask);
-
-    // get the channel position in the array
-    int row = getChannelOffset(pos);
-    // convert the channel position into a mask
-    uint8_t mask = getChannelBitMask(pos);
-    // DBG("Channel Mask:", dbg_print_bin(mask));
-    // DBG("Row Mask    :", dbg_print_bin(channelsMask[row]));
-    if (enable) {
-      // or with the mask if we're enabling the channel
-      channelsMask[row] = channelsMask[row] | mask;
-    } else {
-      // and with the inverted mask if we're disabling the channel
-      channelsMask[row] = channelsMask[row] & ~mask;
-    }
-    // DBG("Masked Row  :", dbg_print_bin(channelsMask[row]),
-    //     enable ? "(enabling)" : "(disabling)");
+  bool setBandImpl(const char* band) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getBandImpl(char* buff, size_t size) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
-    return thisModem().setChannelMask(createHexChannelMask(channelsMask));
-  }
+  bool setFrequencySubBandImpl(int8_t subBand) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getFrequencySubBandImpl(int8_t& subBand) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
-  bool setChannelMaskImpl(const char* newMask) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getChannelMaskImpl(LoRa_AT_ChannelMask& mask)
+      LORA_AT_ATTR_NOT_IMPLEMENTED;
+  // Sends the channels of newMask that differ from the current mask, if it's
+  // known, and adds each command sent to _channelCommands
+  bool applyChannelMaskImpl(const LoRa_AT_ChannelMask& newMask,
+                            const LoRa_AT_ChannelMask* current)
+      LORA_AT_ATTR_NOT_IMPLEMENTED;
 
   /*
    * LoRa Data Rate and Duty Cycle functions
    */
-  bool   enableDutyCycleImpl(bool dutyCycle) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  bool   isDutyCycleEnabledImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
-  bool   setMaxDutyCycleImpl(int8_t maxDutyCycle) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  int8_t getMaxDutyCycleImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
-  bool   setDataRateImpl(uint8_t dataRate) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  int8_t getDataRateImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
-  bool   setAdaptiveDataRateImpl(bool useADR) LORA_AT_ATTR_NOT_IMPLEMENTED;
-  bool   getAdaptiveDataRateImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool enableDutyCycleImpl(bool dutyCycle) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool isDutyCycleEnabledImpl(bool& dutyCycle) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool setMaxDutyCycleImpl(int8_t maxDutyCycle) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getMaxDutyCycleImpl(int8_t& maxDutyCycle) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool setDataRateImpl(uint8_t dataRate) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getDataRateImpl(int8_t& dataRate) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool setAdaptiveDataRateImpl(bool useADR) LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getAdaptiveDataRateImpl(bool& useADR) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
 
   /*
    * LoRa ABP Session Properties
    */
   // aka network address
-  String getDevAddrImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getDevAddrImpl(char* buff, size_t size) LORA_AT_ATTR_NOT_IMPLEMENTED;
   // network session key
-  String getNwkSKeyImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getNwkSKeyImpl(char* buff, size_t size) LORA_AT_ATTR_NOT_IMPLEMENTED;
   // aka data session key
-  String getAppSKeyImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getAppSKeyImpl(char* buff, size_t size) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
 
   /*
    * LoRa OTAA Session Properties
    */
   // aka network id
-  String getAppEUIImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getAppEUIImpl(char* buff, size_t size) LORA_AT_ATTR_NOT_IMPLEMENTED;
   // aka network key
-  String getAppKeyImpl() LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getAppKeyImpl(char* buff, size_t size) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
   /*
    Utilities
@@ -1262,6 +1780,85 @@ class LoRa_AT_Modem {
     return thisModem().stream.find(const_cast<char*>(&target), 1);
   }
 
+  /**
+   * @brief Read characters from the modem into a buffer up to a terminating
+   * character, in place of Stream::readStringUntil().
+   *
+   * The terminator is read but not kept. Characters that don't fit in the
+   * buffer are read and dropped so the modem stream stays in step.
+   *
+   * @param terminator The character that ends the text
+   * @param buff The buffer to write to; always null terminated
+   * @param size The size of the buffer
+   * @return The number of characters written to the buffer
+   */
+  size_t streamReadUntil(char terminator, char* buff, size_t size) {
+    LoRa_AT_ResponseBuffer text(buff, size);
+    char                   c;
+    while (thisModem().stream.readBytes(&c, 1) == 1 && c != terminator) {
+      text.append(c);
+    }
+    return text.length();
+  }
+
+  /**
+   * @brief Read hex characters from the modem and decode them directly into
+   * the free space of a FIFO, stopping at a terminating character.
+   *
+   * The characters are read one at a time using the stream's timeout, so the
+   * stack use does not depend on the length of the data. Characters that are
+   * not hex are skipped. If the FIFO fills, the rest of the data is read and
+   * dropped so the modem stream stays in step. A trailing unpaired hex
+   * character (an odd-length payload) is dropped.
+   *
+   * @param fifo The FIFO to decode into
+   * @param terminator The character that ends the hex data
+   * @return The number of decoded bytes added to the FIFO
+   */
+  template <class Fifo>
+  int streamReadHex(Fifo& fifo, char terminator) {
+    int      added   = 0;
+    int      dropped = 0;
+    int      room    = 0;
+    int      used    = 0;
+    uint8_t* dst     = fifo.reserve(room);
+    int8_t   high    = -1;
+    char     c;
+    while (true) {
+      if (thisModem().stream.readBytes(&c, 1) != 1) {
+        DBG(GF("### Hex data truncated after"), added + dropped, GF("bytes"));
+        break;
+      }
+      if (c == terminator) { break; }
+      int8_t nibble = LoRa_AT_HexValue(c);
+      if (nibble < 0) { continue; }
+      if (high < 0) {
+        high = nibble;
+        continue;
+      }
+      if (used == room) {
+        // the reserved span ended; it may continue at the start of the array
+        fifo.commit(used);
+        added += used;
+        used = 0;
+        dst  = fifo.reserve(room);
+      }
+      if (room) {
+        dst[used++] = (high << 4) | nibble;
+      } else {
+        dropped++;
+      }
+      high = -1;
+    }
+    fifo.commit(used);
+    added += used;
+    if (high >= 0) { DBG(GF("### Dropped unpaired hex character")); }
+    if (dropped) {
+      DBG(GF("### Buffer overflow, dropped"), dropped, GF("bytes"));
+    }
+    return added;
+  }
+
 #if !defined(LORA_AT_SEND_PLAIN)
 /**
  * @brief A flag to force data to be sent as characters instead of as hex
@@ -1274,104 +1871,35 @@ class LoRa_AT_Modem {
  * the text.
  */
 #define LORA_AT_SEND_HEX
-  // A function to convert a character/uint8_t buffer to hex
+  /**
+   * @brief Write a buffer to the modem as upper-case hex characters.
+   *
+   * The hex characters are looked up from a table and collected in a small
+   * chunk on the stack, so the stream is written once per chunk instead of
+   * twice per byte.
+   *
+   * @param buf The buffer to write
+   * @param size The number of bytes in the buffer
+   */
   void writeHex(const uint8_t* buf, size_t size) {
+    char   chunk[LORA_AT_HEX_CHUNK];
+    size_t n = 0;
     for (size_t i = 0; i < size; i++) {
-      if (buf[i] < 16) thisModem().stream.print('0');
-      thisModem().stream.print(buf[i], HEX);
+      chunk[n++] = hex_chars[buf[i] >> 4];
+      chunk[n++] = hex_chars[buf[i] & 0x0F];
+      if (n == LORA_AT_HEX_CHUNK) {
+        thisModem().stream.write(reinterpret_cast<const uint8_t*>(chunk), n);
+        n = 0;
+      }
     }
-  }
-  // A function to convert a character/uint8_t buffer to hex
-  void writeHex(uint8_t* buf, size_t size) {
-    for (size_t i = 0; i < size; i++) {
-      if (buf[i] < 16) thisModem().stream.print('0');
-      thisModem().stream.print(buf[i], HEX);
+    if (n) {
+      thisModem().stream.write(reinterpret_cast<const uint8_t*>(chunk), n);
     }
   }
 #else
 #define writeHex(...)
 #endif
 
-  void parseChannelMask(const char* mask, uint8_t* channelsMask) {
-    // the input mask must be MSB - most significant first
-    if (strlen(mask) > 0) {
-      size_t startByte = 0;
-      // If we got a 20 character mask, assume the first two bytes are 00's and
-      // skip them. This will be the case for the mDot.
-      if (strlen(mask) == 20) { startByte = 2; }
-      for (size_t i = startByte; i < strlen(mask); i += 2) {
-        char hexBuff[3] = {'\0'};
-        hexBuff[0]      = mask[i];
-        hexBuff[1]      = mask[i + 1];
-        // DBG(strlen(mask), startByte, i, ((strlen(mask) - i) / 2) - 1,
-        //     (int8_t)strtol(hexBuff, nullptr, 16),
-        //     dbg_print_bin((int8_t)strtol(hexBuff, nullptr, 16)));
-        channelsMask[((strlen(mask) - i) / 2) - 1] =
-            (int8_t)strtol(hexBuff, nullptr, 16);
-      }
-      // #ifdef LORA_AT_DEBUG
-      //       DBG(GF("Input mask:"), mask);
-      //       LORA_AT_DEBUG.print(GF("Input mask in binary: "));
-      //       for (int8_t j = 0; j < LORA_CHANNEL_BYTES; j++) {
-      //         LORA_AT_DEBUG.print(dbg_print_bin(channelsMask[j]));
-      //         LORA_AT_DEBUG.print(',');
-      //       }
-      //       LORA_AT_DEBUG.println();
-      // #endif
-    }
-  }
-
-  String createHexChannelMask(uint8_t* channelsMask) {
-    // #ifdef LORA_AT_DEBUG
-    //     LORA_AT_DEBUG.print(GF("Mask array in binary:"));
-    //     for (int8_t j = 0; j < LORA_CHANNEL_BYTES; j++) {
-    //       LORA_AT_DEBUG.print(dbg_print_bin(channelsMask[j]));
-    //       LORA_AT_DEBUG.print(',');
-    //     }
-    //     LORA_AT_DEBUG.println();
-    // #endif
-    // convert the completed channel mask to a string, switching endian-ness
-    String resp = "";
-    for (int8_t i = LORA_CHANNEL_BYTES - 1; i > -1; i--) {
-      if (channelsMask[i] < 16) { resp += '0'; }  // must zero pad!
-      resp += String(channelsMask[i], HEX);
-      // DBG(i, channelsMask[i], dbg_print_bin(channelsMask[i]),
-      //     String(channelsMask[i], HEX));
-    }
-    // DBG(GF("Mask array in HEX:"), resp);
-    return resp;
-  }
-
-  uint8_t getChannelBitMask(uint8_t channelNumber) {
-    // get the channel position in the array
-    int col = channelNumber % 8;
-    // convert the channel position into a mask
-    uint8_t channel = (uint8_t)(1 << col);
-    // #ifdef LORA_AT_DEBUG
-    //     int row = channelNumber / 8;
-    //     DBG(GF("\nChannel Number:"), channelNumber, GF("Row:"), row,
-    //     GF("Col:"),
-    //         col);
-    //     LORA_AT_DEBUG.print(GF("Channel Mask:         "));
-    //     for (int8_t j = 0; j < LORA_CHANNEL_BYTES; j++) {
-    //       if (j == row) {
-    //         LORA_AT_DEBUG.print(dbg_print_bin(channel));
-    //       } else {
-    //         LORA_AT_DEBUG.print("00000000");
-    //       }
-    //       LORA_AT_DEBUG.print(',');
-    //     }
-    //     LORA_AT_DEBUG.println();
-    // #endif
-    return channel;
-  }
-
-  uint8_t getChannelOffset(uint8_t channelNumber) {
-    // get the channel position in the array
-    int row = channelNumber / 8;
-    return row;
-  }
-
   //   String dbg_print_bin(uint8_t num) {
   // #ifdef LORA_AT_DEBUG
   //     String binPrint = "";
@@ -1382,7 +1910,124 @@ class LoRa_AT_Modem {
   // #endif
   // }
 
-  bool _networkConnected;
+  /*
+   * Settings shadow
+   */
+
+  // The settings remembered from the module; each is a bit of _shadowValid
+  enum ShadowSetting : uint16_t {
+    SHADOW_PUBLIC_NETWORK = 0x0001,
+    SHADOW_ACK_RETRIES    = 0x0002,
+    SHADOW_CLASS          = 0x0004,
+    SHADOW_PORT           = 0x0008,
+    SHADOW_SUB_BAND       = 0x0010,
+    SHADOW_CHANNEL_MASK   = 0x0020,
+    SHADOW_DUTY_CYCLE     = 0x0040,
+    SHADOW_MAX_DUTY_CYCLE = 0x0080,
+    SHADOW_DATA_RATE      = 0x0100,
+    SHADOW_ADR            = 0x0200,
+    // the settings the network can change with MAC commands; the data rate
+    // is only remembered while the network isn't allowed to change it
+    SHADOW_NETWORK = SHADOW_SUB_BAND | SHADOW_CHANNEL_MASK |
+        SHADOW_DUTY_CYCLE | SHADOW_MAX_DUTY_CYCLE,
+    SHADOW_ALL = 0xFFFF,
+  };
+
+  bool shadowed(uint16_t settings) const {
+    return (_shadowValid & settings) == settings;
+  }
+  void shadowStore(uint16_t settings) {
+    _shadowValid |= settings;
+  }
+  void forgetShadow(uint16_t settings) {
+    _shadowValid &= ~settings;
+  }
+  // Checks if a setting about to be written already has the value remembered
+  // for it, counting the write as avoided if it does
+  bool shadowKept(uint16_t setting, bool same) {
+    if (shadowed(setting) && same) {
+      _settingWritesAvoided++;
+      return true;
+    }
+    return false;
+  }
+  // Remembers a setting the module has just accepted, counting the write
+  void shadowWritten(uint16_t setting) {
+    _settingWrites++;
+    shadowStore(setting);
+  }
+
+  // Writes the confirmation retries to the module if it doesn't already have
+  // them, without changing the retries asked for by the user
+  bool writeConfirmationRetries(int8_t numAckRetries) {
+    if (shadowKept(SHADOW_ACK_RETRIES, _shadowAckRetries == numAckRetries)) {
+      return true;
+    }
+    forgetShadow(SHADOW_ACK_RETRIES);
+    if (!thisModem().setConfirmationRetriesImpl(numAckRetries)) {
+      return false;
+    }
+    _shadowAckRetries = numAckRetries;
+    shadowWritten(SHADOW_ACK_RETRIES);
+    return true;
+  }
+
+  // Writes the port to the module if it doesn't already have it
+  bool writePort(uint8_t port) {
+    if (shadowKept(SHADOW_PORT, _shadowPort == port)) { return true; }
+    forgetShadow(SHADOW_PORT);
+    if (!thisModem().setPortImpl(port)) { return false; }
+    _shadowPort = port;
+    shadowWritten(SHADOW_PORT);
+    return true;
+  }
+
+  // Puts the port of the next message on the module: its own port if it has
+  // one, or else the port of the messages before the last one that had its
+  // own. The module's port is only changed when the message needs another.
+  bool writeSendPort(int16_t port) {
+    if (port < 0) {
+      if (_restorePort < 0) { return true; }
+      if (!writePort(_restorePort)) { return false; }
+      _restorePort = -1;
+      return true;
+    }
+    if (_restorePort < 0) {
+      uint8_t current = getPort();
+      if (!shadowed(SHADOW_PORT)) { return false; }
+      _restorePort = current;
+    }
+    return writePort(port);
+  }
+
+  // The data rate only stays put while adaptive data rate is known to be off
+  void shadowDataRate(int8_t dataRate) {
+    _shadowDataRate = dataRate;
+    if (shadowed(SHADOW_ADR) && !_shadowADR) { shadowStore(SHADOW_DATA_RATE); }
+  }
+
+  bool    _networkConnected;
+  uint8_t _channelCommands;  ///< Commands sent by the last channel change
+
+  LoRa_AT_LinkHistory _linkHistory;    ///< Recent signal and link reports
+  uint32_t            _linkStaleness;  ///< Age at which reports are too old
+
+  int8_t   _confirmRetries;        ///< Retries set by the user; -1 if none
+  int16_t  _restorePort;           ///< Port to put back after a send; or -1
+  uint32_t _settingWrites;         ///< Settings written to the module
+  uint32_t _settingWritesAvoided;  ///< Settings the module already had
+
+  uint16_t            _shadowValid;         ///< The settings remembered
+  bool                _shadowPublic;        ///< Public network mode
+  int8_t              _shadowAckRetries;    ///< Confirmation retries
+  _lora_class         _shadowClass;         ///< Device class
+  uint8_t             _shadowPort;          ///< Uplink port
+  int8_t              _shadowSubBand;       ///< Frequency sub-band
+  bool                _shadowDutyCycle;     ///< Duty cycle limits enabled
+  int8_t              _shadowMaxDutyCycle;  ///< Maximum duty cycle
+  int8_t              _shadowDataRate;      ///< Uplink data rate
+  bool                _shadowADR;           ///< Adaptive data rate enabled
+  LoRa_AT_ChannelMask _shadowChannelMask;   ///< Channel mask
 };
 
 #endif  // SRC_LORA_AT_MODEM_H_
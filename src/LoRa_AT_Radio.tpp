@@ -12,8 +12,47 @@
 
 #define LORA_AT_HAS_RADIO
 
+#include "LoRa_AT_Airtime.h"
+#include "LoRa_AT_ResponseMatcher.h"
 #include "TinyGsmFifo.h"
 
+/**
+ * @brief How to send one message, for LoRa_AT_Radio::beginSend().
+ *
+ * The options only apply to their own message; later messages sent without
+ * options go back to requireConfirmation(), setConfirmationRetries() and
+ * setPort(). Each setting is only written to the module if the message needs
+ * a different value from the one the module has.
+ *
+ * @code{.cpp}
+ * // confirmed, with up to 5 retries, on port 10
+ * modem.beginSend(alarm, sizeof(alarm), LoRa_AT_SendOptions(true, 5, 10));
+ * @endcode
+ */
+struct LoRa_AT_SendOptions {
+  /**
+   * @brief Construct the options for a message.
+   *
+   * @param confirmed True to ask for confirmation of the message; optional
+   * with a default of false
+   * @param retries The number of retries if a confirmed message is not
+   * acknowledged; optional with a default of -1 to use the retries set with
+   * setConfirmationRetries(). The mDOT can't send a confirmed message without
+   * retries, so it makes one retry when this is 0.
+   * @param port The application port; optional with a default of -1 to use
+   * the port set with setPort()
+   */
+  LoRa_AT_SendOptions(bool confirmed = false, int8_t retries = -1,
+                      int16_t port = -1)
+      : confirmed(confirmed),
+        retries(retries),
+        port(port) {}
+
+  bool    confirmed;  ///< True to ask for confirmation
+  int8_t  retries;    ///< Confirmation retries; -1 for the default
+  int16_t port;       ///< Application port; -1 for the default port
+};
+
 template <class modemType>
 class LoRa_AT_Radio {
   /* =========================================== */
@@ -64,6 +103,221 @@ class LoRa_AT_Radio {
     return _requireConfirmation;
   }
 
+  /**
+   * @brief Ask the module how many bytes of data can be sent in the next
+   * uplink at the current data rate.
+   *
+   * @note MAC commands waiting to go out with the next uplink take up part of
+   * the space, so this may be less than the maximum for the data rate, or
+   * even 0.
+   *
+   * @return The number of bytes that can be sent; -1 if the module did not
+   * answer.
+   */
+  int16_t getMaxPayloadSize() {
+    return thisModem().getMaxPayloadSizeImpl();
+  }
+
+  /**
+   * @brief Tell the payload planner which region the module is using.
+   *
+   * This is also found from the band name each time getBand() is called.
+   *
+   * @param region The region
+   */
+  void setRegion(LoRa_AT_Region region) {
+    _planRegion = region;
+  }
+
+  /**
+   * @brief Get the largest payload for the current data rate from the
+   * regional parameters, without asking the module.
+   *
+   * The data rate is the one last read with getDataRate() or set with
+   * setDataRate(); it is forgotten when the module restarts or joins.
+   *
+   * @note This does not leave room for any MAC commands waiting to go out;
+   * use getMaxPayloadSize() to ask the module for the space it has now.
+   *
+   * @return The number of bytes; -1 if the region or data rate is not known.
+   */
+  int16_t plannedPayloadSize() {
+    if (_planRegion < 0 || _planDataRate < 0) { return -1; }
+    return LoRa_AT_MaxPayload(static_cast<LoRa_AT_Region>(_planRegion),
+                              _planDataRate);
+  }
+
+  /**
+   * @brief Predict how many uplinks a send will be split into.
+   *
+   * @param len The number of bytes to send
+   * @return The number of uplinks if no MAC commands take up space; 0 if the
+   * largest payload is not known.
+   */
+  uint16_t plannedUplinks(size_t len) {
+    int16_t planned = plannedPayloadSize();
+    if (planned <= 0) { return 0; }
+    if (len == 0) { return 1; }
+    return (len + planned - 1) / planned;
+  }
+
+  /**
+   * @brief Attach an airtime budget to check and count every uplink against.
+   *
+   * Before each send the budget is given the data rate the payload planner
+   * has, from the last getDataRate() or setDataRate(); the module is only
+   * asked for it when the planner has forgotten it after a restart, join or
+   * downlink. Each uplink is only sent if it fits within the budget; a send
+   * that does not fit fails. Each uplink the module sends is then counted.
+   *
+   * @param budget The budget; nullptr to stop checking uplinks
+   */
+  void setAirtimeBudget(LoRa_AT_AirtimeBudget* budget) {
+    _airtime = budget;
+  }
+
+  /**
+   * @brief Get how long until an uplink fits within the airtime budget.
+   *
+   * The airtime is worked out at the data rate of the last send.
+   *
+   * @param len The number of bytes to send
+   * @return The time in milliseconds; 0 if it can be sent now or no budget is
+   * attached, or 0xFFFFFFFF if it is too long to ever fit
+   */
+  uint32_t timeUntilSendAllowed(size_t len) {
+    if (!_airtime) { return 0; }
+    return _airtime->timeUntilAllowed(len);
+  }
+
+  /**
+   * @brief Start sending a buffer without waiting for the module to finish.
+   *
+   * The send is carried out by later calls to poll(), using the same AT
+   * command sequence as writing to the LoRaStream. The buffer must not be
+   * changed or freed until sendStatus() is no longer #LORA_AT_SEND_BUSY, and
+   * no other modem functions should be called in the mean time.
+   *
+   * @note Some modules need a few short configuration commands before the
+   * send starts; those are still sent and answered within this call.
+   *
+   * @param buff The buffer of data to send
+   * @param len The number of bytes to send; 0 to send an empty uplink
+   * @param whole True if the buffer must be sent as a single uplink, never
+   * split; empty uplinks are sent to flush pending MAC commands while the
+   * module has no room at all, and the send fails if the room it has is too
+   * small. Optional with a default value of false.
+   * @return True if the send was started; false if another send is still in
+   * progress, the module did not take back the port of setPort() after a
+   * message with a port of its own, or a buffer that must not be split is
+   * longer than the largest payload of the data rate, in which case
+   * sendStatus() is #LORA_AT_SEND_FAILED.
+   */
+  bool beginSend(const uint8_t* buff, size_t len, bool whole = false) {
+    return beginMessage(buff, len, whole, _requireConfirmation, -1, -1);
+  }
+
+  /**
+   * @brief Start sending a buffer with its own confirmation, retries and
+   * port, without waiting for the module to finish.
+   *
+   * The options are only used for this message: requireConfirmation(),
+   * getPort() and the retries set with setConfirmationRetries() are not
+   * changed by them, and the next message sent without options puts the
+   * module's port back. The settings the module already has from the last
+   * message are not written again; settingWritesAvoided() counts those.
+   *
+   * @param buff The buffer of data to send
+   * @param len The number of bytes to send; 0 to send an empty uplink
+   * @param options How to send the message
+   * @param whole True if the buffer must be sent as a single uplink, never
+   * split. Optional with a default value of false.
+   * @return True if the send was started; false if another send is still in
+   * progress, the module did not accept the port or a buffer that must not be
+   * split is longer than the largest payload of the data rate.
+   */
+  bool beginSend(const uint8_t* buff, size_t len,
+                 const LoRa_AT_SendOptions& options, bool whole = false) {
+    return beginMessage(buff, len, whole, options.confirmed, options.retries,
+                        options.port);
+  }
+
+  /**
+   * @brief Move any asynchronous send or join forward without blocking.
+   *
+   * This reads whatever the module has already sent and, if the module has
+   * answered, issues the next command. Call it regularly from the main loop.
+   *
+   * @return True if an operation is still in progress.
+   */
+  bool poll() {
+    return thisModem().pollImpl();
+  }
+
+  /**
+   * @brief Get the state of the most recent send started with beginSend().
+   *
+   * @return The state of the send
+   */
+  LoRa_AT_SendStatus sendStatus() {
+    return _sendStatus;
+  }
+
+  /**
+   * @brief Get the number of bytes of the most recent asynchronous send that
+   * have been accepted by the module so far.
+   *
+   * @return The number of bytes sent
+   */
+  size_t bytesSent() {
+    return _sendDone;
+  }
+
+  /**
+   * @brief Start joining the network, using the keys already set on the
+   * module, without waiting for the module to finish.
+   *
+   * Each attempt and the backoff between attempts are carried out by later
+   * calls to poll(). Between attempts, timeUntilNextJoin() tells how long the
+   * host can sleep before poll() will start the next one.
+   *
+   * @note If the host sleeps in a way that stops the clock used by the
+   * library, define #LORA_AT_MILLIS to a clock that keeps running.
+   *
+   * @param attempts The number of attempts to make before giving up
+   * @param initialBackoff The initial time to wait between attempts; later
+   * waits grow exponentially
+   * @return True if the join was started; false if another send or join is
+   * still in progress.
+   */
+  bool beginJoin(uint8_t  attempts       = DEFAULT_JOIN_ATTEMPTS,
+                 uint32_t initialBackoff = DEFAULT_INITIAL_BACKOFF) {
+    return thisModem().beginJoinImpl(attempts, initialBackoff, false);
+  }
+
+  /**
+   * @brief Get the state of the most recent join started with beginJoin().
+   *
+   * @return The state of the join
+   */
+  LoRa_AT_JoinStatus joinStatus() {
+    return _joinStatus;
+  }
+
+  /**
+   * @brief Get how long until the next join attempt will be made.
+   *
+   * @return The time in milliseconds until poll() will start the next join
+   * attempt; 0 if no join is waiting between attempts.
+   */
+  uint32_t timeUntilNextJoin() {
+    if (_joinStatus != LORA_AT_JOIN_BUSY || !_joinWaiting ||
+        LORA_AT_MILLIS() - _asyncWaitStart >= _asyncWaitTimeout) {
+      return 0;
+    }
+    return _asyncWaitTimeout - (LORA_AT_MILLIS() - _asyncWaitStart);
+  }
+
   /**
    * @anchor radio_crtp_helper
    * @name Radio CRTP Helper
@@ -88,9 +342,12 @@ class LoRa_AT_Radio {
   class LoRaStream : public Stream {
     // Make all classes created from the modem template friends
     friend class LoRa_AT_Radio<modemType>;
-    typedef TinyGsmFifo<uint8_t, LORA_AT_RX_BUFFER> RxFifo;
 
    public:
+    /// The type of the receive buffer
+    typedef TinyGsmFifo<uint8_t, LORA_AT_RX_BUFFER, LORA_AT_RX_FIFO_SPSC>
+        RxFifo;
+
     // bool init(modemType* modem, uint8_t);
 
     // Writes data out on the client using the modem send functionality
@@ -120,8 +377,8 @@ class LoRa_AT_Radio {
       LORA_AT_YIELD();
       size_t cnt = 0;
       // Reads characters out of the TinyGSM fifo
-      uint32_t _startMillis = millis();
-      while (cnt < size && millis() - _startMillis < _timeout) {
+      uint32_t _startMillis = LORA_AT_MILLIS();
+      while (cnt < size && LORA_AT_MILLIS() - _startMillis < _timeout) {
         size_t chunk = LoRa_AT_Min(size - cnt, rx.size());
         if (chunk > 0) {
           rx.get(buf, chunk);
@@ -167,8 +424,9 @@ class LoRa_AT_Radio {
     // data that it wants from the socket even if it was closed externally.
     inline void dumpModemBuffer(uint32_t maxWaitMs) {
       LORA_AT_YIELD();
-      uint32_t startMillis = millis();
-      while (sock_available > 0 && (millis() - startMillis < maxWaitMs)) {
+      uint32_t startMillis = LORA_AT_MILLIS();
+      while (sock_available > 0 &&
+             (LORA_AT_MILLIS() - startMillis < maxWaitMs)) {
         rx.clear();
         at->modemRead();
       }
@@ -193,7 +451,7 @@ class LoRa_AT_Radio {
  protected:
   void maintainImpl() {
     // Check for any new downlinks
-    if (millis() - prev_dl_check > LORA_AT_DL_CHECK &&
+    if (LORA_AT_MILLIS() - prev_dl_check > LORA_AT_DL_CHECK &&
         thisModem()._networkConnected) {
       thisModem().modemRead();  // modemRead should set prev_dl_check
     }
@@ -207,17 +465,253 @@ class LoRa_AT_Radio {
   // into the multicast FIFO
   inline void moveCharFromStreamToFifo() {
     if (!thisModem().loraStream) return;
-    uint32_t startMillis = millis();
+    uint32_t startMillis = LORA_AT_MILLIS();
     while (!thisModem().stream.available() &&
-           (millis() - startMillis < thisModem().loraStream->_timeout)) {
+           (LORA_AT_MILLIS() - startMillis <
+            thisModem().loraStream->_timeout)) {
       LORA_AT_YIELD();
     }
     char c = thisModem().stream.read();
     thisModem().loraStream->rx.put(c);
   }
 
+  bool pollImpl() {
+    if (_sendStatus == LORA_AT_SEND_BUSY) { thisModem().pollSendImpl(); }
+    if (_joinStatus == LORA_AT_JOIN_BUSY) { thisModem().pollJoinImpl(); }
+    return _sendStatus == LORA_AT_SEND_BUSY || _joinStatus == LORA_AT_JOIN_BUSY;
+  }
+
+  // Checks that a new send can start before anything is sent to the module;
+  // returns false if a send or join is still in progress, or fails the send
+  // if a buffer that must not be split can never fit
+  bool canStartSend(size_t len, bool whole) {
+    if (_sendStatus == LORA_AT_SEND_BUSY || _joinStatus == LORA_AT_JOIN_BUSY) {
+      return false;
+    }
+    int16_t planned = plannedPayloadSize();
+    if (whole && planned >= 0 && len > static_cast<size_t>(planned)) {
+      DBG(GF("### A single uplink can't carry"), len, GF("bytes"));
+      _sendLen    = len;
+      _sendDone   = 0;
+      _sendStatus = LORA_AT_SEND_FAILED;
+      return false;
+    }
+    return true;
+  }
+
+  // Resets the send state for a new buffer; returns false if the send can't
+  // start
+  bool startSend(const uint8_t* buff, size_t len, bool whole) {
+    if (!canStartSend(len, whole)) { return false; }
+    // the network may have changed settings with the last downlink, even if
+    // the module didn't report it
+    thisModem().forgetShadow(modemType::SHADOW_NETWORK);
+    // only ask the module for the data rate if the planner doesn't know it
+    if (_airtime) {
+      int8_t dataRate = _planDataRate >= 0 ? _planDataRate
+                                           : thisModem().getDataRate();
+      if (dataRate >= 0) { _airtime->setDataRate(dataRate); }
+    }
+    _sendBuff     = buff;
+    _sendLen      = len;
+    _sendWhole    = whole;
+    _sendDone     = 0;
+    _sendChunk    = 0;
+    _sendAttempts = 0;
+    _sendStep     = 0;
+    _sendStatus   = LORA_AT_SEND_BUSY;
+    return true;
+  }
+
+  // Sets the size of the next uplink from the space the module has for it;
+  // returns false if a buffer that must not be split doesn't fit
+  bool setSendChunk(uint8_t available) {
+    // if the module has the whole regional payload free, no MAC commands are
+    // waiting and the next uplink can be sized without asking again
+    _planMacEmpty = available && available == plannedPayloadSize();
+    // Ensure the program doesn't read past the allocated memory
+    // If there's no space available to send data, the queue is full of
+    // MAC commands and we need to send an empty message to flush them out
+    _sendChunk = LoRa_AT_Min<size_t>(available, _sendLen - _sendDone);
+    // A buffer that must not be split can only wait out a full MAC queue; any
+    // other space too small for it won't grow by sending empty uplinks
+    return !_sendWhole || available == 0 || _sendChunk == _sendLen - _sendDone;
+  }
+
+  // Sizes the next uplink from the regional parameters instead of asking the
+  // module, if it had no MAC commands waiting and nothing has happened since
+  // that could add any; returns false if the module must be asked
+  bool usePlannedChunk() {
+    if (!_planMacEmpty || plannedPayloadSize() <= 0) { return false; }
+    return setSendChunk(plannedPayloadSize());
+  }
+
+  // Forgets what is known about the data rate and MAC commands, after a
+  // downlink, failed uplink or anything else that could change them
+  void forgetPlan(bool dataRate) {
+    _planMacEmpty = false;
+    if (dataRate) { _planDataRate = -1; }
+  }
+
+  // Remembers the current data rate for the payload planner
+  void planDataRate(int8_t dataRate) {
+    if (dataRate != _planDataRate) { _planMacEmpty = false; }
+    _planDataRate = dataRate;
+  }
+
+  // Remembers the region of a band name for the payload planner
+  void planBand(const char* band) {
+    LoRa_AT_Region region;
+    if (LoRa_AT_RegionFromBand(band, &region)) { _planRegion = region; }
+  }
+
+  // Checks the current uplink against the airtime budget, if any
+  bool airtimeAllows() {
+    if (!_airtime) { return true; }
+    uint32_t wait = _airtime->timeUntilAllowed(_sendChunk);
+    if (!wait) { return true; }
+    DBG(GF("### Uplink of"), _sendChunk, GF("bytes is over the duty cycle for"),
+        wait, GF("ms"));
+    return false;
+  }
+
+  // Counts the current uplink against the airtime budget, if any
+  void recordAirtime() {
+    if (_airtime) { _airtime->record(_sendChunk); }
+  }
+
+  // Resets the join state for a new set of attempts; returns false if a send
+  // or join is still in progress
+  bool startJoin(uint8_t attempts, uint32_t initialBackoff, bool force) {
+    if (_sendStatus == LORA_AT_SEND_BUSY || _joinStatus == LORA_AT_JOIN_BUSY) {
+      return false;
+    }
+    _joinAttemptsLeft   = attempts;
+    _joinAttemptsMade   = 0;
+    _joinInitialBackoff = initialBackoff;
+    _joinForce          = force;
+    _joinWaiting        = false;
+    _joinStep           = 0;
+    forgetPlan(true);
+    thisModem().forgetShadow(modemType::SHADOW_NETWORK);
+    _joinStatus = attempts ? LORA_AT_JOIN_BUSY : LORA_AT_JOIN_FAILED;
+    return true;
+  }
+
+  // Ends a failed join attempt; either gives up or waits for the given time
+  // before the next attempt
+  void retryJoin(uint32_t wait_ms) {
+    if (!_joinAttemptsLeft) {
+      _joinStatus = LORA_AT_JOIN_FAILED;
+      return;
+    }
+    DBG(GF("Waiting"), wait_ms, GF("ms before the next join attempt."));
+    _asyncWaitStart   = LORA_AT_MILLIS();
+    _asyncWaitTimeout = wait_ms;
+    _joinWaiting      = true;
+    _joinStep         = 0;
+  }
+
+  // Returns true while waiting between join attempts
+  bool joinBackingOff() {
+    if (!_joinWaiting) { return false; }
+    if (LORA_AT_MILLIS() - _asyncWaitStart < _asyncWaitTimeout) { return true; }
+    _joinWaiting = false;
+    return false;
+  }
+
+  // Starts listening for up to five responses during a send or join
+  void startAsyncWait(uint32_t timeout_ms, GsmConstStr r1,
+                      GsmConstStr r2 = nullptr, GsmConstStr r3 = nullptr,
+                      GsmConstStr r4 = nullptr, GsmConstStr r5 = nullptr) {
+    _asyncMatcher     = LoRa_AT_ResponseMatcher(r1, r2, r3, r4, r5);
+    _asyncWaitStart   = LORA_AT_MILLIS();
+    _asyncWaitTimeout = timeout_ms;
+    if (!_asyncMatcher.valid()) {
+      DBG(GF("### Response longer than LORA_AT_MATCH_WINDOW, not waiting"));
+    }
+  }
+
+  // Checks for a response started with startAsyncWait(); returns the index of
+  // the response, 0 if the wait timed out or can never match, or -1 if still
+  // waiting
+  int8_t pollAsyncWait() {
+    return pollAsyncWait(static_cast<String*>(nullptr));
+  }
+  template <typename Data>
+  int8_t pollAsyncWait(Data* data) {
+    if (!_asyncMatcher.valid()) { return 0; }
+    int8_t index = thisModem().pollResponseImpl(_asyncMatcher, data);
+    if (index) { return index; }
+    if (LORA_AT_MILLIS() - _asyncWaitStart < _asyncWaitTimeout) { return -1; }
+    return 0;
+  }
+
+  // Starts a send with the settings for this message alone, putting the port
+  // on the module before anything else is sent
+  bool beginMessage(const uint8_t* buff, size_t len, bool whole,
+                    bool confirmed, int8_t retries, int16_t port) {
+    if (!canStartSend(len, whole)) { return false; }
+    if (!thisModem().writeSendPort(port)) { return false; }
+    _sendConfirmed = confirmed;
+    _sendRetries   = retries;
+    return thisModem().beginSendImpl(buff, len, whole);
+  }
+
+  // Runs the send to completion, for the blocking stream interface
+  int16_t sendBlocking(const uint8_t* buff, size_t len) {
+    if (!beginMessage(buff, len, false, _requireConfirmation, -1, -1)) {
+      return 0;
+    }
+    while (thisModem().pollSendImpl() == LORA_AT_SEND_BUSY) {
+      LORA_AT_YIELD();
+    }
+    return _sendDone;
+  }
+
+  // Runs the join to completion, delaying through the backoff between attempts
+  bool joinBlocking(uint8_t attempts, uint32_t initialBackoff, bool force) {
+    if (!thisModem().beginJoinImpl(attempts, initialBackoff, force)) {
+      return false;
+    }
+    while (thisModem().pollJoinImpl() == LORA_AT_JOIN_BUSY) {
+      uint32_t wait = timeUntilNextJoin();
+      if (wait) {
+        LORA_AT_DELAY(wait);
+      } else {
+        LORA_AT_YIELD();
+      }
+    }
+    return _joinStatus == LORA_AT_JOIN_JOINED;
+  }
+
   uint32_t prev_dl_check;
   bool     _requireConfirmation;
+  bool     _sendConfirmed;  ///< True if the current send is confirmed
+  int8_t   _sendRetries;    ///< Retries of the current send; -1 for the default
+
+  LoRa_AT_SendStatus      _sendStatus;          ///< The state of the send
+  const uint8_t*          _sendBuff;            ///< The buffer being sent
+  size_t                  _sendLen;             ///< The length of the buffer
+  bool                    _sendWhole;           ///< True to never split it
+  size_t                  _sendDone;            ///< The bytes already sent
+  uint8_t                 _sendChunk;           ///< Bytes in the current uplink
+  int8_t                  _sendAttempts;        ///< Attempts at this uplink
+  uint8_t                 _sendStep;            ///< The module specific step
+  LoRa_AT_JoinStatus      _joinStatus;          ///< The state of the join
+  uint8_t                 _joinAttemptsLeft;    ///< Join attempts remaining
+  int8_t                  _joinAttemptsMade;    ///< Join attempts made so far
+  uint32_t                _joinInitialBackoff;  ///< The first backoff
+  bool                    _joinForce;           ///< True to force a new join
+  bool                    _joinWaiting;         ///< True between attempts
+  uint8_t                 _joinStep;            ///< The module specific step
+  uint32_t                _asyncWaitStart;      ///< When the wait began
+  uint32_t                _asyncWaitTimeout;    ///< The length of the wait
+  LoRa_AT_ResponseMatcher _asyncMatcher;        ///< Matcher for the wait
+  LoRa_AT_AirtimeBudget*  _airtime;             ///< Budget to send within
+  int8_t                  _planRegion;          ///< The region, or -1
+  int8_t                  _planDataRate;        ///< The data rate, or -1
+  bool                    _planMacEmpty;        ///< True if no MAC waiting
 };
 
 #endif  // SRC_LORA_AT_RADIO_H_
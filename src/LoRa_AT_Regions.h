@@ -0,0 +1,168 @@
+/**
+ * @file       LoRa_AT_Regions.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_REGIONS_H_
+#define SRC_LORA_AT_REGIONS_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @brief The number of bytes LoRaWAN adds to the application payload of an
+ * uplink with no MAC commands: MHDR (1), FHDR (7), FPort (1) and MIC (4).
+ */
+#define LORA_AT_LORAWAN_OVERHEAD 13
+
+/**
+ * @brief The LoRaWAN regional parameter sets.
+ */
+enum LoRa_AT_Region : uint8_t {
+  LORA_AT_REGION_EU868 = 0,  ///< Europe 863-870 MHz
+  LORA_AT_REGION_US915,      ///< United States 902-928 MHz
+  LORA_AT_REGION_AU915,      ///< Australia 915-928 MHz
+  LORA_AT_REGION_AS923,      ///< Asia 923 MHz
+  LORA_AT_REGION_KR920,      ///< South Korea 920-923 MHz
+  LORA_AT_REGION_IN865,      ///< India 865-867 MHz
+};
+
+/**
+ * @brief The modulation used for a data rate.
+ */
+struct LoRa_AT_Modulation {
+  uint8_t  sf;  ///< The LoRa spreading factor; 0 for FSK
+  uint16_t bw;  ///< The bandwidth in kHz, or the FSK bit rate in kbps; 0 if
+                ///< the data rate is not valid
+};
+
+/**
+ * @brief Get the modulation of an uplink data rate in a region.
+ *
+ * @param region The region
+ * @param dataRate The data rate number
+ * @return The modulation; the bandwidth is 0 if the region has no such
+ * uplink data rate
+ */
+inline LoRa_AT_Modulation LoRa_AT_DataRateModulation(LoRa_AT_Region region,
+                                                     uint8_t dataRate) {
+  LoRa_AT_Modulation mod = {0, 0};
+  switch (region) {
+    case LORA_AT_REGION_US915:
+      if (dataRate <= 3) {
+        mod.sf = 10 - dataRate;
+        mod.bw = 125;
+      } else if (dataRate == 4) {
+        mod.sf = 8;
+        mod.bw = 500;
+      }
+      break;
+    case LORA_AT_REGION_AU915:
+      if (dataRate <= 5) {
+        mod.sf = 12 - dataRate;
+        mod.bw = 125;
+      } else if (dataRate == 6) {
+        mod.sf = 8;
+        mod.bw = 500;
+      }
+      break;
+    case LORA_AT_REGION_KR920:
+      if (dataRate <= 5) {
+        mod.sf = 12 - dataRate;
+        mod.bw = 125;
+      }
+      break;
+    default:
+      // EU868, AS923 and IN865; IN865 has no DR6
+      if (dataRate <= 5) {
+        mod.sf = 12 - dataRate;
+        mod.bw = 125;
+      } else if (dataRate == 6 && region != LORA_AT_REGION_IN865) {
+        mod.sf = 7;
+        mod.bw = 250;
+      } else if (dataRate == 7) {
+        mod.sf = 0;
+        mod.bw = 50;
+      }
+      break;
+  }
+  return mod;
+}
+
+/**
+ * @brief Get the lowest SNR at which a gateway can still receive an uplink
+ * data rate in a region: the demodulation floor.
+ *
+ * The floor is -7.5 dB at SF7 and 2.5 dB lower for each step of spreading
+ * factor, with the wider bandwidths needing 3 dB (250 kHz) or 6 dB (500 kHz)
+ * more.
+ *
+ * @param region The region
+ * @param dataRate The data rate number
+ * @return The SNR in tenths of a dB; 0x7FFF if the data rate is not a LoRa
+ * data rate of the region
+ */
+inline int16_t LoRa_AT_RequiredSNR(LoRa_AT_Region region, uint8_t dataRate) {
+  LoRa_AT_Modulation mod = LoRa_AT_DataRateModulation(region, dataRate);
+  if (!mod.bw || !mod.sf) { return 0x7FFF; }
+  int16_t floor = -75 - 25 * (mod.sf - 7);
+  return mod.bw == 500 ? floor + 60 : mod.bw == 250 ? floor + 30 : floor;
+}
+
+/**
+ * @brief The largest application payload for each uplink data rate (0-7) of
+ * each region, with no MAC commands and no repeater; 0 where the region has
+ * no such data rate.
+ *
+ * These are the N values of the LoRaWAN Regional Parameters (RP002-1.0.3).
+ * AS923 and AU915 are given with the uplink dwell time limit off; with it on
+ * the slower data rates carry less.
+ */
+static constexpr uint8_t LORA_AT_MAX_PAYLOAD[][8] = {
+    {51, 51, 51, 115, 222, 222, 222, 222},  // EU868
+    {11, 53, 125, 242, 242, 0, 0, 0},       // US915
+    {51, 51, 51, 115, 222, 222, 222, 0},    // AU915
+    {51, 51, 51, 115, 222, 222, 222, 222},  // AS923
+    {51, 51, 51, 115, 222, 222, 0, 0},      // KR920
+    {51, 51, 51, 115, 222, 222, 0, 222},    // IN865
+};
+
+/**
+ * @brief Get the largest application payload for an uplink data rate in a
+ * region.
+ *
+ * @param region The region
+ * @param dataRate The data rate number
+ * @return The number of bytes; 0 if the region has no such uplink data rate
+ */
+inline uint8_t LoRa_AT_MaxPayload(LoRa_AT_Region region, uint8_t dataRate) {
+  if (region > LORA_AT_REGION_IN865 || dataRate > 7) { return 0; }
+  return LORA_AT_MAX_PAYLOAD[region][dataRate];
+}
+
+/**
+ * @brief Find the region of a band name, as returned by the modules.
+ *
+ * Only the start of the name is checked, so names with a suffix, like
+ * "AS923-JAPAN", are matched too.
+ *
+ * @param band The band name
+ * @param region The region, set if it is found
+ * @return True if the region was found
+ */
+inline bool LoRa_AT_RegionFromBand(const char* band, LoRa_AT_Region* region) {
+  static const char names[][6] = {"EU868", "US915", "AU915",
+                                  "AS923", "KR920", "IN865"};
+  if (band == nullptr) { return false; }
+  while (*band == ' ') { band++; }
+  for (uint8_t i = 0; i <= LORA_AT_REGION_IN865; i++) {
+    if (strncmp(band, names[i], 5) == 0) {
+      *region = static_cast<LoRa_AT_Region>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif  // SRC_LORA_AT_REGIONS_H_
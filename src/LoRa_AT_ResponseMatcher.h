@@ -0,0 +1,380 @@
+/**
+ * @file       LoRa_AT_ResponseMatcher.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_RESPONSEMATCHER_H_
+#define SRC_LORA_AT_RESPONSEMATCHER_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @def LORA_AT_MATCH_WINDOW
+ * @brief The number of most recently received characters kept for matching
+ * responses and URCs.
+ *
+ * This must be a power of two no larger than 128 and must be at least as long
+ * as the longest response or URC being waited for.
+ */
+#ifndef LORA_AT_MATCH_WINDOW
+#define LORA_AT_MATCH_WINDOW 64
+#endif
+
+#if (LORA_AT_MATCH_WINDOW & (LORA_AT_MATCH_WINDOW - 1)) != 0 || \
+    LORA_AT_MATCH_WINDOW > 128
+#error "LORA_AT_MATCH_WINDOW must be a power of two no larger than 128"
+#endif
+
+/**
+ * @brief The maximum number of responses that can be waited for at once.
+ */
+#define LORA_AT_MAX_RESPONSES 7
+
+/**
+ * @brief A response or URC whose length and final character are computed at
+ * compile time.
+ *
+ * Create these with LoRa_AT_MakeResponse() from a `static constexpr char[]`
+ * (which may be stored in flash with #LORA_AT_PROGMEM) and group them into a
+ * `static constexpr` table.
+ */
+struct LoRa_AT_Response {
+  const char* str;   ///< The response text; stored in flash on AVR boards
+  uint8_t     len;   ///< The length of the response text
+  char        last;  ///< The final character of the response text
+};
+
+/**
+ * @brief Create a response table entry from a string array.
+ *
+ * @param str The response text
+ * @return The response table entry
+ */
+template <size_t N>
+constexpr LoRa_AT_Response LoRa_AT_MakeResponse(const char (&str)[N]) {
+  static_assert(N > 1 && N - 1 <= LORA_AT_MATCH_WINDOW,
+                "Responses must fit in the LORA_AT_MATCH_WINDOW");
+  return LoRa_AT_Response{str, static_cast<uint8_t>(N - 1), str[N - 2]};
+}
+
+/**
+ * @brief Compute a 32-bit filter of the final characters of all of the
+ * responses in a table.
+ *
+ * Each final character sets the bit for its value modulo 32. A received
+ * character whose bit is not set can not complete any response in the table.
+ *
+ * @param table The response table
+ * @param i The first table entry to include; used for recursion
+ * @return The final character filter
+ */
+template <size_t N>
+constexpr uint32_t LoRa_AT_FinalCharMask(const LoRa_AT_Response (&table)[N],
+                                         size_t i = 0) {
+  return i == N ? 0
+                : (static_cast<uint32_t>(1) << (table[i].last & 31)) |
+          LoRa_AT_FinalCharMask(table, i + 1);
+}
+
+/**
+ * @brief A streaming matcher for modem responses.
+ *
+ * The matcher keeps the last #LORA_AT_MATCH_WINDOW received characters in a
+ * fixed ring and checks, as each character arrives, whether the received text
+ * ends with any of up to seven expected responses. The length and final
+ * character of each response are computed once when the matcher is created,
+ * so a full comparison is only made when the incoming character is the final
+ * character of a response. No heap memory is used.
+ */
+class LoRa_AT_ResponseMatcher {
+ public:
+  /**
+   * @brief Construct a new response matcher for a set of expected responses.
+   *
+   * Any of the responses may be null. The index returned by push() is the
+   * position of the response in the argument list, starting from 1. A
+   * response longer than #LORA_AT_MATCH_WINDOW can never be matched, and
+   * leaves the matcher invalid; see valid().
+   */
+  LoRa_AT_ResponseMatcher(GsmConstStr r1 = nullptr, GsmConstStr r2 = nullptr,
+                          GsmConstStr r3 = nullptr, GsmConstStr r4 = nullptr,
+                          GsmConstStr r5 = nullptr, GsmConstStr r6 = nullptr,
+                          GsmConstStr r7 = nullptr) {
+    GsmConstStr responses[LORA_AT_MAX_RESPONSES] = {r1, r2, r3, r4,
+                                                    r5, r6, r7};
+    _valid = true;
+    for (uint8_t i = 0; i < LORA_AT_MAX_RESPONSES; i++) {
+      _resp[i]     = responses[i];
+      _respLen[i]  = 0;
+      _respLast[i] = '\0';
+      if (responses[i] == nullptr) { continue; }
+      size_t len = LoRa_AT_ConstStrLen(responses[i]);
+      // Responses that can never fit in the window can never be matched
+      if (len > LORA_AT_MATCH_WINDOW) { _valid = false; }
+      if (len == 0 || len > LORA_AT_MATCH_WINDOW) { continue; }
+      _respLen[i]  = len;
+      _respLast[i] = LoRa_AT_ConstStrChar(responses[i], len - 1);
+    }
+    clear();
+  }
+
+  /**
+   * @brief Check that every expected response fits in the window.
+   *
+   * @return False if any response is longer than #LORA_AT_MATCH_WINDOW, so
+   * waiting for it could never end in a match
+   */
+  bool valid() const {
+    return _valid;
+  }
+
+  /**
+   * @brief Forget all received characters.
+   */
+  void clear() {
+    _head  = 0;
+    _count = 0;
+  }
+
+  /**
+   * @brief Add a received character and check it against the expected
+   * responses.
+   *
+   * @param c The received character
+   * @return The index (1-7) of the first expected response that the received
+   * text now ends with; 0 if none match.
+   */
+  int8_t push(char c) {
+    _buf[_head] = c;
+    _head       = (_head + 1) & (LORA_AT_MATCH_WINDOW - 1);
+    if (_count < LORA_AT_MATCH_WINDOW) { _count++; }
+    for (uint8_t i = 0; i < LORA_AT_MAX_RESPONSES; i++) {
+      if (_respLen[i] && _respLast[i] == c &&
+          endsWith(_resp[i], _respLen[i])) {
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Check if the received text ends with a string.
+   *
+   * @param str The string to look for; may be stored in flash
+   * @return True if the most recently received characters match the string
+   */
+  bool endsWith(GsmConstStr str) const {
+    if (str == nullptr) { return false; }
+    return endsWith(str, LoRa_AT_ConstStrLen(str));
+  }
+
+  /**
+   * @brief Check if the received text ends with a string of known length.
+   *
+   * @param str The string to look for; may be stored in flash
+   * @param len The length of the string
+   * @return True if the most recently received characters match the string
+   */
+  bool endsWith(GsmConstStr str, size_t len) const {
+    if (len == 0 || len > _count) { return false; }
+    uint8_t pos = _head;
+    while (len) {
+      pos = (pos - 1) & (LORA_AT_MATCH_WINDOW - 1);
+      len--;
+      if (_buf[pos] != LoRa_AT_ConstStrChar(str, len)) { return false; }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Check which entry of a response table the received text ends with.
+   *
+   * The most recently received character is first checked against the
+   * table's final character filter, so for almost every character this is a
+   * single bit test and no response is compared.
+   *
+   * @param table The response table
+   * @param finalCharMask The filter for the table from LoRa_AT_FinalCharMask()
+   * @return The index of the first matching table entry; -1 if none match.
+   */
+  template <size_t N>
+  int8_t find(const LoRa_AT_Response (&table)[N],
+              uint32_t finalCharMask) const {
+    if (!_count) { return -1; }
+    char c = _buf[(_head - 1) & (LORA_AT_MATCH_WINDOW - 1)];
+    if (!(finalCharMask & (static_cast<uint32_t>(1) << (c & 31)))) {
+      return -1;
+    }
+    for (uint8_t i = 0; i < N; i++) {
+      if (table[i].last == c && endsWith(GFP(table[i].str), table[i].len)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Get the number of characters currently held for matching.
+   *
+   * @return The number of characters held, up to #LORA_AT_MATCH_WINDOW
+   */
+  uint8_t length() const {
+    return _count;
+  }
+
+  /**
+   * @brief Copy the characters currently held into a String, oldest first.
+   *
+   * This allocates and is meant only for debugging output.
+   *
+   * @return The held characters
+   */
+  String toString() const {
+    String  out;
+    uint8_t pos = (_head - _count) & (LORA_AT_MATCH_WINDOW - 1);
+    for (uint8_t i = 0; i < _count; i++) {
+      out += _buf[pos];
+      pos = (pos + 1) & (LORA_AT_MATCH_WINDOW - 1);
+    }
+    return out;
+  }
+
+ private:
+  GsmConstStr _resp[LORA_AT_MAX_RESPONSES];  ///< The expected responses
+  uint8_t _respLen[LORA_AT_MAX_RESPONSES];   ///< The length of each response
+  char    _respLast[LORA_AT_MAX_RESPONSES];  ///< The last char of each response
+  char    _buf[LORA_AT_MATCH_WINDOW];        ///< The ring of received chars
+  uint8_t _head;   ///< The position the next character will be written to
+  uint8_t _count;  ///< The number of characters in the ring
+  bool    _valid;  ///< False if a response is longer than the window
+};
+
+/**
+ * @brief Collects the text of a response into a fixed buffer supplied by the
+ * caller, for use in place of a String.
+ *
+ * It can be given to waitResponse() to collect a whole response. Characters
+ * that do not fit are dropped, and the text is always null terminated. No
+ * heap memory is used.
+ */
+class LoRa_AT_ResponseBuffer {
+ public:
+  /**
+   * @brief Construct a new response buffer, emptying the buffer.
+   *
+   * @param buf The buffer to write into
+   * @param size The size of the buffer, including the null terminator
+   */
+  LoRa_AT_ResponseBuffer(char* buf, size_t size) : _buf(buf), _size(size) {
+    clear();
+  }
+
+  /**
+   * @brief Add a character to the end of the text, if there is room.
+   *
+   * @param c The character
+   */
+  void append(char c) {
+    if (_len + 1 < _size) {
+      _buf[_len++] = c;
+      _buf[_len]   = '\0';
+    }
+  }
+
+  /**
+   * @brief Add a string to the end of the text, as much as there is room for.
+   *
+   * @param str The string
+   */
+  void append(const char* str) {
+    while (*str) { append(*str++); }
+  }
+
+  /**
+   * @brief Empty the text.
+   */
+  void clear() {
+    _len = 0;
+    if (_size) { _buf[0] = '\0'; }
+  }
+
+  /**
+   * @brief Get the length of the text.
+   *
+   * @return The number of characters held
+   */
+  size_t length() const {
+    return _len;
+  }
+
+  /**
+   * @brief Get the text.
+   *
+   * @return The null terminated text
+   */
+  const char* c_str() const {
+    return _buf;
+  }
+
+  /**
+   * @brief Cut the text down to its first line that isn't blank, without any
+   * white space around it.
+   *
+   * @return The new length of the text
+   */
+  size_t firstLine() {
+    size_t start = 0;
+    while (start < _len && isspace(_buf[start])) { start++; }
+    size_t end = start;
+    while (end < _len && _buf[end] != '\r' && _buf[end] != '\n') { end++; }
+    while (end > start && isspace(_buf[end - 1])) { end--; }
+    return cut(start, end);
+  }
+
+  /**
+   * @brief Drop a final "OK" and join the lines of the text with single
+   * spaces, without any white space around it.
+   *
+   * @return The new length of the text
+   */
+  size_t joinLines() {
+    size_t end = _len;
+    while (end && isspace(_buf[end - 1])) { end--; }
+    if (end >= 2 && _buf[end - 2] == 'O' && _buf[end - 1] == 'K' &&
+        (end == 2 || _buf[end - 3] == '\r' || _buf[end - 3] == '\n')) {
+      end -= 2;
+    }
+    size_t out  = 0;
+    char   prev = '\0';
+    for (size_t i = 0; i < end; i++) {
+      char c = _buf[i];
+      // "\r\n" is one line break
+      bool crlf = c == '\n' && prev == '\r';
+      prev      = c;
+      if (crlf) { continue; }
+      _buf[out++] = (c == '\r' || c == '\n') ? ' ' : c;
+    }
+    _len         = out;
+    size_t start = 0;
+    while (start < out && isspace(_buf[start])) { start++; }
+    while (out > start && isspace(_buf[out - 1])) { out--; }
+    return cut(start, out);
+  }
+
+ private:
+  // Keeps only the characters from start up to end
+  size_t cut(size_t start, size_t end) {
+    _len = end - start;
+    if (start) { memmove(_buf, _buf + start, _len); }
+    if (_size) { _buf[_len] = '\0'; }
+    return _len;
+  }
+
+  char*  _buf;   ///< The buffer
+  size_t _size;  ///< The size of the buffer
+  size_t _len;   ///< The length of the text
+};
+
+#endif  // SRC_LORA_AT_RESPONSEMATCHER_H_
@@ -0,0 +1,624 @@
+/**
+ * @file       LoRa_AT_Scheduler.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_SCHEDULER_H_
+#define SRC_LORA_AT_SCHEDULER_H_
+
+#include "LoRa_AT_Common.h"
+#include "LoRa_AT_Airtime.h"
+#include "LoRa_AT_LinkQuality.h"
+
+/**
+ * @def LORA_AT_SCHEDULER_CLASSES
+ * @brief The number of message classes an uplink scheduler has a policy for.
+ */
+#ifndef LORA_AT_SCHEDULER_CLASSES
+#define LORA_AT_SCHEDULER_CLASSES 4
+#endif
+
+/**
+ * @def LORA_AT_SCHEDULER_MARGIN
+ * @brief The default margin in dB an uplink scheduler keeps above the
+ * demodulation floor of the data rate it picks; the same as the installation
+ * margin of network server ADR.
+ */
+#ifndef LORA_AT_SCHEDULER_MARGIN
+#define LORA_AT_SCHEDULER_MARGIN 10
+#endif
+
+/**
+ * @def LORA_AT_SCHEDULER_LOSS_STEP
+ * @brief The extra margin in dB an uplink scheduler asks for after each
+ * confirmed uplink that is not acknowledged; 1 dB of it is given back after
+ * each one that is.
+ */
+#ifndef LORA_AT_SCHEDULER_LOSS_STEP
+#define LORA_AT_SCHEDULER_LOSS_STEP 3
+#endif
+
+/**
+ * @def LORA_AT_SCHEDULER_SILENCE
+ * @brief The number of uplinks an uplink scheduler sends with no link check
+ * answer or downlink before it starts to doubt its estimate of the link.
+ *
+ * After that many, messages that are confirmed when the link is poor are
+ * confirmed, and the estimate is lowered by one spreading factor step for
+ * each further run of that many, like the ADR backoff of a LoRaWAN device.
+ */
+#ifndef LORA_AT_SCHEDULER_SILENCE
+#define LORA_AT_SCHEDULER_SILENCE 16
+#endif
+
+/**
+ * @brief The message classes that an uplink scheduler starts with a policy
+ * for; any other class up to #LORA_AT_SCHEDULER_CLASSES starts as routine.
+ */
+enum LoRa_AT_MessageClass : uint8_t {
+  /// Readings that can be lost now and then; never confirmed
+  LORA_AT_MSG_ROUTINE = 0,
+  /// Messages that should arrive; confirmed when the link is doubtful
+  LORA_AT_MSG_IMPORTANT = 1,
+  /// Messages that must arrive; always confirmed with plenty of retries
+  LORA_AT_MSG_CRITICAL = 2,
+};
+
+/**
+ * @brief When an uplink scheduler asks for confirmation of a message.
+ */
+enum LoRa_AT_ConfirmMode : uint8_t {
+  /// Never confirmed
+  LORA_AT_CONFIRM_NEVER = 0,
+  /// Always confirmed
+  LORA_AT_CONFIRM_ALWAYS,
+  /// Confirmed if the link is not known or not heard from lately, the last
+  /// confirmed uplink was lost, or no data rate leaves the margin wanted
+  LORA_AT_CONFIRM_WHEN_POOR,
+};
+
+/**
+ * @brief How an uplink scheduler sends one class of messages.
+ */
+struct LoRa_AT_UplinkPolicy {
+  LoRa_AT_ConfirmMode confirm;     ///< When to ask for confirmation
+  uint8_t             margin;      ///< Extra dB of margin on top of the base
+  int8_t              minRetries;  ///< Confirmed retries on a good link
+  int8_t              maxRetries;  ///< Confirmed retries after losses
+};
+
+/**
+ * @brief The settings an uplink scheduler picked for one message.
+ */
+struct LoRa_AT_UplinkPlan {
+  uint8_t dataRate;   ///< The data rate
+  bool    confirmed;  ///< True to ask for confirmation
+  int8_t  retries;    ///< The confirmation retries; 0 if not confirmed
+};
+
+/**
+ * @brief Picks the data rate, confirmation and retries of each uplink from
+ * the recent quality of the link, instead of leaving them fixed.
+ *
+ * The scheduler keeps an estimate of the SNR at which the gateways hear the
+ * device. Each link check answer gives it as the link margin above the floor
+ * of the data rate the check was sent at, and each downlink gives the SNR
+ * the other way. The estimate falls at once when the link gets worse and
+ * climbs back part of the way with each better report, as set by
+ * #LORA_AT_LINK_EWMA_SHIFT, so the scheduler backs off quickly and speeds up
+ * slowly.
+ *
+ * For each message, the fastest data rate that keeps the margin wanted by the
+ * message class above the floor of that data rate is picked. Confirmed
+ * messages that are lost make the scheduler ask for more margin and more
+ * retries until confirmations arrive again. Without reports the estimate is
+ * lowered bit by bit, so an unconfirmed class on a link that has faded slows
+ * down until it is heard again. With no estimate yet, the slowest data rate
+ * is used. A message is always sent as a single uplink, at a faster
+ * data rate than the margin allows if that is the only way it fits.
+ *
+ * The scheduler turns off adaptive data rate on the module, since it sets
+ * the data rate itself. It works with any class that has the few modem
+ * functions it calls, so it can be tuned against LoRa_AT_SimulatedModem
+ * before it is used with a real module.
+ *
+ * @code{.cpp}
+ * LoRa_AT_Scheduler<LoRa_AT> scheduler(modem, LORA_AT_REGION_US915);
+ * scheduler.send(reading, sizeof(reading));                       // routine
+ * scheduler.send(alarm, sizeof(alarm), LORA_AT_MSG_CRITICAL);     // critical
+ * @endcode
+ *
+ * @tparam modemType The LoRa modem class
+ */
+template <class modemType>
+class LoRa_AT_Scheduler {
+ public:
+  /**
+   * @brief Construct a new uplink scheduler.
+   *
+   * @param modem The modem to send with
+   * @param region The region the module is using
+   */
+  LoRa_AT_Scheduler(modemType& modem, LoRa_AT_Region region)
+      : _modem(modem),
+        _region(region) {
+    static const LoRa_AT_UplinkPolicy defaults[] = {
+        {LORA_AT_CONFIRM_NEVER, 0, 0, 0},
+        {LORA_AT_CONFIRM_WHEN_POOR, 3, 1, 3},
+        {LORA_AT_CONFIRM_ALWAYS, 6, 3, 7},
+    };
+    for (uint8_t c = 0; c < LORA_AT_SCHEDULER_CLASSES; c++) {
+      _policies[c] = defaults[c < 3 ? c : 0];
+    }
+    _margin  = LORA_AT_SCHEDULER_MARGIN * 10;
+    _lowest  = 0;
+    _highest = 0;
+    for (uint8_t dr = 0; dr < 8; dr++) {
+      if (LoRa_AT_RequiredSNR(region, dr) != 0x7FFF) { _highest = dr; }
+    }
+    forgetLink();
+    resetStats();
+  }
+
+  /**
+   * @brief Set how one class of messages is sent.
+   *
+   * @param messageClass The message class, below #LORA_AT_SCHEDULER_CLASSES
+   * @param policy The policy for the class
+   */
+  void setPolicy(uint8_t messageClass, const LoRa_AT_UplinkPolicy& policy) {
+    if (messageClass < LORA_AT_SCHEDULER_CLASSES) {
+      _policies[messageClass] = policy;
+    }
+  }
+
+  /**
+   * @brief Limit the data rates the scheduler may pick.
+   *
+   * @param lowest The slowest data rate
+   * @param highest The fastest data rate, up to 7
+   */
+  void setDataRateRange(uint8_t lowest, uint8_t highest) {
+    _lowest  = lowest;
+    _highest = highest < 7 ? highest : 7;
+  }
+
+  /**
+   * @brief Set the margin to keep above the demodulation floor for every
+   * message, before the extra margin of each class.
+   *
+   * @param margin The margin in dB; optional with a default of
+   * #LORA_AT_SCHEDULER_MARGIN
+   */
+  void setMargin(uint8_t margin) {
+    _margin = margin * 10;
+  }
+
+  /**
+   * @brief Forget the estimate of the link and the losses counted against it.
+   */
+  void forgetLink() {
+    _known    = false;
+    _snr      = 0;
+    _penalty  = 0;
+    _failures = 0;
+    _silent   = 0;
+  }
+
+  /**
+   * @brief Check whether the scheduler has an estimate of the link yet.
+   *
+   * @return True if a link check or downlink has been seen
+   */
+  bool hasEstimate() const {
+    return _known;
+  }
+
+  /**
+   * @brief Get the estimate of the SNR at which the gateways hear the device.
+   *
+   * @return The SNR in tenths of a dB; 0 if there is no estimate
+   */
+  int16_t snrEstimate() const {
+    return _snr;
+  }
+
+  /**
+   * @brief Work out how a message would be sent now, without sending it.
+   *
+   * @param messageClass The message class
+   * @param len The length of the message; optional with a default of 0 to
+   * not consider the size
+   * @return The data rate, confirmation and retries for the message
+   */
+  LoRa_AT_UplinkPlan plan(uint8_t messageClass, size_t len = 0) const {
+    const LoRa_AT_UplinkPolicy& policy =
+        _policies[messageClass < LORA_AT_SCHEDULER_CLASSES ? messageClass : 0];
+    int16_t want = _margin + policy.margin * 10 + _penalty;
+
+    LoRa_AT_UplinkPlan plan;
+    plan.dataRate = _lowest;
+    if (_known) {
+      for (uint8_t dr = _lowest; dr <= _highest; dr++) {
+        int16_t floor = LoRa_AT_RequiredSNR(_region, dr);
+        if (floor != 0x7FFF && _snr - floor >= want) { plan.dataRate = dr; }
+      }
+    }
+    // a message is never split, so go faster if it can't fit
+    while (LoRa_AT_MaxPayload(_region, plan.dataRate) < len &&
+           plan.dataRate < _highest) {
+      plan.dataRate++;
+    }
+    bool enough = _known &&
+        _snr - LoRa_AT_RequiredSNR(_region, plan.dataRate) >= want;
+
+    switch (policy.confirm) {
+      case LORA_AT_CONFIRM_ALWAYS: plan.confirmed = true; break;
+      case LORA_AT_CONFIRM_WHEN_POOR:
+        plan.confirmed = !enough || _failures > 0 ||
+            _silent >= LORA_AT_SCHEDULER_SILENCE;
+        break;
+      default: plan.confirmed = false; break;
+    }
+    plan.retries = 0;
+    if (plan.confirmed) {
+      int16_t retries = policy.minRetries + _failures;
+      plan.retries    = retries < policy.maxRetries ? retries
+                                                    : policy.maxRetries;
+    }
+    return plan;
+  }
+
+  /**
+   * @brief Set up the module to send with a plan.
+   *
+   * Settings the module already has are not sent again.
+   *
+   * @param plan The plan, from plan()
+   * @return True if the module accepted every setting
+   */
+  bool apply(const LoRa_AT_UplinkPlan& plan) {
+    bool success = _modem.setAdaptiveDataRate(false);
+    success &= _modem.setDataRate(plan.dataRate);
+    _modem.requireConfirmation(plan.confirmed);
+    if (plan.confirmed && plan.retries > 0) {
+      success &= _modem.setConfirmationRetries(plan.retries);
+    }
+    return success;
+  }
+
+  /**
+   * @brief Send a message as a single uplink with the settings picked for its
+   * class, and learn from how it went.
+   *
+   * @param buff The message
+   * @param len The length of the message
+   * @param messageClass The message class; optional with a default of
+   * #LORA_AT_MSG_ROUTINE
+   * @return True if the message was sent and, if it was confirmed,
+   * acknowledged
+   */
+  bool send(const uint8_t* buff, size_t len,
+            uint8_t messageClass = LORA_AT_MSG_ROUTINE) {
+    const LoRa_AT_LinkHistory& history = _modem.linkHistory();
+    if (!_known && history.has(LORA_AT_LINK_SNR)) {
+      observe(history.latest(LORA_AT_LINK_SNR) * 10);
+    }
+    LoRa_AT_UplinkPlan plan = this->plan(messageClass, len);
+    if (!apply(plan)) {
+      DBG(GF("### Module refused the uplink settings"));
+      return false;
+    }
+    uint16_t margins = history.updates(LORA_AT_LINK_MARGIN);
+    uint16_t signals = history.updates(LORA_AT_LINK_SNR);
+    if (!_modem.beginSend(buff, len, true)) { return false; }
+    while (_modem.poll()) { LORA_AT_YIELD(); }
+    bool done = _modem.sendStatus() == LORA_AT_SEND_DONE;
+
+    _uplinks++;
+    _airtime += LoRa_AT_UplinkAirtime(_region, plan.dataRate, len);
+    // the margin is measured from the floor of the data rate just used
+    bool heard = false;
+    if (history.updates(LORA_AT_LINK_MARGIN) != margins) {
+      observe(history.latest(LORA_AT_LINK_MARGIN) * 10 +
+              LoRa_AT_RequiredSNR(_region, plan.dataRate));
+      heard = true;
+    }
+    if (history.updates(LORA_AT_LINK_SNR) != signals) {
+      observe(history.latest(LORA_AT_LINK_SNR) * 10);
+      heard = true;
+    }
+    if (heard) {
+      _silent = 0;
+    } else if (_silent < 0xFFFF) {
+      _silent++;
+      // one spreading factor step down for each run of silence, stopping
+      // once even the slowest data rate looks too fast
+      if (_known && _silent % LORA_AT_SCHEDULER_SILENCE == 0 &&
+          _snr > LoRa_AT_RequiredSNR(_region, _lowest)) {
+        _snr -= 25;
+      }
+    }
+    if (plan.confirmed) { confirmation(done); }
+    return done;
+  }
+
+  /**
+   * @brief Set all of the statistics back to zero.
+   */
+  void resetStats() {
+    _uplinks = 0;
+    _lost    = 0;
+    _airtime = 0;
+  }
+
+  /**
+   * @brief Get the number of messages sent since the statistics were reset.
+   *
+   * @return The number of messages
+   */
+  uint32_t uplinks() const {
+    return _uplinks;
+  }
+
+  /**
+   * @brief Get the number of confirmed messages that were not acknowledged
+   * since the statistics were reset.
+   *
+   * @return The number of messages
+   */
+  uint32_t lost() const {
+    return _lost;
+  }
+
+  /**
+   * @brief Get the time on air of the messages sent since the statistics were
+   * reset, once each; retries are not counted.
+   *
+   * @return The time on air in milliseconds
+   */
+  uint32_t airtime() const {
+    return _airtime;
+  }
+
+ protected:
+  // Falls straight to a worse report and moves part way to a better one
+  void observe(int16_t snr) {
+    if (!_known || snr < _snr) {
+      _snr   = snr;
+      _known = true;
+      return;
+    }
+    _snr += (snr - _snr) / (1 << LORA_AT_LINK_EWMA_SHIFT);
+  }
+
+  void confirmation(bool acknowledged) {
+    if (acknowledged) {
+      _failures = 0;
+      _penalty  = _penalty > 10 ? _penalty - 10 : 0;
+      return;
+    }
+    _lost++;
+    if (_failures < 15) { _failures++; }
+    _penalty += LORA_AT_SCHEDULER_LOSS_STEP * 10;
+    if (_penalty > 200) { _penalty = 200; }
+  }
+
+  modemType&           _modem;
+  LoRa_AT_Region       _region;
+  LoRa_AT_UplinkPolicy _policies[LORA_AT_SCHEDULER_CLASSES];
+  int16_t              _margin;    ///< Base margin, tenths of a dB
+  uint8_t              _lowest;    ///< Slowest data rate allowed
+  uint8_t              _highest;   ///< Fastest data rate allowed
+  bool                 _known;     ///< True once the link has been seen
+  int16_t              _snr;       ///< SNR estimate, tenths of a dB
+  int16_t              _penalty;   ///< Extra margin after losses, tenths
+  uint8_t              _failures;  ///< Confirmed uplinks lost in a row
+  uint16_t             _silent;    ///< Uplinks since the last report
+  uint32_t             _uplinks;
+  uint32_t             _lost;
+  uint32_t             _airtime;
+};
+
+/**
+ * @brief A stand-in for a modem with a made-up, repeatable radio link, for
+ * trying out and tuning LoRa_AT_Scheduler without a module or a network.
+ *
+ * Each transmission is heard by the gateway if the SNR of the link, plus a
+ * random swing, reaches the floor of the data rate. A confirmed message is
+ * sent again up to the number of retries until it is heard, and each time it
+ * is heard the acknowledgement is added to the link history as a downlink
+ * with the same SNR. Every few uplinks that are heard also carry a link check
+ * answer. The random numbers come from a fixed seed, so a run can be
+ * repeated exactly.
+ *
+ * @code{.cpp}
+ * LoRa_AT_SimulatedModem                    sim(LORA_AT_REGION_EU868, 5);
+ * LoRa_AT_Scheduler<LoRa_AT_SimulatedModem> scheduler(sim,
+ *                                                     LORA_AT_REGION_EU868);
+ * for (int i = 0; i < 1000; i++) {
+ *   sim.setLink(i < 500 ? 5 : -12);  // the link fades half way through
+ *   scheduler.send(reading, sizeof(reading), LORA_AT_MSG_IMPORTANT);
+ * }
+ * Serial.println(sim.delivered());
+ * Serial.println(sim.airtime());
+ * @endcode
+ */
+class LoRa_AT_SimulatedModem {
+ public:
+  /**
+   * @brief Construct a simulated modem.
+   *
+   * @param region The region
+   * @param snr The SNR in dB at which the gateway hears the device
+   * @param swing The most the SNR of a single transmission is above or below
+   * the link SNR, in dB; optional with a default of 3
+   * @param seed The seed of the random numbers; optional with a default of 1
+   */
+  explicit LoRa_AT_SimulatedModem(LoRa_AT_Region region, int8_t snr,
+                                  uint8_t swing = 3, uint32_t seed = 1)
+      : _region(region) {
+    _random     = seed ? seed : 1;
+    _checkEvery = 4;
+    _dataRate   = 0;
+    _confirmed  = false;
+    _retries    = 0;
+    _status     = LORA_AT_SEND_IDLE;
+    setLink(snr, swing);
+    resetStats();
+  }
+
+  /**
+   * @brief Change the link.
+   *
+   * @param snr The SNR in dB at which the gateway hears the device
+   * @param swing The most the SNR of a single transmission is above or below
+   * the link SNR, in dB; optional with a default of 3
+   */
+  void setLink(int8_t snr, uint8_t swing = 3) {
+    _snr   = snr;
+    _swing = swing;
+  }
+
+  /**
+   * @brief Set how often an uplink carries a link check.
+   *
+   * @param uplinks The number of uplinks heard for each link check answer; 0
+   * for none
+   */
+  void setLinkCheckEvery(uint8_t uplinks) {
+    _checkEvery = uplinks;
+  }
+
+  /// @brief Does nothing; the simulation has no adaptive data rate.
+  bool setAdaptiveDataRate(bool) {
+    return true;
+  }
+  /// @copydoc LoRa_AT_Modem::setDataRate()
+  bool setDataRate(uint8_t dataRate) {
+    if (LoRa_AT_RequiredSNR(_region, dataRate) == 0x7FFF) { return false; }
+    _dataRate = dataRate;
+    return true;
+  }
+  /// @copydoc LoRa_AT_Radio::requireConfirmation()
+  void requireConfirmation(bool requireConfirmation) {
+    _confirmed = requireConfirmation;
+  }
+  /// @copydoc LoRa_AT_Modem::setConfirmationRetries()
+  bool setConfirmationRetries(int8_t numAckRetries) {
+    _retries = numAckRetries;
+    return true;
+  }
+  /// @copydoc LoRa_AT_Modem::linkHistory()
+  const LoRa_AT_LinkHistory& linkHistory() const {
+    return _history;
+  }
+
+  /**
+   * @brief Send a message over the simulated link, all at once.
+   *
+   * @param buff The message; it is not read
+   * @param len The length of the message
+   * @param whole Ignored; the message is always sent as one uplink
+   * @return True if the message fits in an uplink at the current data rate
+   */
+  bool beginSend(const uint8_t* buff, size_t len, bool whole = false) {
+    (void)buff;
+    (void)whole;
+    if (len > LoRa_AT_MaxPayload(_region, _dataRate)) {
+      _status = LORA_AT_SEND_FAILED;
+      return false;
+    }
+    int16_t floor    = LoRa_AT_RequiredSNR(_region, _dataRate);
+    uint8_t attempts = _confirmed ? 1 + _retries : 1;
+    bool    heard    = false;
+    for (uint8_t a = 0; a < attempts && !heard; a++) {
+      int16_t snr = _snr * 10 + swing();
+      _transmissions++;
+      _airtime += LoRa_AT_UplinkAirtime(_region, _dataRate, len);
+      if (snr < floor) { continue; }
+      heard = true;
+      _delivered++;
+      if (_confirmed) { _history.recordSignal(-120 + snr / 10, snr / 10); }
+      if (_checkEvery && ++_heard % _checkEvery == 0) {
+        _history.recordLinkCheck((snr - floor) / 10, 1);
+      }
+    }
+    _status = heard || !_confirmed ? LORA_AT_SEND_DONE : LORA_AT_SEND_FAILED;
+    return true;
+  }
+  /// @brief Does nothing; a simulated send is finished by beginSend().
+  bool poll() {
+    return false;
+  }
+  /// @copydoc LoRa_AT_Radio::sendStatus()
+  LoRa_AT_SendStatus sendStatus() const {
+    return _status;
+  }
+
+  /**
+   * @brief Set all of the statistics back to zero.
+   */
+  void resetStats() {
+    _transmissions = 0;
+    _delivered     = 0;
+    _heard         = 0;
+    _airtime       = 0;
+  }
+
+  /**
+   * @brief Get the number of transmissions, counting every retry.
+   *
+   * @return The number of transmissions
+   */
+  uint32_t transmissions() const {
+    return _transmissions;
+  }
+
+  /**
+   * @brief Get the number of messages the gateway heard.
+   *
+   * @return The number of messages
+   */
+  uint32_t delivered() const {
+    return _delivered;
+  }
+
+  /**
+   * @brief Get the time on air of every transmission.
+   *
+   * @return The time on air in milliseconds
+   */
+  uint32_t airtime() const {
+    return _airtime;
+  }
+
+ protected:
+  // A random swing of the SNR in tenths of a dB, from an xorshift generator
+  int16_t swing() {
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    int16_t range = _swing * 10;
+    return static_cast<int16_t>(_random % (2 * range + 1)) - range;
+  }
+
+  LoRa_AT_Region      _region;
+  LoRa_AT_LinkHistory _history;
+  uint32_t            _random;
+  int8_t              _snr;
+  uint8_t             _swing;
+  uint8_t             _checkEvery;
+  uint8_t             _dataRate;
+  bool                _confirmed;
+  int8_t              _retries;
+  LoRa_AT_SendStatus  _status;
+  uint32_t            _transmissions;
+  uint32_t            _delivered;
+  uint32_t            _heard;
+  uint32_t            _airtime;
+};
+
+#endif  // SRC_LORA_AT_SCHEDULER_H_
@@ -0,0 +1,306 @@
+/**
+ * @file       LoRa_AT_Schema.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_SCHEMA_H_
+#define SRC_LORA_AT_SCHEMA_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @brief Write the lowest bits of a number into a buffer at a bit position,
+ * most significant bit first.
+ *
+ * The bits in the buffer must already be zero.
+ *
+ * @param buff The buffer
+ * @param pos The position of the first bit; bit 0 is the top bit of byte 0
+ * @param bits The number of bits to write, 1-32
+ * @param value The number
+ */
+inline void LoRa_AT_PutBits(uint8_t* buff, uint16_t pos, uint8_t bits,
+                            uint32_t value) {
+  while (bits) {
+    uint8_t used = pos & 7;
+    uint8_t n    = bits < 8 - used ? bits : 8 - used;
+    bits -= n;
+    buff[pos >> 3] |= ((value >> bits) & (0xFF >> (8 - n))) << (8 - used - n);
+    pos += n;
+  }
+}
+
+/**
+ * @brief Read a number written by LoRa_AT_PutBits().
+ *
+ * @param buff The buffer
+ * @param pos The position of the first bit
+ * @param bits The number of bits to read, 1-32
+ * @return The number
+ */
+inline uint32_t LoRa_AT_GetBits(const uint8_t* buff, uint16_t pos,
+                                uint8_t bits) {
+  uint32_t value = 0;
+  while (bits) {
+    uint8_t used = pos & 7;
+    uint8_t n    = bits < 8 - used ? bits : 8 - used;
+    value        = (value << n) |
+        ((buff[pos >> 3] >> (8 - used - n)) & (0xFF >> (8 - n)));
+    bits -= n;
+    pos += n;
+  }
+  return value;
+}
+
+/**
+ * @brief A field of a payload schema: a reading stored as an unsigned number
+ * of a fixed number of bits.
+ *
+ * A reading is stored as `round(reading * Scale) - Offset` and read back as
+ * `(stored + Offset) / Scale`. Readings outside the range that fits are
+ * stored as the nearest end of the range.
+ *
+ * @code{.cpp}
+ * // -40.00 to 123.83 C in steps of 0.01 C, in 14 bits
+ * typedef LoRa_AT_Field<14, 100, -4000> Temperature;
+ * @endcode
+ *
+ * @tparam Bits The number of bits, 1-32
+ * @tparam Scale The number of steps per unit of the reading; optional with a
+ * default of 1
+ * @tparam Offset The scaled reading that is stored as zero; optional with a
+ * default of 0
+ */
+template <uint8_t Bits, int32_t Scale = 1, int32_t Offset = 0>
+struct LoRa_AT_Field {
+  static_assert(Bits >= 1 && Bits <= 32, "A field must have 1-32 bits");
+  static_assert(Scale > 0, "The scale of a field must be positive");
+
+  /// The number of bits
+  static constexpr uint8_t BITS = Bits;
+  /// The number of steps per unit of the reading
+  static constexpr int32_t SCALE = Scale;
+  /// The scaled reading that is stored as zero
+  static constexpr int32_t OFFSET = Offset;
+  /// The largest number that can be stored
+  static constexpr uint32_t MAX = 0xFFFFFFFFUL >> (32 - Bits);
+
+  /**
+   * @brief Convert a reading to the number stored.
+   *
+   * @param reading The reading
+   * @return The number stored
+   */
+  static uint32_t encode(float reading) {
+    float s = reading * Scale - Offset;
+    // NaN is stored as zero
+    return !(s > 0) ? 0 : s >= MAX ? MAX : static_cast<uint32_t>(s + 0.5f);
+  }
+  /// @copydoc encode(float)
+  static uint32_t encode(double reading) {
+    return encode(static_cast<float>(reading));
+  }
+  /**
+   * @brief Convert a whole number reading to the number stored, without
+   * rounding through a float.
+   *
+   * @param reading The reading
+   * @return The number stored
+   */
+  template <typename T>
+  static uint32_t encode(T reading) {
+    int64_t s = static_cast<int64_t>(reading) * Scale - Offset;
+    return s < 0 ? 0 : s >= static_cast<int64_t>(MAX) ? MAX : s;
+  }
+
+  /**
+   * @brief Convert a stored number back to the reading.
+   *
+   * @param stored The number stored
+   * @return The reading
+   */
+  static float decode(uint32_t stored) {
+    return (static_cast<float>(stored) + Offset) / Scale;
+  }
+};
+
+// Walks the fields of a schema at compile time, from the field starting at
+// bit Pos; the compiler unrolls every step into straight line code.
+template <uint16_t Pos, class... Fields>
+struct LoRa_AT_SchemaStep {
+  static constexpr uint16_t END = Pos;
+  static void pack(uint8_t*) {}
+  static void unpack(const uint8_t*, float*) {}
+  static void printFields(Print&, const char* const*, uint8_t) {}
+};
+template <uint16_t Pos, class F, class... Rest>
+struct LoRa_AT_SchemaStep<Pos, F, Rest...> {
+  typedef LoRa_AT_SchemaStep<Pos + F::BITS, Rest...> Next;
+  static constexpr uint16_t END = Next::END;
+
+  template <typename V, typename... Vs>
+  static void pack(uint8_t* buff, V reading, Vs... readings) {
+    LoRa_AT_PutBits(buff, Pos, F::BITS, F::encode(reading));
+    Next::pack(buff, readings...);
+  }
+  static void unpack(const uint8_t* buff, float* readings) {
+    readings[0] = F::decode(LoRa_AT_GetBits(buff, Pos, F::BITS));
+    Next::unpack(buff, readings + 1);
+  }
+  static void printFields(Print& out, const char* const* names, uint8_t i) {
+    if (i) { out.print(','); }
+    out.print('[');
+    out.print(F::BITS);
+    out.print(',');
+    out.print(F::SCALE);
+    out.print(',');
+    out.print(F::OFFSET);
+    out.print(GF(",\""));
+    if (names) {
+      out.print(names[i]);
+    } else {
+      out.print('f');
+      out.print(i);
+    }
+    out.print(GF("\"]"));
+    Next::printFields(out, names, i + 1);
+  }
+};
+
+// Finds the type and first bit of field I of a schema
+template <uint8_t I, uint16_t Pos, class F, class... Rest>
+struct LoRa_AT_SchemaAt : LoRa_AT_SchemaAt<I - 1, Pos + F::BITS, Rest...> {};
+template <uint16_t Pos, class F, class... Rest>
+struct LoRa_AT_SchemaAt<0, Pos, F, Rest...> {
+  typedef F                 Field;
+  static constexpr uint16_t POS = Pos;
+};
+
+/**
+ * @brief The layout of a binary payload, declared as a list of fields, with
+ * the size and position of every field worked out when compiling.
+ *
+ * The fields are packed one after another, most significant bit first, with
+ * no padding between them, so the payload is the smallest number of whole
+ * bytes that holds all of the bits. Packing and unpacking are unrolled into
+ * shifts and masks at fixed positions with no loops over the fields.
+ *
+ * printDecoder() writes a matching `decodeUplink()` function for the payload
+ * formatter of the network server, so the server side never needs to be
+ * written by hand.
+ *
+ * @code{.cpp}
+ * typedef LoRa_AT_Schema<LoRa_AT_Field<14, 100, -4000>,  // temperature
+ *                        LoRa_AT_Field<10, 10>,          // humidity, 0.1 %
+ *                        LoRa_AT_Field<8, 20, 40>>       // battery, 2-14.75 V
+ *     Reading;
+ * uint8_t payload[Reading::SIZE];  // 4 bytes
+ * Reading::pack(payload, 21.37, 55.2, 3.7);
+ * modem.beginSend(payload, Reading::SIZE, true);
+ * @endcode
+ *
+ * @tparam Fields The fields, as LoRa_AT_Field types, in the order they are
+ * packed
+ */
+template <class... Fields>
+class LoRa_AT_Schema {
+  typedef LoRa_AT_SchemaStep<0, Fields...> Steps;
+
+ public:
+  /// The number of fields
+  static constexpr uint8_t FIELDS = sizeof...(Fields);
+  /// The number of bits used by all of the fields
+  static constexpr uint16_t BITS = Steps::END;
+  /// The number of bytes in the payload
+  static constexpr size_t SIZE = (BITS + 7) / 8;
+
+  /**
+   * @brief Pack one reading for each field into a payload.
+   *
+   * @param buff The buffer to write to; at least #SIZE bytes
+   * @param readings The readings, in the order of the fields; floating point
+   * readings are rounded to the nearest step and whole numbers are scaled
+   * exactly
+   * @return The number of bytes written; always #SIZE
+   */
+  template <typename... Readings>
+  static size_t pack(uint8_t* buff, Readings... readings) {
+    static_assert(sizeof...(Readings) == sizeof...(Fields),
+                  "There must be one reading for each field");
+    memset(buff, 0, SIZE);
+    Steps::pack(buff, readings...);
+    return SIZE;
+  }
+
+  /**
+   * @brief Read back every field of a payload.
+   *
+   * @param buff The payload; at least #SIZE bytes
+   * @param readings An array of #FIELDS numbers to write the readings to
+   */
+  static void unpack(const uint8_t* buff, float* readings) {
+    Steps::unpack(buff, readings);
+  }
+
+  /**
+   * @brief Read back one field of a payload.
+   *
+   * @tparam I The index of the field
+   * @param buff The payload
+   * @return The reading
+   */
+  template <uint8_t I>
+  static float get(const uint8_t* buff) {
+    typedef LoRa_AT_SchemaAt<I, 0, Fields...> At;
+    return At::Field::decode(getRaw<I>(buff));
+  }
+
+  /**
+   * @brief Read the number stored for one field of a payload, without
+   * converting it back to the reading.
+   *
+   * @tparam I The index of the field
+   * @param buff The payload
+   * @return The number stored
+   */
+  template <uint8_t I>
+  static uint32_t getRaw(const uint8_t* buff) {
+    typedef LoRa_AT_SchemaAt<I, 0, Fields...> At;
+    return LoRa_AT_GetBits(buff, At::POS, At::Field::BITS);
+  }
+
+  /**
+   * @brief Write a JavaScript `decodeUplink()` function that decodes this
+   * payload, for the payload formatter of a network server such as The
+   * Things Stack or ChirpStack.
+   *
+   * The fields are listed in a table of bits, scale, offset and name, which
+   * is also easy to read by other decoders.
+   *
+   * @param out Where to write the function, such as `Serial`
+   * @param names The names of the fields in the decoded data; optional, with
+   * the fields named f0, f1 and so on by default
+   */
+  static void printDecoder(Print& out, const char* const* names = nullptr) {
+    out.print(GF("function decodeUplink(input) {\n  var fields = ["));
+    Steps::printFields(out, names, 0);
+    out.print(GF("];\n  var data = {}, pos = 0;\n"
+                 "  if (input.bytes.length < "));
+    out.print(static_cast<uint16_t>(SIZE));
+    out.print(GF(") return { errors: [\"payload too short\"] };\n"
+                 "  for (var i = 0; i < fields.length; i++) {\n"
+                 "    var raw = 0;\n"
+                 "    for (var b = 0; b < fields[i][0]; b++, pos++) {\n"
+                 "      raw = raw * 2 + "
+                 "((input.bytes[pos >> 3] >> (7 - (pos & 7))) & 1);\n"
+                 "    }\n"
+                 "    data[fields[i][3]] = (raw + fields[i][2]) / "
+                 "fields[i][1];\n"
+                 "  }\n"
+                 "  return { data: data };\n}\n"));
+  }
+};
+
+#endif  // SRC_LORA_AT_SCHEMA_H_
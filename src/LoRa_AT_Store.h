@@ -0,0 +1,506 @@
+/**
+ * @file       LoRa_AT_Store.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_STORE_H_
+#define SRC_LORA_AT_STORE_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @def LORA_AT_STORE_MAX_RECORD
+ * @brief The longest payload that can be kept in the store-and-forward queue.
+ *
+ * A buffer of this size is part of each queue, to send the stored payloads
+ * from.
+ */
+#ifndef LORA_AT_STORE_MAX_RECORD
+#define LORA_AT_STORE_MAX_RECORD 64
+#endif
+
+#if LORA_AT_STORE_MAX_RECORD > 255
+#error "LORA_AT_STORE_MAX_RECORD must be no more than 255"
+#endif
+
+/**
+ * @brief Compute a CRC-16/CCITT-FALSE checksum.
+ *
+ * @param buf The data
+ * @param len The length of the data
+ * @param crc The CRC of any previous data to continue from; optional with a
+ * default value of 0xFFFF, to start a new CRC.
+ * @return The CRC
+ */
+inline uint16_t LoRa_AT_CRC16(const uint8_t* buf, size_t len,
+                              uint16_t crc = 0xFFFF) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= static_cast<uint16_t>(buf[i]) << 8;
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief The interface to the storage behind a store-and-forward queue.
+ *
+ * Implement this for an SD card file, an FRAM chip, EEPROM or any other
+ * byte-addressable storage that can be rewritten a byte at a time.
+ */
+class LoRa_AT_Storage {
+ public:
+  virtual ~LoRa_AT_Storage() {}
+
+  /**
+   * @brief Get the size of the storage.
+   *
+   * @return The number of bytes that can be stored
+   */
+  virtual uint32_t size() = 0;
+
+  /**
+   * @brief Read from the storage.
+   *
+   * @param addr The address to read from
+   * @param buf The buffer to read into
+   * @param len The number of bytes to read
+   * @return True if the read succeeded
+   */
+  virtual bool read(uint32_t addr, uint8_t* buf, size_t len) = 0;
+
+  /**
+   * @brief Write to the storage.
+   *
+   * @param addr The address to write to
+   * @param buf The data to write
+   * @param len The number of bytes to write
+   * @return True if the write succeeded
+   */
+  virtual bool write(uint32_t addr, const uint8_t* buf, size_t len) = 0;
+
+  /**
+   * @brief Make sure that everything written so far will survive a reset or
+   * power loss; for example by flushing a file.
+   *
+   * @return True if the data is safe
+   */
+  virtual bool sync() {
+    return true;
+  }
+};
+
+/**
+ * @brief Storage for a store-and-forward queue in RAM.
+ *
+ * The queue will not survive a reset, but will survive the module losing the
+ * network.
+ *
+ * @tparam N The number of bytes of RAM to use
+ */
+template <uint32_t N>
+class LoRa_AT_RAMStorage : public LoRa_AT_Storage {
+ public:
+  uint32_t size() override {
+    return N;
+  }
+  bool read(uint32_t addr, uint8_t* buf, size_t len) override {
+    if (addr + len > N) { return false; }
+    memcpy(buf, _mem + addr, len);
+    return true;
+  }
+  bool write(uint32_t addr, const uint8_t* buf, size_t len) override {
+    if (addr + len > N) { return false; }
+    memcpy(_mem + addr, buf, len);
+    return true;
+  }
+
+ private:
+  uint8_t _mem[N];
+};
+
+/**
+ * @brief The order in which stored payloads are sent.
+ */
+enum LoRa_AT_DrainOrder {
+  LORA_AT_DRAIN_OLDEST = 0,  ///< Send the oldest payload first
+  LORA_AT_DRAIN_PRIORITY,    ///< Send the highest priority payload first
+};
+
+/**
+ * @brief A persistent queue of payloads waiting to be sent, so that data is
+ * kept while the module is not joined to the network.
+ *
+ * The payloads are kept as a log in a ring on a LoRa_AT_Storage. The first
+ * bytes of the storage hold two copies of the positions of the oldest and
+ * newest records, written alternately, each with a sequence number and a CRC.
+ * A new payload is written before the positions are updated, the
+ * positions are updated before a dropped payload is written over, and a sent
+ * payload is marked as sent before the positions are updated, so a reset at
+ * any point loses at most the change being made. Each record also carries a
+ * CRC of its payload; a record that fails the check is dropped instead of
+ * being sent.
+ *
+ * When the queue is full, the oldest payloads are dropped to make room.
+ *
+ * @code{.cpp}
+ * LoRa_AT_RAMStorage<1024>      storage;
+ * LoRa_AT_StoreForward<LoRa_AT> queue(modem, storage);
+ * ...
+ * queue.begin();
+ * queue.write(reading, sizeof(reading));  // sent now if joined, or kept
+ * ...
+ * queue.maintain();  // sends a kept payload once joined again
+ * @endcode
+ *
+ * @tparam modemType The LoRa modem class
+ */
+template <class modemType>
+class LoRa_AT_StoreForward {
+ public:
+  /**
+   * @brief Construct a new store-and-forward queue.
+   *
+   * @param modem The modem to send the payloads with
+   * @param storage The storage to keep the payloads in; must be more than
+   * twice the size of the position records
+   */
+  LoRa_AT_StoreForward(modemType& modem, LoRa_AT_Storage& storage)
+      : _modem(modem),
+        _storage(storage) {
+    _head          = 0;
+    _tail          = 0;
+    _seq           = 0;
+    _count         = 0;
+    _dropped       = 0;
+    _order         = LORA_AT_DRAIN_OLDEST;
+    _drainInterval = 0;
+    _lastDrain     = 0;
+  }
+
+  /**
+   * @brief Load the queue from the storage, or start an empty queue if the
+   * storage holds no valid queue.
+   *
+   * @return True if the storage could be read and written
+   */
+  bool begin() {
+    if (_storage.size() <= dataStart() + RECORD_HEADER) { return false; }
+    uint8_t  best    = 0xFF;
+    uint32_t bestSeq = 0;
+    uint32_t slot[3];
+    for (uint8_t i = 0; i < 2; i++) {
+      if (!readCommit(i, slot)) { continue; }
+      if (best == 0xFF || slot[0] > bestSeq) {
+        best    = i;
+        bestSeq = slot[0];
+        _head   = slot[1];
+        _tail   = slot[2];
+      }
+    }
+    if (best == 0xFF) { return format(); }
+    _seq = bestSeq;
+    if (_head >= dataSize() || _tail >= dataSize()) { return format(); }
+    // count the waiting payloads and cut off anything unreadable
+    _count       = 0;
+    uint32_t off = 0;
+    uint8_t  header[RECORD_HEADER];
+    while (off < used()) {
+      uint32_t pos = advance(_tail, off);
+      if (!readHeader(pos, off, header)) {
+        DBG(GF("### Store-and-forward queue cut at damaged record"));
+        _head = pos;
+        return commit();
+      }
+      if (header[0] == RECORD_PENDING) { _count++; }
+      off += RECORD_HEADER + header[1];
+    }
+    return true;
+  }
+
+  /**
+   * @brief Empty the queue, dropping all waiting payloads.
+   *
+   * @return True if the storage could be written
+   */
+  bool format() {
+    _head  = 0;
+    _tail  = 0;
+    _count = 0;
+    return commit();
+  }
+
+  /**
+   * @brief Add a payload to the queue, and send from the queue if the module
+   * is joined.
+   *
+   * @param buff The payload
+   * @param len The length of the payload; no more than
+   * #LORA_AT_STORE_MAX_RECORD
+   * @param priority The priority of the payload, used if the queue is
+   * drained in order of priority; higher numbers are sent first
+   * @return True if the payload was kept or sent
+   */
+  bool write(const uint8_t* buff, size_t len, uint8_t priority = 0) {
+    if (!store(buff, len, priority)) { return false; }
+    maintain();
+    return true;
+  }
+
+  /**
+   * @brief Add a payload to the queue without trying to send it.
+   *
+   * @param buff The payload
+   * @param len The length of the payload
+   * @param priority The priority of the payload
+   * @return True if the payload was kept
+   */
+  bool store(const uint8_t* buff, size_t len, uint8_t priority = 0) {
+    uint32_t need = RECORD_HEADER + len;
+    if (len == 0 || len > LORA_AT_STORE_MAX_RECORD || need >= dataSize()) {
+      return false;
+    }
+    // drop the oldest records until there's room, and save the new tail
+    // before the new record is written over them, so a reset part way through
+    // can't leave the saved tail pointing into a half written record
+    uint32_t tail = _tail;
+    while (dataSize() - 1 - used() < need) { dropOldest(); }
+    if (_tail != tail && !commit()) { return false; }
+    uint8_t header[RECORD_HEADER];
+    header[0]    = RECORD_PENDING;
+    header[1]    = len;
+    header[2]    = priority;
+    uint16_t crc = LoRa_AT_CRC16(header + 1, 2);
+    crc          = LoRa_AT_CRC16(buff, len, crc);
+    header[3]    = crc >> 8;
+    header[4]    = crc & 0xFF;
+    if (!ringWrite(_head, header, RECORD_HEADER) ||
+        !ringWrite(advance(_head, RECORD_HEADER), buff, len) ||
+        !_storage.sync()) {
+      return false;
+    }
+    _head = advance(_head, need);
+    _count++;
+    return commit();
+  }
+
+  /**
+   * @brief Send one waiting payload if the module is joined and the drain
+   * interval has passed since the last one.
+   *
+   * If an airtime budget is attached to the modem, the payload is also only
+   * sent once it fits within the budget.
+   *
+   * Call this regularly from the main loop.
+   *
+   * @return True if a payload was sent
+   */
+  bool maintain() {
+    if (!_count || !_modem.isJoined()) { return false; }
+    if (_drainInterval && LORA_AT_MILLIS() - _lastDrain < _drainInterval) {
+      return false;
+    }
+    return sendNext();
+  }
+
+  /**
+   * @brief Choose which payload is sent first.
+   *
+   * @param order The drain order
+   */
+  void setDrainOrder(LoRa_AT_DrainOrder order) {
+    _order = order;
+  }
+
+  /**
+   * @brief Set the shortest time between sending two stored payloads, so
+   * that draining a long queue does not use up the duty-cycle budget.
+   *
+   * @param interval_ms The time in milliseconds; 0 to send a stored payload
+   * on every call to maintain()
+   */
+  void setDrainInterval(uint32_t interval_ms) {
+    _drainInterval = interval_ms;
+  }
+
+  /**
+   * @brief Get the number of payloads waiting to be sent.
+   *
+   * @return The number of payloads waiting
+   */
+  uint16_t pending() const {
+    return _count;
+  }
+
+  /**
+   * @brief Get the number of payloads dropped because the queue was full or
+   * the payload was damaged in storage.
+   *
+   * @return The number of payloads dropped
+   */
+  uint32_t dropped() const {
+    return _dropped;
+  }
+
+ protected:
+  static const uint8_t RECORD_HEADER  = 5;
+  static const uint8_t RECORD_PENDING = 0xA5;
+  static const uint8_t RECORD_SENT    = 0x00;
+  static const uint8_t COMMIT_SIZE    = 14;
+
+  uint32_t dataStart() const {
+    return 2 * COMMIT_SIZE;
+  }
+  uint32_t dataSize() {
+    return _storage.size() - dataStart();
+  }
+  uint32_t used() {
+    return _head >= _tail ? _head - _tail : dataSize() - _tail + _head;
+  }
+  uint32_t advance(uint32_t pos, uint32_t n) {
+    pos += n;
+    return pos >= dataSize() ? pos - dataSize() : pos;
+  }
+
+  bool ringWrite(uint32_t pos, const uint8_t* buf, size_t len) {
+    size_t first = LoRa_AT_Min<size_t>(len, dataSize() - pos);
+    return _storage.write(dataStart() + pos, buf, first) &&
+        (first == len ||
+         _storage.write(dataStart(), buf + first, len - first));
+  }
+  bool ringRead(uint32_t pos, uint8_t* buf, size_t len) {
+    size_t first = LoRa_AT_Min<size_t>(len, dataSize() - pos);
+    return _storage.read(dataStart() + pos, buf, first) &&
+        (first == len || _storage.read(dataStart(), buf + first, len - first));
+  }
+
+  // Reads the header of the record at pos, off bytes from the tail; returns
+  // false if it is not a sensible record
+  bool readHeader(uint32_t pos, uint32_t off, uint8_t* header) {
+    if (!ringRead(pos, header, RECORD_HEADER)) { return false; }
+    if (header[0] != RECORD_PENDING && header[0] != RECORD_SENT) {
+      return false;
+    }
+    return header[1] && header[1] <= LORA_AT_STORE_MAX_RECORD &&
+        off + RECORD_HEADER + header[1] <= used();
+  }
+
+  // Writes the head and tail into the older of the two position records
+  bool commit() {
+    _seq++;
+    uint8_t  buf[COMMIT_SIZE];
+    uint32_t values[3] = {_seq, _head, _tail};
+    for (uint8_t i = 0; i < 3; i++) {
+      for (uint8_t b = 0; b < 4; b++) {
+        buf[i * 4 + b] = values[i] >> (24 - 8 * b);
+      }
+    }
+    uint16_t crc = LoRa_AT_CRC16(buf, 12);
+    buf[12]      = crc >> 8;
+    buf[13]      = crc & 0xFF;
+    return _storage.write((_seq & 1) * COMMIT_SIZE, buf, COMMIT_SIZE) &&
+        _storage.sync();
+  }
+
+  bool readCommit(uint8_t slot, uint32_t* values) {
+    uint8_t buf[COMMIT_SIZE];
+    if (!_storage.read(slot * COMMIT_SIZE, buf, COMMIT_SIZE)) { return false; }
+    uint16_t crc = LoRa_AT_CRC16(buf, 12);
+    if (buf[12] != (crc >> 8) || buf[13] != (crc & 0xFF)) { return false; }
+    for (uint8_t i = 0; i < 3; i++) {
+      values[i] = 0;
+      for (uint8_t b = 0; b < 4; b++) {
+        values[i] = (values[i] << 8) | buf[i * 4 + b];
+      }
+    }
+    return true;
+  }
+
+  // Moves the tail past the oldest record, dropping it if it wasn't sent
+  void dropOldest() {
+    uint8_t header[RECORD_HEADER];
+    if (!readHeader(_tail, 0, header)) {
+      // nothing after a damaged record can be found again
+      _dropped += _count;
+      _count = 0;
+      _tail  = _head;
+      return;
+    }
+    if (header[0] == RECORD_PENDING) {
+      _count--;
+      _dropped++;
+    }
+    _tail = advance(_tail, RECORD_HEADER + header[1]);
+  }
+
+  // Finds, sends and marks the next record to drain
+  bool sendNext() {
+    uint8_t  header[RECORD_HEADER];
+    uint32_t off     = 0;
+    uint32_t found   = 0;
+    int16_t  bestPri = -1;
+    while (off < used()) {
+      uint32_t pos = advance(_tail, off);
+      if (!readHeader(pos, off, header)) { break; }
+      if (header[0] == RECORD_PENDING && header[2] > bestPri) {
+        found   = pos;
+        bestPri = header[2];
+        if (_order == LORA_AT_DRAIN_OLDEST) { break; }
+      }
+      off += RECORD_HEADER + header[1];
+    }
+    if (bestPri < 0) { return false; }
+    ringRead(found, header, RECORD_HEADER);
+    uint8_t len = header[1];
+    bool    ok  = ringRead(advance(found, RECORD_HEADER), _buf, len);
+    if (ok) {
+      uint16_t crc = LoRa_AT_CRC16(header + 1, 2);
+      crc          = LoRa_AT_CRC16(_buf, len, crc);
+      ok = header[3] == (crc >> 8) && header[4] == (crc & 0xFF);
+    }
+    if (!ok) {
+      DBG(GF("### Dropping damaged stored payload"));
+      _dropped++;
+    } else {
+      // leave it for later if it doesn't fit in the airtime budget
+      if (_modem.timeUntilSendAllowed(len)) { return false; }
+      _lastDrain = LORA_AT_MILLIS();
+      if (!_modem.beginSend(_buf, len)) { return false; }
+      while (_modem.poll()) { LORA_AT_YIELD(); }
+      if (_modem.sendStatus() != LORA_AT_SEND_DONE) { return false; }
+    }
+    markSent(found);
+    return ok;
+  }
+
+  // Marks a record as sent and moves the tail past any sent records
+  void markSent(uint32_t pos) {
+    uint8_t state = RECORD_SENT;
+    ringWrite(pos, &state, 1);
+    _storage.sync();
+    _count--;
+    uint8_t header[RECORD_HEADER];
+    while (_tail != _head && readHeader(_tail, 0, header) &&
+           header[0] == RECORD_SENT) {
+      _tail = advance(_tail, RECORD_HEADER + header[1]);
+    }
+    commit();
+  }
+
+  modemType&         _modem;
+  LoRa_AT_Storage&   _storage;
+  uint32_t           _head;
+  uint32_t           _tail;
+  uint32_t           _seq;
+  uint16_t           _count;
+  uint32_t           _dropped;
+  LoRa_AT_DrainOrder _order;
+  uint32_t           _drainInterval;
+  uint32_t           _lastDrain;
+  uint8_t            _buf[LORA_AT_STORE_MAX_RECORD];
+};
+
+#endif  // SRC_LORA_AT_STORE_H_
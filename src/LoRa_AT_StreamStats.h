@@ -0,0 +1,121 @@
+/**
+ * @file       LoRa_AT_StreamStats.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#ifndef SRC_LORA_AT_STREAMSTATS_H_
+#define SRC_LORA_AT_STREAMSTATS_H_
+
+#include "LoRa_AT_Common.h"
+
+/**
+ * @brief A pass-through stream that counts the traffic between the library and
+ * the LoRa module.
+ *
+ * Put this between the serial port and the modem object, the same way you
+ * would use a StreamDebugger, to measure how many AT commands and how many
+ * bytes each library call costs. It works the same way on a board and on a
+ * host with a simulated module behind the wrapped stream.
+ *
+ * @code{.cpp}
+ * LoRa_AT_StreamStats stats(SerialAT);
+ * LoRa_AT             modem(stats);
+ * ...
+ * stats.reset();
+ * modem.getPort();
+ * SerialMon.println(stats.commandsSent());  // 1
+ * @endcode
+ */
+class LoRa_AT_StreamStats : public Stream {
+ public:
+  explicit LoRa_AT_StreamStats(Stream& stream) : _stream(stream) {
+    reset();
+  }
+
+  /**
+   * @brief Set all of the counters back to zero.
+   */
+  void reset() {
+    _commandsSent = 0;
+    _bytesWritten = 0;
+    _bytesRead    = 0;
+  }
+
+  /**
+   * @brief Get the number of complete lines - that is, AT commands - written
+   * to the module since the last reset.
+   *
+   * @return The number of AT commands sent
+   */
+  uint32_t commandsSent() const {
+    return _commandsSent;
+  }
+
+  /**
+   * @brief Get the number of bytes written to the module since the last reset.
+   *
+   * @return The number of bytes written
+   */
+  uint32_t bytesWritten() const {
+    return _bytesWritten;
+  }
+
+  /**
+   * @brief Get the number of bytes read from the module since the last reset.
+   *
+   * @return The number of bytes read
+   */
+  uint32_t bytesRead() const {
+    return _bytesRead;
+  }
+
+  /*
+   * Stream functions
+   */
+  size_t write(uint8_t c) override {
+    size_t n = _stream.write(c);
+    count(&c, n);
+    return n;
+  }
+
+  size_t write(const uint8_t* buf, size_t size) override {
+    size_t n = _stream.write(buf, size);
+    count(buf, n);
+    return n;
+  }
+
+  int available() override {
+    return _stream.available();
+  }
+
+  int read() override {
+    int c = _stream.read();
+    if (c >= 0) { _bytesRead++; }
+    return c;
+  }
+
+  int peek() override {
+    return _stream.peek();
+  }
+
+  void flush() override {
+    _stream.flush();
+  }
+
+ private:
+  void count(const uint8_t* buf, size_t size) {
+    _bytesWritten += size;
+    for (size_t i = 0; i < size; i++) {
+      if (buf[i] == '\n') { _commandsSent++; }
+    }
+  }
+
+  Stream&  _stream;
+  uint32_t _commandsSent;
+  uint32_t _bytesWritten;
+  uint32_t _bytesRead;
+};
+
+#endif  // SRC_LORA_AT_STREAMSTATS_H_
@@ -134,7 +134,24 @@ class LoRa_AT_Time {
    * @return The date and/or time from the module
    */
   String getDateTimeString(LoRa_AT_DateTimeFormat format) {
-    return thisModem().getDateTimeStringImpl(format);
+    char buff[LORA_AT_STRING_BUFFER];
+    getDateTimeString(format, buff, sizeof(buff));
+    return String(buff);
+  }
+
+  /**
+   * @brief Get the Date Time into a buffer, without using a String
+   *
+   * @param format The date or time part to get: DATE_FULL,
+   * DATE_TIME, or DATE_DATE
+   * @param buff The buffer to write the date and/or time to; left empty if it
+   * could not be read
+   * @param size The size of the buffer
+   * @return True if the date and/or time was read from the module
+   */
+  bool getDateTimeString(LoRa_AT_DateTimeFormat format, char* buff,
+                         size_t size) {
+    return thisModem().getDateTimeStringImpl(format, buff, size);
   }
 
   /**
@@ -194,8 +211,8 @@ class LoRa_AT_Time {
    * Time functions
    */
  protected:
-  String getDateTimeStringImpl(LoRa_AT_DateTimeFormat format)
-      LORA_AT_ATTR_NOT_IMPLEMENTED;
+  bool getDateTimeStringImpl(LoRa_AT_DateTimeFormat format, char* buff,
+                             size_t size) LORA_AT_ATTR_NOT_IMPLEMENTED;
 
   bool getDateTimePartsImpl(int* year, int* month, int* day, int* hour,
                             int* minute, int* second,
@@ -39,6 +39,32 @@
 #include "LoRa_AT_Temperature.tpp"
 #include "LoRa_AT_Sleep.tpp"
 
+// URCs handled by the Wio-E5, in the order they are checked
+static constexpr char WIOE5_URC_WAKEUP[] LORA_AT_PROGMEM =
+    "+LOWPOWER: WAKEUP" AT_NL;
+static constexpr char WIOE5_URC_NOT_JOINED[] LORA_AT_PROGMEM =
+    ": Please join network first" AT_NL;
+static constexpr char WIOE5_URC_DOWNLINK[] LORA_AT_PROGMEM = ": PORT: ";
+static constexpr char WIOE5_URC_RXWIN[] LORA_AT_PROGMEM    = ": RXWIN";
+static constexpr char WIOE5_URC_LINK[] LORA_AT_PROGMEM     = ": Link";
+
+/// The index of each URC in the Wio-E5 URC table
+enum LoRa_AT_WioE5_URC {
+  WIOE5_WAKEUP = 0,
+  WIOE5_NOT_JOINED,
+  WIOE5_DOWNLINK,
+  WIOE5_RXWIN,
+  WIOE5_LINK,
+};
+static constexpr LoRa_AT_Response WIOE5_URCS[] = {
+    LoRa_AT_MakeResponse(WIOE5_URC_WAKEUP),
+    LoRa_AT_MakeResponse(WIOE5_URC_NOT_JOINED),
+    LoRa_AT_MakeResponse(WIOE5_URC_DOWNLINK),
+    LoRa_AT_MakeResponse(WIOE5_URC_RXWIN),
+    LoRa_AT_MakeResponse(WIOE5_URC_LINK),
+};
+static constexpr uint32_t WIOE5_URC_MASK = LoRa_AT_FinalCharMask(WIOE5_URCS);
+
 class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
                       public LoRa_AT_Time<LoRa_AT_WioE5>,
                       public LoRa_AT_Radio<LoRa_AT_WioE5>,
@@ -87,9 +113,24 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     prev_dl_check        = 0;
     inLowestPowerMode    = false;
     _requireConfirmation = false;
-    _msg_quality         = 0;
+    _sendConfirmed       = false;
+    _sendRetries         = -1;
+    _sendStatus          = LORA_AT_SEND_IDLE;
+    _joinStatus          = LORA_AT_JOIN_IDLE;
+    _airtime             = nullptr;
+    _planRegion          = -1;
+    _planDataRate        = -1;
+    _planMacEmpty        = false;
     _link_margin         = 255;
     _networkConnected    = false;
+    _channelCommands     = 0;
+    _linkStaleness       = LORA_AT_LINK_STALENESS;
+
+    _confirmRetries       = -1;
+    _restorePort          = -1;
+    _settingWrites        = 0;
+    _settingWritesAvoided = 0;
+    _shadowValid          = 0;
   }
 
 
@@ -107,40 +148,45 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
    */
   template <typename... Args>
   inline void sendAT(Args... cmd) {
-    if (inLowestPowerMode) {
-      // If extremely low power mode is enabled, when sending commands to
-      // modem, at least four 0xFFs need to be added to the start of each AT
-      // command.
-      for (uint8_t i = 0; i < 4; i++) { stream.write(0xFF); }
-    }
+    writeWakeUp();
     streamWrite("AT", cmd..., AT_NL);
     stream.flush();
     LORA_AT_YIELD(); /* DBG("### AT:", cmd...); */
   }
 
   bool testATImpl(uint32_t timeout_ms = 10000L) {
-    for (uint32_t start = millis(); millis() - start < timeout_ms;) {
+    for (uint32_t start = LORA_AT_MILLIS();
+         LORA_AT_MILLIS() - start < timeout_ms;) {
       sendAT(GF(""));
       if (waitResponse(200) == 1) { return true; }
-      delay(100);
+      LORA_AT_DELAY(100);
     }
     // if it fails, try testing again with the extra 0xFF wake-ups for low
     // power mode
     DBG(GF("Trying low-power test!"));
     inLowestPowerMode = true;
-    for (uint32_t start = millis(); millis() - start < timeout_ms;) {
+    for (uint32_t start = LORA_AT_MILLIS();
+         LORA_AT_MILLIS() - start < timeout_ms;) {
       sendAT(GF(""));
       if (waitResponse(200) == 1) {
         DBG("### Wio-E5 is in auto low power mode.");
         return true;
       }
-      delay(100);
+      LORA_AT_DELAY(100);
     }
     inLowestPowerMode = false;
     return false;
   }
 
  protected:
+  // Starts every command written to the module; if extremely low power mode
+  // is enabled, at least four 0xFFs need to be added to the start of each AT
+  // command to wake the module.
+  void writeWakeUp() {
+    if (!inLowestPowerMode) { return; }
+    for (uint8_t i = 0; i < 4; i++) { stream.write(0xFF); }
+  }
+
   bool initImpl() {
     DBG(GF("### LoRa_AT Version:"), LORA_AT_VERSION);
     DBG(GF("### LoRa_AT Compiled Module:  LoRa_AT_WioE5"));
@@ -171,27 +217,22 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     return resp;
   }
 
-  String getDevEUIImpl() {
-    String resp;
-    sendAT(GF("+ID=DevEUI"));
-    if (waitResponse(GF("+ID: DevEui, ")) != 1) { return "UNKNOWN"; }
-    resp = stream.readString();
-    resp.trim();
-    return resp;
+  bool getDevEUIImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+ID=DevEUI"), GF("+ID: DevEui, "), buff, size);
   }
 
-  String getModuleInfoImpl() {
-    String info = "Firmware: ";
-    info += sendATGetString(GF("+VER"));
-    info += " LoRaWan: ";
-    String info2;
-    sendAT(GF("+LW=VER"));
-    if (waitResponse(GF("+LW: VER, ")) != 1) {
-      info2 = "UNKNOWN";
-    } else {
-      info2 = stream.readStringUntil('\r');
-    }
-    return info + info2;
+  bool getModuleInfoImpl(char* buff, size_t size) {
+    LoRa_AT_ResponseBuffer info(buff, size);
+    char                   part[LORA_AT_STRING_BUFFER];
+    info.append("Firmware: ");
+    bool success = sendATGetString(GF("+VER"), GF("+VER: "), part,
+                                   sizeof(part));
+    info.append(part);
+    success &= sendATGetString(GF("+LW=VER"), GF("+LW: VER, "), part,
+                               sizeof(part));
+    info.append(" LoRaWan: ");
+    info.append(part);
+    return success;
   }
 
   bool factoryDefaultImpl() {
@@ -209,7 +250,7 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     sendAT(GF("+RESET"));  // Reset (restart) the CPU
     bool resp = waitResponse(GF("+RESET: OK")) == 1;
     if (resp) {
-      delay(5000L);  // give it a chance to reset
+      LORA_AT_DELAY(5000L);  // give it a chance to reset
       return init();
     };
     return false;
@@ -264,11 +305,12 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');  // throw away the new line
     return resp;
   }
-  bool getPublicNetworkImpl() {
+  bool getPublicNetworkImpl(bool& isPublic) {
     sendAT(GF("+LW=NET"));
-    bool resp = waitResponse(GF("ON"), GF("OFF")) == 1;
+    int8_t resp = waitResponse(GF("ON"), GF("OFF"));
     streamFind('\n');  // throw away the new line
-    return resp;
+    isPublic = resp == 1;
+    return resp > 0;
   }
 
   bool setConfirmationRetriesImpl(int8_t numAckRetries) {
@@ -278,16 +320,32 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');  // throw away the new line
     return resp;
   }
-  int8_t getConfirmationRetriesImpl() {
+  bool getConfirmationRetriesImpl(int8_t& numAckRetries) {
     sendAT(GF("+RETRY"));
-    waitResponse(GF("+RETRY: "));
-    int8_t resp = stream.parseInt();
+    bool resp     = waitResponse(GF("+RETRY: ")) == 1;
+    numAckRetries = stream.parseInt();
     streamFind('\n');  // throw away the new line
     return resp;
   }
 
   bool joinOTAAImpl(const char* appEui, const char* appKey, const char* devEui,
-                    int8_t attempts, uint32_t initialBackoff, bool) {
+                    int8_t attempts, uint32_t initialBackoff, bool useHex) {
+    setOTAAKeys(appEui, appKey, devEui, useHex);
+    return join(attempts, initialBackoff);  // join the network
+  }
+
+  bool beginJoinOTAAImpl(const char* appEui, const char* appKey,
+                         const char* devEui, int8_t attempts,
+                         uint32_t initialBackoff, bool useHex) {
+    if (_sendStatus == LORA_AT_SEND_BUSY || _joinStatus == LORA_AT_JOIN_BUSY) {
+      return false;
+    }
+    setOTAAKeys(appEui, appKey, devEui, useHex);
+    return beginJoinImpl(attempts, initialBackoff, false);
+  }
+
+  void setOTAAKeys(const char* appEui, const char* appKey, const char* devEui,
+                   bool) {
     // The App EUI must be a hex value
     sendAT(GF("+ID=AppEui, \""), appEui, '"');
     waitResponse(GF("+ID: AppEui"));  // echos the set command
@@ -302,12 +360,11 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
       streamFind('\n');  // throw away the echoed Device EUI
     }
     changeModes(OTAA);
-    return join(attempts, initialBackoff);  // join the network
   }
 
-  bool joinABPImpl(String devAddr, String nwkSKey, String appSKey,
-                   int uplinkCounter, int downlinkCounter, int8_t attempts,
-                   uint32_t initialBackoff) {
+  bool joinABPImpl(const char* devAddr, const char* nwkSKey,
+                   const char* appSKey, int uplinkCounter, int downlinkCounter,
+                   int8_t attempts, uint32_t initialBackoff) {
     sendAT(GF("+ID=DevAddr, \""), devAddr, '"');  // set the device address
     waitResponse(GF("+ID: DevAddr"));             // echos the set command
     streamFind('\n');  // throw away the echoed Device Address
@@ -349,7 +406,7 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
         // delay before the next attempt
         uint32_t backoff = calculateBackoff(attempts_made, initialBackoff);
         DBG(GF("Delay"), backoff, GF("ms before next LinkCheckReq attempt"));
-        delay(backoff);
+        LORA_AT_DELAY(backoff);
       }
     }
     if (_link_margin != 255) {
@@ -360,18 +417,29 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     return _link_margin != 255;
   }
 
+  int16_t getMaxPayloadSizeImpl() {
+    sendAT(GF("+LW=LEN"));
+    if (waitResponse(GF("+LW: LEN,")) != 1) { return -1; }  // echo
+    int16_t resp = stream.parseInt();
+    streamFind('\n');  // throw away the new line
+    return resp;
+  }
+
   int8_t getSignalQualityImpl() {
     // the RSSI is returned when reading a message
     // you can also get the RSSI by entering test mode, but this causes you to
     // drop off the network and requires you to rejoin
-    int8_t tries_remaining = 5;
-    while (_msg_quality == 0 && tries_remaining) {
+    // keep sending until a downlink newer than the first try is heard
+    uint32_t start           = LORA_AT_MILLIS();
+    int8_t   tries_remaining = 5;
+    while (_linkHistory.age(LORA_AT_LINK_RSSI) > LORA_AT_MILLIS() - start &&
+           tries_remaining) {
       DBG(GF("Sending empty message to get RSSI"), tries_remaining,
           GF("tries remaining"));
       modemSend(nullptr, 0);
       tries_remaining--;
     }
-    return _msg_quality;
+    return _linkHistory.latest(LORA_AT_LINK_RSSI);
   }
 
 
@@ -387,12 +455,13 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');  // throw away the new line
     return resp;
   }
-  _lora_class getClassImpl() {
+  bool getClassImpl(_lora_class& _class) {
     sendAT(GF("+CLASS"));
-    waitResponse(GF("+CLASS: "));
+    bool   resp     = waitResponse(GF("+CLASS: ")) == 1;
     int8_t devClass = waitResponse(GF("A"), GF("B"), GF("C"));
     streamFind('\n');  // throw away the new line
-    return (_lora_class)(devClass - 1 + 'A');
+    _class = (_lora_class)(devClass - 1 + 'A');
+    return resp && devClass > 0;
   }
 
   bool setPortImpl(uint8_t _port) {
@@ -402,10 +471,10 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');  // throw away the new line
     return resp;
   }
-  uint8_t getPortImpl() {
+  bool getPortImpl(uint8_t& _port) {
     sendAT(GF("+PORT"));
-    waitResponse(GF("+PORT: "));  // always echos
-    int8_t resp = stream.parseInt();
+    bool resp = waitResponse(GF("+PORT: ")) == 1;  // always echos
+    _port     = stream.parseInt();
     streamFind('\n');  // throw away the new line
     return resp;
   }
@@ -416,24 +485,43 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');  // throw away the returned band
     return resp;
   }
-  String getBandImpl() {
+  bool getBandImpl(char* buff, size_t size) {
     sendAT(GF("+DR=SCHEME"));
-    waitResponse(GF("+DR: "));
-    String resp = stream.readStringUntil('\r');
+    bool resp = waitResponse(GF("+DR: ")) == 1;
+    streamReadUntil('\r', buff, size);
     streamDump();  // throw away all the details about the band data rates
     return resp;
   }
 
-  // these don't seem to exist
-  bool   setFrequencySubBandImpl(int8_t subBand) LORA_AT_ATTR_NOT_AVAILABLE;
-  int8_t getFrequencySubBandImpl() LORA_AT_ATTR_NOT_AVAILABLE;
+  // There's no sub-band command, so the sub-band is set and found from the
+  // channel mask
+  bool setFrequencySubBandImpl(int8_t subBand) {
+    if (subBand < 0 || subBand > 8) { return false; }
+    return setChannelMask(LoRa_AT_ChannelMask::subBand(subBand));
+  }
+  // A mask that isn't a single sub-band is read as sub-band -1
+  bool getFrequencySubBandImpl(int8_t& subBand) {
+    LoRa_AT_ChannelMask mask;
+    subBand = -1;
+    if (!getChannelMask(mask)) { return false; }
+    for (int8_t band = 0; band <= 8; band++) {
+      if (mask == LoRa_AT_ChannelMask::subBand(band)) {
+        subBand = band;
+        break;
+      }
+    }
+    return true;
+  }
+
+  // The whole mask is written out as 18 characters
+  static constexpr uint8_t CHANNEL_MASK_DIGITS = 18;
 
   // There isn't a simple way to get the whole mask!
-  String getChannelMaskImpl() {
+  bool getChannelMaskImpl(LoRa_AT_ChannelMask& mask) {
     // start with an empty mask
-    uint8_t channelsMask[LORA_CHANNEL_BYTES] = {0};
+    mask = LoRa_AT_ChannelMask();
     sendAT(GF("+CH"));  // request all channel type_info
-    waitResponse(GF("+CH: "));
+    if (waitResponse(GF("+CH: ")) != 1) { return false; }
     int8_t num_active_channels = 0;
     // bool   all_inactive = waitResponse(50, GF("No channel is activated"))
     // == 1;
@@ -449,44 +537,61 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
       streamFind(',');  // skip the ,
       streamFind(';');  // skip the channel data rates
 
-      // get the channel position in the array
-      int row = getChannelOffset(active_channel_num);
-      // convert the channel position into a mask
-      uint8_t mask = getChannelBitMask(active_channel_num);
-
-      // add this channel mask to the full mask
-      channelsMask[row] = channelsMask[row] | mask;
-      // #ifdef LORA_AT_DEBUG
-      //       String binPrint = "";
-      //       int8_t bin_len  = String(channelsMask[row], BIN).length();
-      //       for (int8_t z = 0; z < 8 - bin_len; z++) { binPrint += "0"; }
-      //       binPrint += String(channelsMask[row], BIN);
-      //       DBG(GF("Current Row Mask:"), binPrint);
-      // #endif
+      // add this channel to the full mask
+      mask.set(active_channel_num);
     }
+    return true;
+  }
 
-    // convert the completed channel mask to a string
-    return createHexChannelMask(channelsMask);
+  // The whole list of enabled channels can be given as ranges in a single
+  // command, so that is used unless only one channel changes. If the module
+  // won't take the list, each channel that changes is turned on or off by
+  // itself.
+  bool applyChannelMaskImpl(const LoRa_AT_ChannelMask& newMask,
+                            const LoRa_AT_ChannelMask* current) {
+    if (current == nullptr || newMask.diff(*current).count() > 1) {
+      if (newMask.any() && writeChannelList(newMask)) { return true; }
+    }
+    LoRa_AT_ChannelMask read;
+    if (current == nullptr) {
+      _channelCommands++;
+      if (!getChannelMaskImpl(read)) { return false; }
+      current = &read;
+    }
+    LoRa_AT_ChannelMask changed = newMask.diff(*current);
+    for (uint8_t i = 0; i < MAX_LORA_CHANNELS; i++) {
+      if (changed.test(i) && !writeChannel(i, newMask.test(i))) {
+        return false;
+      }
+    }
+    return true;
   }
 
-  bool isChannelEnabledImpl(int pos) {
-    sendAT(GF("+CH="), pos);  // request all channel type_info
-    waitResponse(GF("+CH: "));
-    // if enabled, it will return the frequency and data rate
-    // +CH: 1,902500000,DR0:DR3
-    // if disabled, the return frequency will be 0
-    // +CH: 1,0,DR0:DR0
-    uint8_t ret_channel = stream.parseInt();
-    // DBG(GF("Returned channel:"), ret_channel);
-    streamFind(',');  // skip the , after the channel number
-    uint32_t ret_freq = stream.parseInt();
-    // DBG(GF("Channel frequency:"), ret_freq);
-    streamFind(',');   // skip the , after the frequency
-    streamFind('\n');  // dump the data rates
-    return ret_channel == pos && ret_freq > 0;
+  // Enables only the channels in the mask, written as ranges: AT+CH=NUM,8-15,65
+  bool writeChannelList(const LoRa_AT_ChannelMask& mask) {
+    _channelCommands++;
+    writeWakeUp();
+    stream.print(GF("AT+CH=NUM"));
+    for (uint8_t i = 0; i < MAX_LORA_CHANNELS; i++) {
+      if (!mask.test(i) || (i > 0 && mask.test(i - 1))) { continue; }
+      uint8_t last = i;
+      while (last + 1 < MAX_LORA_CHANNELS && mask.test(last + 1)) { last++; }
+      stream.print(',');
+      stream.print(i);
+      if (last > i) {
+        stream.print('-');
+        stream.print(last);
+      }
+    }
+    stream.print(AT_NL);
+    stream.flush();
+    bool resp = waitResponse(GF("+CH: NUM"), GF("ERROR")) == 1;
+    streamFind('\n');  // throw away the rest of the line
+    return resp;
   }
 
-  bool enableChannelImpl(int pos, bool enable) {
+  bool writeChannel(uint8_t pos, bool enable) {
+    _channelCommands++;
     sendAT(GF("+CH="), pos, ',', enable ? GF("ON") : GF("OFF"));
     bool resp = waitResponse(GF("+CH: CH"));
     // NOTE:  may be caps or not
@@ -497,35 +602,6 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     return resp;
   }
 
-  // There isn't a simple way to set the whole mask!
-  bool setChannelMaskImpl(const char* newMask) {
-    bool success = true;
-
-    uint8_t channelsMask[LORA_CHANNEL_BYTES] = {0};
-    // parse the hex mask into a bit array
-    parseChannelMask(newMask, channelsMask);
-
-    // iterate through max of 72 channels
-    for (uint8_t i = 0; i < 72; i++) {
-      // get the channel position in the array
-      int row = getChannelOffset(i);
-      // convert the channel position into a mask
-      uint8_t channel = getChannelBitMask(i);
-
-      bool channelEnabled = (channelsMask[row] & channel) > 0;
-      // DBG(GF("Channel"), i, GF("should be"),
-      //     channelEnabled ? GF("enabled") : GF("disabled"));
-
-      // enable or disable the channel
-      if (channelEnabled) {
-        success &= enableChannel(i);
-      } else {
-        success &= disableChannel(i);
-      }
-    }
-    return success;
-  }
-
 
   /*
    * LoRa Data Rate and Duty Cycle functions
@@ -541,12 +617,13 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');  // throw away the max duty cycle setting
     return resp;
   }
-  bool isDutyCycleEnabledImpl() {
+  bool isDutyCycleEnabledImpl(bool& dutyCycle) {
     sendAT(GF("+LW=DC"));
-    waitResponse(GF("+LW: DC"));  // echos your command
-    bool resp = waitResponse(GF("ON"), GF("OFF")) == 1;
+    bool   resp  = waitResponse(GF("+LW: DC")) == 1;  // echos your command
+    int8_t state = waitResponse(GF("ON"), GF("OFF"));
     streamFind('\n');  // throw away the new line
-    return resp;
+    dutyCycle = state == 1;
+    return resp && state > 0;
   }
 
   bool setMaxDutyCycleImpl(int8_t maxDutyCycle) {
@@ -558,13 +635,13 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');                           // throw away the new line
     return resp;
   }
-  int8_t getMaxDutyCycleImpl() {
+  bool getMaxDutyCycleImpl(int8_t& maxDutyCycle) {
     sendAT(GF("+LW=DC"));
-    waitResponse(GF("+LW: DC"));  // echos your command
-    waitResponse(GF("ON"),
-                 GF("OFF"));          // returns on/off for the duty cycle limit
-    int8_t resp = stream.parseInt();  // then returns the limit value
-    streamFind('\n');                 // throw away the new line
+    bool resp = waitResponse(GF("+LW: DC")) == 1;  // echos your command
+    // returns on/off for the duty cycle limit
+    resp &= waitResponse(GF("ON"), GF("OFF")) > 0;
+    maxDutyCycle = stream.parseInt();  // then returns the limit value
+    streamFind('\n');                  // throw away the new line
     return resp;
   }
 
@@ -575,10 +652,10 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');  // throw away the new line
     return resp;
   }
-  int8_t getDataRateImpl() {
+  bool getDataRateImpl(int8_t& dataRate) {
     sendAT(GF("+DR"));
-    waitResponse(GF("+DR: DR"));  // always echos
-    int8_t resp = stream.parseInt();
+    bool resp = waitResponse(GF("+DR: DR")) == 1;  // always echos
+    dataRate  = stream.parseInt();
     // throw away anything else in the long response
     streamDump();
     return resp;
@@ -591,11 +668,12 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     streamFind('\n');  // throw away the new line
     return resp;
   }
-  bool getAdaptiveDataRateImpl() {
+  bool getAdaptiveDataRateImpl(bool& useADR) {
     sendAT(GF("+ADR?"));
-    bool resp = waitResponse(GF("ON"), GF("OFF")) == 1;
+    int8_t resp = waitResponse(GF("ON"), GF("OFF"));
     streamFind('\n');  // throw away the new line
-    return resp;
+    useADR = resp == 1;
+    return resp > 0;
   }
 
 
@@ -604,21 +682,19 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
    */
  protected:
   // aka network address
-  String getDevAddrImpl() {
-    String resp;
-    sendAT(GF("+ID=DevAddr"));
-    if (waitResponse(GF("+ID: DevAddr, ")) != 1) { return "UNKNOWN"; }
-    return stream.readStringUntil('\r');
+  bool getDevAddrImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+ID=DevAddr"), GF("+ID: DevAddr, "), buff,
+                           size);
   }
 
   // network session key
-  String getNwkSKeyImpl() {
-    return "NOT READABLE";
+  bool getNwkSKeyImpl(char* buff, size_t size) {
+    return notReadable(buff, size);
   }
 
   // app session Key (data session key)
-  String getAppSKeyImpl() {
-    return "NOT READABLE";
+  bool getAppSKeyImpl(char* buff, size_t size) {
+    return notReadable(buff, size);
   }
 
 
@@ -627,15 +703,12 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
    */
  protected:
   // aka network id
-  String getAppEUIImpl() {
-    String resp;
-    sendAT(GF("+ID=AppEui"));
-    if (waitResponse(GF("+ID: AppEui, ")) != 1) { return "UNKNOWN"; }
-    return stream.readStringUntil('\r');
+  bool getAppEUIImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+ID=AppEui"), GF("+ID: AppEui, "), buff, size);
   }
   // aka network key
-  String getAppKeyImpl() {
-    return "NOT READABLE";
+  bool getAppKeyImpl(char* buff, size_t size) {
+    return notReadable(buff, size);
   }
 
 
@@ -643,23 +716,23 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
    * Time functions
    */
  protected:
-  String getDateTimeStringImpl(LoRa_AT_DateTimeFormat format) {
+  bool getDateTimeStringImpl(LoRa_AT_DateTimeFormat format, char* buff,
+                             size_t size) {
+    if (size) { buff[0] = '\0'; }
     deviceTimeRequest();
     sendAT(GF("+RTC=FULL"));
-    if (waitResponse(2000L, GF("+RTC: ")) != 1) { return ""; }
-
-    String res;
+    if (waitResponse(2000L, GF("+RTC: ")) != 1) { return false; }
 
     switch (format) {
-      case DATE_FULL: res = stream.readStringUntil(','); break;
+      case DATE_FULL: streamReadUntil(',', buff, size); break;
       case DATE_TIME:
         streamFind(' ');  // skip until the next blank space
-        res = stream.readStringUntil(' ');
+        streamReadUntil(' ', buff, size);
         break;
-      case DATE_DATE: res = stream.readStringUntil(' '); break;
+      case DATE_DATE: streamReadUntil(' ', buff, size); break;
     }
     streamFind('\n');  // throw away epoch and age
-    return res;
+    return true;
   }
 
   bool getDateTimePartsImpl(int* year, int* month, int* day, int* hour,
@@ -795,117 +868,186 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
    */
  protected:
   int16_t modemSend(const uint8_t* buff, size_t len) {
-    // Pointer to where in the buffer we're up to
-    // A const cast is need to cast-away the constant-ness of the buffer (ie,
-    // modify it).
-    uint8_t* txPtr     = const_cast<uint8_t*>(buff);
-    size_t   bytesSent = 0;
+    return sendBlocking(buff, len);
+  }
 
-    GsmConstStr at_msg_cmd;
-#ifdef LORA_AT_SEND_HEX
-    at_msg_cmd = GF("+MSGHEX");
-#else
-    if (_requireConfirmation && len > 0) {
-      at_msg_cmd = GF("+CMSG");  // cannot carry 0 payload
-    } else if (_requireConfirmation) {
-      // must use CMSGHEX to have confirmation and 0 payload
-      at_msg_cmd = GF("+CMSGHEX");
-    } else {
-      at_msg_cmd = GF("+MSG");
-    }
-#endif
+  // The steps of a send; each uplink queries the free space, sends the
+  // message, and waits for the start and end (and ACK) notices.
+  enum WioE5SendStep : uint8_t {
+    WIOE5_SEND_QUERY_LEN = 0,
+    WIOE5_SEND_WAIT_LEN,
+    WIOE5_SEND_MSG,
+    WIOE5_SEND_WAIT_START,
+    WIOE5_SEND_WAIT_DONE,
+    WIOE5_SEND_WAIT_ACK_DONE,
+  };
 
-    do {
-      // make no more than 5 attempts at the single send command
-      int8_t send_attempts = 0;
-      bool   send_success  = false;
-      while (send_attempts < 5 && !send_success) {
-        uint8_t sendLength =
-            0;  // Number of bytes to send from buffer in this command
+  bool beginSendImpl(const uint8_t* buff, size_t len, bool whole) {
+    // nothing may be sent to the module while a send or join is under way
+    if (!canStartSend(len, whole)) { return false; }
+    // the retries are only used by confirmed messages, so only change them
+    // for one that needs a different number from the last
+    int8_t retries = _sendRetries >= 0 ? _sendRetries : _confirmRetries;
+    if (_sendConfirmed && retries >= 0) {
+      writeConfirmationRetries(retries);
+    }
+    return startSend(buff, len, whole);
+  }
 
+  LoRa_AT_SendStatus pollSendImpl() {
+    uint32_t sendTimeout = _sendConfirmed ? DEFAULT_ACKMESSAGE_TIMEOUT
+                                          : DEFAULT_MESSAGE_TIMEOUT;
+    int8_t   index;
+    switch (_sendStep) {
+      case WIOE5_SEND_QUERY_LEN: {
         // check how many bytes are available for the next uplink
+        if (_sendLen == 0) {
+          _sendChunk = 0;
+          _sendStep  = WIOE5_SEND_MSG;
+          break;
+        }
+        // skip the query if nothing could have changed the space
+        if (usePlannedChunk()) {
+          _sendStep = WIOE5_SEND_MSG;
+          break;
+        }
+        sendAT(GF("+LW=LEN"));
+        startAsyncWait(1000L, GF("+LW: LEN,"));  // echo
+        _sendStep = WIOE5_SEND_WAIT_LEN;
+        break;
+      }
+      case WIOE5_SEND_WAIT_LEN: {
+        index = pollAsyncWait();
+        if (index < 0) { break; }
         uint8_t uplinkAvailable = 0;
-        if (len != 0) {
-          sendAT(GF("+LW=LEN"));
-          waitResponse(GF("+LW: LEN,"));  // echo
+        if (index == 1) {
           uplinkAvailable = stream.parseInt();
           streamFind('\n');  // throw away the new line
-          DBG(uplinkAvailable, GF("bytes available for uplink."),
-              !uplinkAvailable ? GF("Flush the MAC buffer with empty message.")
-                               : GF(" "));
         }
-
-        // Ensure the program doesn't read past the allocated memory
-        sendLength = uplinkAvailable;
-        if (txPtr + uplinkAvailable > const_cast<uint8_t*>(buff) + len) {
-          sendLength = const_cast<uint8_t*>(buff) + len - txPtr;
+        DBG(uplinkAvailable, GF("bytes available for uplink."),
+            !uplinkAvailable ? GF("Flush the MAC buffer with empty message.")
+                             : GF(" "));
+        if (!setSendChunk(uplinkAvailable)) {
+          _sendStatus = LORA_AT_SEND_FAILED;
+          break;
         }
-        // if there's no space available to send data, the queue is full of MAC
-        // commands and we need to send empty messages to flush them out
-        if (uplinkAvailable == 0 || len == 0) {
-          sendAT(at_msg_cmd);
-        } else {
-          // start the send command
-          if (inLowestPowerMode) {
-            // If extremely low power mode is enabled, when sending commands
-            // to modem, at least four 0xFFs need to be added to the start of
-            // each AT command.
-            for (uint8_t i = 0; i < 4; i++) { stream.write(0xFF); }
-          }
-          stream.write("AT");
-          stream.print(at_msg_cmd);
-          stream.write("=\"");
-#ifdef LORA_AT_SEND_HEX
-          // write everything as hex characters
-          writeHex(txPtr, sendLength);
-#else
-          // write out the number of bytes that are available for this uplink
-          stream.write(reinterpret_cast<const uint8_t*>(txPtr), sendLength);
-#endif
-          stream.write('"');
-          // finish with a new line
-          stream.println();
-          stream.flush();
+        _sendStep = WIOE5_SEND_MSG;
+        break;
+      }
+      case WIOE5_SEND_MSG: {
+        if (!airtimeAllows()) {
+          _sendStatus = LORA_AT_SEND_FAILED;
+          break;
         }
-
+        writeSendCommand();
         // always sends a start notice
-        waitResponse(GF(": Start"));
+        startAsyncWait(1000L, GF(": Start"));
+        _sendStep = WIOE5_SEND_WAIT_START;
+        break;
+      }
+      case WIOE5_SEND_WAIT_START: {
+        index = pollAsyncWait();
+        if (index < 0) { break; }
+        if (index == 1) { recordAirtime(); }
         // the downlink should be processed by handle URCs
-        uint32_t sendTimeout;
-        if (_requireConfirmation) {
-          sendTimeout = DEFAULT_ACKMESSAGE_TIMEOUT;
+        if (_sendConfirmed) {
+          startAsyncWait(sendTimeout, GF(": ACK Received"), GF(": Done"));
         } else {
-          sendTimeout = DEFAULT_MESSAGE_TIMEOUT;
+          startAsyncWait(sendTimeout, GF(": Done"));
         }
-        if (_requireConfirmation) {
-          if (waitResponse(sendTimeout, GF(": ACK Received"), GF(": Done")) ==
-              1) {
-            bytesSent += sendLength;   // bump up number of bytes sent
-            txPtr += sendLength;       // bump up the pointer
-            prev_dl_check = millis();  // mark that we checked for downlink
-            send_success  = true;
-            streamFind('\n');  // throw away the new line
-            waitResponse(sendTimeout, GF(": Done"));
-          } else {
+        _sendStep = WIOE5_SEND_WAIT_DONE;
+        break;
+      }
+      case WIOE5_SEND_WAIT_DONE: {
+        index = pollAsyncWait();
+        if (index < 0) { break; }
+        if (_sendConfirmed) {
+          if (index != 1) {
             DBG(GF("No ACK received on ACK message!"));
+            _sendStatus = LORA_AT_SEND_FAILED;
             break;
           }
+          streamFind('\n');  // throw away the new line
+          startAsyncWait(sendTimeout, GF(": Done"));
+          _sendStep = WIOE5_SEND_WAIT_ACK_DONE;
+          break;
+        }
+        if (index == 1) {
+          streamFind('\n');  // throw away the new line
+          finishUplink();
+        } else if (++_sendAttempts < 5) {
+          // make no more than 5 attempts at a single uplink, asking for the
+          // space again in case the planned size was wrong
+          forgetPlan(false);
+          _sendStep = WIOE5_SEND_QUERY_LEN;
         } else {
-          if (waitResponse(sendTimeout, GF(": Done")) == 1) {
-            bytesSent += sendLength;   // bump up number of bytes sent
-            txPtr += sendLength;       // bump up the pointer
-            prev_dl_check = millis();  // mark that we checked for downlink
-            send_success  = true;
-            streamFind('\n');  // throw away the new line
-          }
+          _sendStatus = LORA_AT_SEND_FAILED;
         }
-        DBG(send_attempts, send_success);
-        send_attempts++;
+        break;
+      }
+      case WIOE5_SEND_WAIT_ACK_DONE: {
+        if (pollAsyncWait() < 0) { break; }
+        finishUplink();
+        break;
       }
-      // if we completely failed after 5 attempts, bail from the whole thing
-      if (!send_success) { break; }
-    } while (bytesSent < len && _networkConnected);
-    return bytesSent;
+    }
+    return _sendStatus;
+  }
+
+  // Writes the message command for the current uplink
+  void writeSendCommand() {
+    GsmConstStr at_msg_cmd;
+#ifdef LORA_AT_SEND_HEX
+    at_msg_cmd = _sendConfirmed ? GF("+CMSGHEX") : GF("+MSGHEX");
+#else
+    if (_sendConfirmed && _sendLen > 0) {
+      at_msg_cmd = GF("+CMSG");  // cannot carry 0 payload
+    } else if (_sendConfirmed) {
+      // must use CMSGHEX to have confirmation and 0 payload
+      at_msg_cmd = GF("+CMSGHEX");
+    } else {
+      at_msg_cmd = GF("+MSG");
+    }
+#endif
+    if (_sendChunk == 0) {
+      sendAT(at_msg_cmd);
+      return;
+    }
+    // start the send command
+    writeWakeUp();
+    const uint8_t* txPtr = _sendBuff + _sendDone;
+    stream.write("AT");
+    stream.print(at_msg_cmd);
+    stream.write("=\"");
+#ifdef LORA_AT_SEND_HEX
+    // write everything as hex characters
+    writeHex(txPtr, _sendChunk);
+#else
+    // write out the number of bytes that are available for this uplink
+    stream.write(txPtr, _sendChunk);
+#endif
+    stream.write('"');
+    // finish with a new line
+    stream.println();
+    stream.flush();
+  }
+
+  // Counts an accepted uplink and moves on to the next one, if any
+  void finishUplink() {
+    _sendDone += _sendChunk;  // bump up number of bytes sent
+    // mark that we checked for downlink
+    prev_dl_check = LORA_AT_MILLIS();
+    if (_sendDone < _sendLen && _networkConnected &&
+        (_sendChunk || ++_sendAttempts < 5)) {
+      // Empty uplinks that only flushed MAC commands count against the
+      // attempts, so data that never fits can't keep us sending forever.
+      if (_sendChunk) { _sendAttempts = 0; }
+      _sendStep = WIOE5_SEND_QUERY_LEN;
+    } else if (_sendDone < _sendLen) {
+      _sendStatus = LORA_AT_SEND_FAILED;
+    } else {
+      _sendStatus = LORA_AT_SEND_DONE;
+    }
   }
 
   size_t modemRead() {
@@ -934,124 +1076,151 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
    * Utilities
    */
  private:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF("+LOWPOWER: WAKEUP" AT_NL))) {
-      // inLowestPowerMode = false;
-      // ^^ this is not the lowest power mode usingthe extra 0xFF characters
-      return true;
-    } else if (data.endsWith(GF(": Please join network first" AT_NL))) {
-      _networkConnected = false;
-      DBG("### Network disconnected, please re-join!");
-      return true;
-    } else if (data.endsWith(GF(": PORT: "))) {
-      // +MSG: PORT: 8; RX: "12345678"
-#ifdef LORA_AT_DEBUG
-      int8_t incoming_port = stream.parseInt();
-      DBG("## Data received on port", incoming_port);
-#endif
-      streamFind(';');  // skip the ; after the port
-      streamFind('"');  // skip to the "
-
-      // create a temporary buffer for reading
-      // the data always comes in as hex
-      // we always translate the data into ASCII, with two bytes of hex
-      // translating to one character
-      uint8_t tempRxBuff[LORA_AT_RX_BUFFER * 2];
-      memset(tempRxBuff, '\0', LORA_AT_RX_BUFFER * 2);
-      // read bytes until the next '"'
-      int downlinkedBytes = stream.readBytesUntil('"', tempRxBuff,
-                                                  LORA_AT_RX_BUFFER * 2);
-      DBG("## Got", downlinkedBytes, "bytes of downlink data");
-      // check for buffer overflow
-      int putBuffLen = downlinkedBytes / 2;
-      if (putBuffLen > loraStream->rx.free()) {
-        DBG("### Buffer overflow: ", putBuffLen, "->", loraStream->rx.free());
-        // reset amount to put into the buffer to the free space available
-        putBuffLen = loraStream->rx.free();
+  bool handleURCs(LoRa_AT_ResponseMatcher& matcher) {
+    switch (matcher.find(WIOE5_URCS, WIOE5_URC_MASK)) {
+      case WIOE5_WAKEUP: {
+        // inLowestPowerMode = false;
+        // ^^ this is not the lowest power mode usingthe extra 0xFF characters
+        return true;
       }
-      // translate the hex data to ascii
-      for (int i = 0; i < putBuffLen * 2; i += 2) {
-        char buf[4] = {
-            0,
-        };
-        buf[0] = tempRxBuff[i];
-        buf[1] = tempRxBuff[i + 1];
-        char c = strtol(buf, nullptr, 16);
-        loraStream->rx.put(c);
+      case WIOE5_NOT_JOINED: {
+        _networkConnected = false;
+        DBG("### Network disconnected, please re-join!");
+        return true;
       }
-      // reset the available count
-      loraStream->sock_available = loraStream->rx.size();
-      return true;
-    } else if (data.endsWith(GF(": RXWIN"))) {
-      // +MSG: RXWIN2, RSSI -106, SNR 4
-      streamFind('I');  // skip to the I
-      _msg_quality = stream.parseInt();
-      DBG(GF("Got RSSI:"), _msg_quality);
-      streamFind('\n');  // skip the SNR
-      return true;
-    } else if (data.endsWith(GF(": Link"))) {
-      // +MSG: Link 20, 1
-      _link_margin = stream.parseInt();
-      streamFind(',');  // skip the , after the link margin
+      case WIOE5_DOWNLINK: {
+        // +MSG: PORT: 8; RX: "12345678"
 #ifdef LORA_AT_DEBUG
-      int8_t gateway_count = stream.parseInt();
-      DBG(GF("## LinkCheckAns received. Link Margin:"), _link_margin,
-          GF("Number Gateways:"), gateway_count);
+        int8_t incoming_port = stream.parseInt();
+        DBG("## Data received on port", incoming_port);
 #endif
-      streamFind('\n');  // skip the SNR
-      return true;
+        streamFind(';');  // skip the ; after the port
+        streamFind('"');  // skip to the "
+
+        // the data always comes in as hex; decode it straight into the
+        // receive buffer up to the closing "
+#ifdef LORA_AT_DEBUG
+        int downlinkedBytes = streamReadHex(loraStream->rx, '"');
+        DBG("## Got", downlinkedBytes, "bytes of downlink data");
+#else
+        streamReadHex(loraStream->rx, '"');
+#endif
+        // reset the available count
+        loraStream->sock_available = loraStream->rx.size();
+        return true;
+      }
+      case WIOE5_RXWIN: {
+        // +MSG: RXWIN2, RSSI -106, SNR 4
+        // any downlink may carry MAC commands that change the data rate or
+        // need an answer
+        forgetPlan(true);
+        streamFind('I');  // skip to the I of RSSI
+        int16_t rssi = stream.parseInt();
+        int16_t snr  = stream.parseInt();
+        _linkHistory.recordSignal(rssi, snr);
+        DBG(GF("Got RSSI:"), rssi, GF("SNR:"), snr);
+        streamFind('\n');  // throw away the new line
+        return true;
+      }
+      case WIOE5_LINK: {
+        // +MSG: Link 20, 1
+        _link_margin = stream.parseInt();
+        streamFind(',');  // skip the , after the link margin
+        uint8_t gateway_count = stream.parseInt();
+        _linkHistory.recordLinkCheck(_link_margin, gateway_count);
+        DBG(GF("## LinkCheckAns received. Link Margin:"), _link_margin,
+            GF("Number Gateways:"), gateway_count);
+        streamFind('\n');  // throw away the new line
+        return true;
+      }
     }
     return false;
   }
 
   bool join(uint8_t attempts, uint32_t initialBackoff, bool force = false) {
-    // try multiple times to join
-    bool    success            = false;
-    uint8_t attempts_remaining = attempts;
-    int8_t  attempts_made      = 0;
-    while (!success && attempts_remaining) {
-#ifdef LORA_AT_DEBUG
-      uint32_t start = millis();
-#endif
-      sendAT(force ? GF("+JOIN=FORCE") : GF("+JOIN"));
-      attempts_remaining--;
-      attempts_made++;
-      // I don't know how long this might take, but it's slow
-      int8_t join_resp = waitResponse(
-          60000L, GF("+JOIN: Network joined"), GF("+JOIN: Join failed"),
-          GF("+JOIN: Joined already"), GF("+JOIN: LoRaWAN modem is busy"),
-          GF("+JOIN: Not in OTAA mode"));
-      if (join_resp == 1 || join_resp == 3) {
-        success           = true;
-        _networkConnected = true;
-        if (join_resp == 1) {
-          DBG(GF("Successfully joined network after"), millis() - start,
-              GF("ms"));
+    return joinBlocking(attempts, initialBackoff, force);
+  }
+
+  // The steps of each join attempt
+  enum WioE5JoinStep : uint8_t {
+    WIOE5_JOIN_START = 0,
+    WIOE5_JOIN_WAIT_RESULT,
+    WIOE5_JOIN_WAIT_DONE_JOINED,
+    WIOE5_JOIN_WAIT_DONE_FAILED,
+  };
+
+  bool beginJoinImpl(uint8_t attempts, uint32_t initialBackoff, bool force) {
+    return startJoin(attempts, initialBackoff, force);
+  }
+
+  LoRa_AT_JoinStatus pollJoinImpl() {
+    if (joinBackingOff()) { return _joinStatus; }
+    int8_t index;
+    switch (_joinStep) {
+      case WIOE5_JOIN_START: {
+        sendAT(_joinForce ? GF("+JOIN=FORCE") : GF("+JOIN"));
+        _joinAttemptsLeft--;
+        _joinAttemptsMade++;
+        // I don't know how long this might take, but it's slow
+        startAsyncWait(60000L, GF("+JOIN: Network joined"),
+                       GF("+JOIN: Join failed"), GF("+JOIN: Joined already"),
+                       GF("+JOIN: LoRaWAN modem is busy"),
+                       GF("+JOIN: Not in OTAA mode"));
+        _joinStep = WIOE5_JOIN_WAIT_RESULT;
+        break;
+      }
+      case WIOE5_JOIN_WAIT_RESULT: {
+        index = pollAsyncWait();
+        if (index < 0) { break; }
+        bool joined = index == 1 || index == 3;
+        if (index == 1) {
+          DBG(GF("Successfully joined network after"),
+              LORA_AT_MILLIS() - _asyncWaitStart, GF("ms"));
+        } else if (index == 3) {
+          DBG(GF("Network already connected"));
+        } else {
+          DBG(GF("Join attempted failed after"),
+              LORA_AT_MILLIS() - _asyncWaitStart, GF("ms with"),
+              _joinAttemptsLeft, GF("attempts remaining"));
         }
-        if (join_resp == 3) {
-          DBG(GF("Network already connected"), millis() - start, GF("ms"));
+        if (joined) { _networkConnected = true; }
+        if (index == 3 || index == 4) {
+          finishJoinAttempt(joined);
+          break;
         }
-      } else {
-        DBG(GF("Join attempted failed after"), millis() - start, GF("ms with"),
-            attempts_remaining, GF("attempts remaining"));
+        startAsyncWait(15000L, GF("+JOIN: Done"));
+        _joinStep = joined ? WIOE5_JOIN_WAIT_DONE_JOINED
+                           : WIOE5_JOIN_WAIT_DONE_FAILED;
+        break;
       }
-      if (join_resp != 3 && join_resp != 4) {
-        if (waitResponse(15000L, GF("+JOIN: Done")) == 1) {
-          DBG(GF("Join finished after"), millis() - start, GF("ms"));
+      case WIOE5_JOIN_WAIT_DONE_JOINED:
+      case WIOE5_JOIN_WAIT_DONE_FAILED: {
+        index = pollAsyncWait();
+        if (index < 0) { break; }
+        if (index == 1) {
+          DBG(GF("Join finished"));
         } else {
-          DBG(GF("Join timed out after"), millis() - start, GF("ms"));
-        };
-      }
-      streamFind('\n');  // throw away the new line
-      if (!success) {
-        // delay before the next attempt
-        uint32_t backoff = calculateBackoff(attempts_made, initialBackoff);
-        delay(backoff);
+          DBG(GF("Join timed out"));
+        }
+        finishJoinAttempt(_joinStep == WIOE5_JOIN_WAIT_DONE_JOINED);
+        break;
       }
     }
-    return success;
+    return _joinStatus;
+  }
+
+  // Ends a join attempt and schedules the next one if it failed
+  void finishJoinAttempt(bool joined) {
+    streamFind('\n');  // throw away the new line
+    if (joined) {
+      _joinStatus = LORA_AT_JOIN_JOINED;
+      return;
+    }
+    // back off before the next attempt
+    retryJoin(calculateBackoff(_joinAttemptsMade, _joinInitialBackoff));
   }
 
+
   bool changeModes(_lora_mode mode) {
     bool success = true;
     if (mode == OTAA) {
@@ -1081,12 +1250,25 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
     return true;
   }
 
-  String sendATGetString(GsmConstStr cmd) {
-    String resp;
+  // Sends a command and reads the rest of the line after the echo into the
+  // buffer, or "UNKNOWN" if the echo doesn't come
+  bool sendATGetString(GsmConstStr cmd, GsmConstStr echo, char* buff,
+                       size_t size) {
     sendAT(cmd);
-    if (waitResponse(cmd) != 1) { return "UNKNOWN"; }
-    streamFind(' ');  // skip until the next blank space
-    return stream.readStringUntil('\r');
+    if (waitResponse(echo) != 1) {
+      LoRa_AT_ResponseBuffer(buff, size).append("UNKNOWN");
+      return false;
+    }
+    size_t len = streamReadUntil('\r', buff, size);
+    while (len && isspace(buff[len - 1])) { buff[--len] = '\0'; }
+    streamFind('\n');  // throw away the new line
+    return true;
+  }
+
+  // The keys can be set but the module never reports them
+  static bool notReadable(char* buff, size_t size) {
+    LoRa_AT_ResponseBuffer(buff, size).append("NOT READABLE");
+    return false;
   }
 
 
@@ -1096,7 +1278,6 @@ class LoRa_AT_WioE5 : public LoRa_AT_Modem<LoRa_AT_WioE5>,
  protected:
   LoRaStream_WioE5* loraStream;
   bool              inLowestPowerMode;
-  int8_t            _msg_quality;
   uint8_t           _link_margin;
 };
 
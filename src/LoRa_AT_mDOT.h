@@ -23,6 +23,223 @@
 #include "LoRa_AT_Battery.tpp"
 #include "LoRa_AT_Sleep.tpp"
 
+// URCs handled by the mDOT, in the order they are checked
+static constexpr char MDOT_URC_NOT_JOINED[] LORA_AT_PROGMEM =
+    "Network Not Joined" AT_NL;
+static constexpr char MDOT_URC_JOIN_FAILED[] LORA_AT_PROGMEM =
+    "Failed to join network" AT_NL;
+
+/// The index of each URC in the mDOT URC table
+enum LoRa_AT_mDOT_URC {
+  MDOT_NOT_JOINED = 0,
+  MDOT_JOIN_FAILED,
+};
+static constexpr LoRa_AT_Response MDOT_URCS[] = {
+    LoRa_AT_MakeResponse(MDOT_URC_NOT_JOINED),
+    LoRa_AT_MakeResponse(MDOT_URC_JOIN_FAILED),
+};
+static constexpr uint32_t MDOT_URC_MASK = LoRa_AT_FinalCharMask(MDOT_URCS);
+
+/**
+ * @brief Reads the response to an mDOT send or link check one character at a
+ * time as it arrives, writing any downlink payload straight into the receive
+ * buffer.
+ *
+ * The mDOT gives no warning of a downlink: the payload is simply returned
+ * before the final "OK", after a fixed run of line breaks. Only that run is
+ * dropped, so a payload that itself starts with a carriage return or line
+ * feed is kept whole. The response to a link check
+ * starts with a line holding the link margin and the number of gateways. The
+ * last few characters are held back until the response ends so that the "OK"
+ * and the line breaks before it never reach the buffer, and nothing is added
+ * to the buffer until finish() is called. No heap memory is used.
+ *
+ * @tparam Fifo The type of the receive buffer
+ */
+template <class Fifo>
+class LoRa_AT_mDOTResponse {
+ public:
+  LoRa_AT_mDOTResponse() {
+    begin(nullptr, false);
+  }
+
+  /**
+   * @brief Start reading a new response.
+   *
+   * @param fifo The buffer to write the payload into; may be null to drop it
+   * @param linkCheck True if the response starts with a link check line
+   */
+  void begin(Fifo* fifo, bool linkCheck) {
+    _fifo      = fifo;
+    _linkCheck = linkCheck;
+    clear();
+  }
+
+  /**
+   * @brief Forget everything read so far, for example because the response
+   * was interrupted by a URC.
+   */
+  void clear() {
+    _state    = _linkCheck ? STATE_MARGIN : STATE_LEAD;
+    _margin   = 0;
+    _gateways = 0;
+    _held     = 0;
+    _lead     = 0;
+    _written  = 0;
+    _dropped  = 0;
+    _spanLeft = 0;
+  }
+
+  /**
+   * @brief Read the next character of the response.
+   *
+   * @param c The character
+   */
+  void append(char c) {
+    switch (_state) {
+      case STATE_MARGIN: {
+        // blank lines and anything else before the margin are skipped
+        if (c == ',') {
+          _state = STATE_GATEWAYS;
+        } else if (isdigit(c) && _margin < 1000) {
+          _margin = _margin * 10 + (c - '0');
+        }
+        break;
+      }
+      case STATE_GATEWAYS: {
+        if (isdigit(c) && _gateways < 1000) {
+          _gateways = _gateways * 10 + (c - '0');
+        } else if (c == '\n') {
+          _state = STATE_LEAD;
+        }
+        break;
+      }
+      case STATE_LEAD: {
+        // drop the line breaks before the payload; if they stop short of the
+        // whole run, what was taken for them is part of the response
+        if (c == LEAD[_lead]) {
+          if (LEAD[++_lead] == '\0') { _state = STATE_PAYLOAD; }
+          break;
+        }
+        for (uint8_t i = 0; i < _lead; i++) { hold(LEAD[i]); }
+        _state = STATE_PAYLOAD;
+        hold(c);
+        break;
+      }
+      case STATE_PAYLOAD: {
+        hold(c);
+        break;
+      }
+    }
+  }
+
+  /**
+   * @brief End the response once the final "OK" has been matched, adding the
+   * payload to the buffer.
+   *
+   * @return The length of the payload, including any bytes that did not fit
+   * in the buffer
+   */
+  size_t finish() {
+    // drop the OK and up to two line breaks before it
+    if (heldEndsWith("OK" AT_NL)) { _held -= sizeof("OK" AT_NL) - 1; }
+    for (uint8_t i = 0; i < 2 && heldEndsWith(AT_NL); i++) {
+      _held -= sizeof(AT_NL) - 1;
+    }
+    for (uint8_t i = 0; i < _held; i++) { emit(_hold[i]); }
+    _held = 0;
+    if (_written) { _fifo->commit(_written); }
+    if (_dropped) {
+      DBG("### Buffer overflow, dropped", _dropped, "bytes of downlink");
+    }
+    size_t len = _written + _dropped;
+    _written   = 0;
+    _dropped   = 0;
+    return len;
+  }
+
+  /**
+   * @brief Check if the response held a link check line.
+   *
+   * @return True if a link margin was read
+   */
+  bool hasLinkCheck() const {
+    return _linkCheck && _state != STATE_MARGIN;
+  }
+
+  /**
+   * @brief Get the link margin from a link check response.
+   *
+   * @return The link margin in dB
+   */
+  uint16_t linkMargin() const {
+    return _margin;
+  }
+
+  /**
+   * @brief Get the number of gateways from a link check response.
+   *
+   * @return The number of gateways that heard the link check
+   */
+  uint16_t gatewayCount() const {
+    return _gateways;
+  }
+
+ protected:
+  enum State : uint8_t {
+    STATE_MARGIN,    // reading the link margin
+    STATE_GATEWAYS,  // reading the gateway count
+    STATE_LEAD,      // matching the line breaks before the payload
+    STATE_PAYLOAD,   // reading the payload
+  };
+  // The line breaks the mDOT sends before a downlink payload
+  static constexpr const char* LEAD = "\r\r\n\r\r\n";
+  // Enough to hold back two line breaks and the OK
+  static const uint8_t HOLD = sizeof(AT_NL AT_NL "OK" AT_NL) - 1;
+
+  // Holds back the newest characters, passing the oldest on to the buffer
+  void hold(char c) {
+    if (_held == HOLD) {
+      emit(_hold[0]);
+      memmove(_hold, _hold + 1, HOLD - 1);
+      _held--;
+    }
+    _hold[_held++] = c;
+  }
+
+  bool heldEndsWith(const char* str) const {
+    size_t len = strlen(str);
+    return _held >= len && memcmp(_hold + _held - len, str, len) == 0;
+  }
+
+  // Writes a payload byte past anything already written but not committed
+  void emit(char c) {
+    if (_spanLeft == 0 && _fifo) {
+      _span = _fifo->reserve(_spanLeft, _written);
+    }
+    if (_spanLeft <= 0) {
+      _dropped++;
+      return;
+    }
+    *_span++ = c;
+    _spanLeft--;
+    _written++;
+  }
+
+  Fifo*    _fifo;
+  bool     _linkCheck;
+  State    _state;
+  uint16_t _margin;
+  uint16_t _gateways;
+  char     _hold[HOLD];
+  uint8_t  _held;
+  uint8_t  _lead;
+  uint8_t* _span;
+  int      _spanLeft;
+  int      _written;
+  size_t   _dropped;
+};
+
 class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
                      public LoRa_AT_Time<LoRa_AT_mDOT>,
                      public LoRa_AT_Radio<LoRa_AT_mDOT>,
@@ -34,6 +251,9 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
   friend class LoRa_AT_Battery<LoRa_AT_mDOT>;
   friend class LoRa_AT_Sleep<LoRa_AT_mDOT>;
 
+  // Reads the responses to sends and link checks
+  typedef LoRa_AT_mDOTResponse<LoRaStream::RxFifo> Response;
+
   /*
    * Inner Client
    */
@@ -65,10 +285,27 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
    * Constructor
    */
  public:
-  explicit LoRa_AT_mDOT(Stream& stream) : stream(stream) {
+  explicit LoRa_AT_mDOT(Stream& stream)
+      : stream(stream), _queryResponse(_queryText, sizeof(_queryText)) {
     prev_dl_check        = 0;
     _requireConfirmation = false;
+    _sendConfirmed       = false;
+    _sendRetries         = -1;
+    _sendStatus          = LORA_AT_SEND_IDLE;
+    _joinStatus          = LORA_AT_JOIN_IDLE;
+    _airtime             = nullptr;
+    _planRegion          = -1;
+    _planDataRate        = -1;
+    _planMacEmpty        = false;
     _networkConnected    = false;
+    _channelCommands     = 0;
+    _linkStaleness       = LORA_AT_LINK_STALENESS;
+
+    _confirmRetries       = -1;
+    _restorePort          = -1;
+    _settingWrites        = 0;
+    _settingWritesAvoided = 0;
+    _shadowValid          = 0;
   }
 
 
@@ -101,8 +338,8 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     return true;
   }
 
-  String getDevEUIImpl() {
-    return sendATGetString(GF("+DI?"));
+  bool getDevEUIImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+DI?"), buff, size);
   }
 
   bool factoryDefaultImpl() {
@@ -112,7 +349,7 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     resp &= commitSettings();
     sendAT(GF("Z"));  // Reset (restart) the CPU
     resp &= waitResponse() == 1;
-    delay(3000);  // mDOT takes about 3 seconds to reset
+    LORA_AT_DELAY(3000);  // mDOT takes about 3 seconds to reset
     return resp;
     // NOTE: Don't attempt to init or check AT after factory resetting!
     // Chances are it won't work because the baud rate or echo settings failed.
@@ -129,7 +366,7 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     waitResponse();
     sendAT(GF("Z"));  // Reset (restart) the CPU
     waitResponse();
-    delay(3000);  // mDOT takes about 3 seconds to reset
+    LORA_AT_DELAY(3000);  // mDOT takes about 3 seconds to reset
     return init();
   }
 
@@ -232,26 +469,45 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     sendAT(GF("+PN="), isPublic);
     return waitResponse() == 1;
   }
-  bool getPublicNetworkImpl() {
+  bool getPublicNetworkImpl(bool& isPublic) {
     sendAT(GF("+PN?"));
-    bool resp = waitResponse(GF("1"), GF("0")) == 1;
-    waitResponse();  // returns an "OK" after the number
-    return resp;
+    int8_t resp = waitResponse(GF("1"), GF("0"));
+    isPublic    = resp == 1;
+    // returns an "OK" after the number
+    return waitResponse() == 1 && resp > 0;
   }
 
   bool setConfirmationRetriesImpl(int8_t numAckRetries) {
     sendAT(GF("+ACK="), numAckRetries);
     return waitResponse() == 1;
   }
-  int8_t getConfirmationRetriesImpl() {
+  bool getConfirmationRetriesImpl(int8_t& numAckRetries) {
     sendAT(GF("+ACK?"));
-    int8_t resp = stream.parseInt();
-    waitResponse();  // returns an "OK" after the number
-    return resp;
+    numAckRetries = stream.parseInt();
+    // returns an "OK" after the number; without it, the number may be the 0
+    // parseInt() gives up with
+    return waitResponse() == 1;
   }
 
   bool joinOTAAImpl(const char* appEui, const char* appKey, const char* devEui,
                     int8_t attempts, uint32_t initialBackoff, bool useHex) {
+    setOTAAKeys(appEui, appKey, devEui, useHex);
+    join(attempts, initialBackoff);  // join the network
+    return isNetworkConnected();     // verify that we're connected
+  }
+
+  bool beginJoinOTAAImpl(const char* appEui, const char* appKey,
+                         const char* devEui, int8_t attempts,
+                         uint32_t initialBackoff, bool useHex) {
+    if (_sendStatus == LORA_AT_SEND_BUSY || _joinStatus == LORA_AT_JOIN_BUSY) {
+      return false;
+    }
+    setOTAAKeys(appEui, appKey, devEui, useHex);
+    return beginJoinImpl(attempts, initialBackoff, false);
+  }
+
+  void setOTAAKeys(const char* appEui, const char* appKey, const char* devEui,
+                   bool useHex) {
     sendAT(GF("+NJM=1"));  // Configure mDot for OTAA join mode (default)
     waitResponse();
     sendAT(GF("+NI="), !useHex, ',', appEui);  // set the app EUI (network id)
@@ -271,13 +527,11 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
       // factory defaults, so unless someone has set them in flash, the
       // "standard" write settings command will work.
     }
-    join(attempts, initialBackoff);  // join the network
-    return isNetworkConnected();     // verify that we're connected
   }
 
-  bool joinABPImpl(String devAddr, String nwkSKey, String appSKey,
-                   int uplinkCounter, int downlinkCounter, int8_t attempts,
-                   uint32_t initialBackoff) {
+  bool joinABPImpl(const char* devAddr, const char* nwkSKey,
+                   const char* appSKey, int uplinkCounter, int downlinkCounter,
+                   int8_t attempts, uint32_t initialBackoff) {
     sendAT(GF("+NJM=0"));  // Configure mDot for manual provisioning (ABP)
     waitResponse();
     sendAT(GF("+NA="), devAddr);  // set the network address (device address)
@@ -327,42 +581,37 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
       // if the downlink data is going to be present or not.  If no data is
       // present, a extra blank line is sent before the "OK."
 
-      String nlc_resp_str = "";  // to hold any downlink data
-      nlc_resp_str.reserve(LORA_AT_RX_BUFFER);
-      int8_t resp = waitResponse(10000L, nlc_resp_str, GFP(LORA_OK),
-                                 GFP(LORA_ERROR), GF("Network Not Joined"));
-      if (resp == 1) {
+      Response nlc;
+      nlc.begin(loraStream ? &loraStream->rx : nullptr, true);
+      LoRa_AT_ResponseMatcher matcher(GFP(LORA_OK), GFP(LORA_ERROR),
+                                      GF("Network Not Joined"));
+      int8_t                  resp  = 0;
+      uint32_t                start = LORA_AT_MILLIS();
+      do {
+        LORA_AT_YIELD();
+        resp = pollResponseImpl(matcher, &nlc);
+      } while (!resp && LORA_AT_MILLIS() - start < 10000L);
+      if (resp == 1 && nlc.hasLinkCheck()) {
         // The first number in the response is the dBm level above the
         // demodulation floor (not to be confused with the noise floor). This
         // value is from the perspective of the signal sent from the end
         // device and received by the gateway. The second number is the count
         // of gateways reporting the link-check request to the network server.
-        int firstComma   = nlc_resp_str.indexOf(',');
-        int afterCommaCR = nlc_resp_str.indexOf('\r', firstComma + 1);
-        int afterCommaLF = nlc_resp_str.indexOf('\n', afterCommaCR + 1);
-
-        _link_margin = nlc_resp_str.substring(0, firstComma).toInt();
-
-#ifdef LORA_AT_DEBUG
-        int gatewayCount =
-            nlc_resp_str.substring(firstComma + 1, afterCommaCR).toInt();
+        _link_margin = nlc.linkMargin();
+        _linkHistory.recordLinkCheck(_link_margin, nlc.gatewayCount());
         DBG("## NLC link margin in dBm:", _link_margin,
-            "gatewayCount:", gatewayCount);
-#endif
-        // the rest of the string should be the downlink data and the OK
-        String downlinkData = "";
-        downlinkData.reserve(LORA_AT_RX_BUFFER);
-        downlinkData = nlc_resp_str.substring(afterCommaLF + 1);
-
-        prev_dl_check = millis();          // mark that we checked for downlink
-        readDownlinkToFifo(downlinkData);  // deal with the downlink data
-      } else if (resp == 3) {              // if we got a not joined error, stop
+            "gatewayCount:", nlc.gatewayCount());
+
+        // mark that we checked for downlink
+        prev_dl_check = LORA_AT_MILLIS();
+        finishDownlink(nlc);  // deal with the downlink data
+      } else if (resp == 3) {  // if we got a not joined error, stop
         tries_remaining = 0;
         waitResponse();  // catch the "ERROR"
       } else {
         // delay before the next attempt
         uint32_t backoff = calculateBackoff(attempts_made, initialBackoff);
-        delay(backoff);
+        LORA_AT_DELAY(backoff);
       }
     }
     if (_link_margin != 255) {
@@ -373,13 +622,23 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     return _link_margin != 255;
   }
 
+  int16_t getMaxPayloadSizeImpl() {
+    sendAT(GF("+TXS?"));
+    int16_t resp = stream.parseInt();
+    if (waitResponse() != 1) { return -1; }  // get the OK after the number
+    return resp;
+  }
+
   int8_t getSignalQualityImpl() {
     // Displays signal strength information for received packets: last, min,
     // max, avg
     sendAT(GF("+RSSI"));
     int8_t resp = stream.parseInt();  // only keep the last packet's RSSI (the
                                       // first number returned)
-    waitResponse();                   // wait for ending ok
+    // the module reports zeros until it has received something
+    if (waitResponse() == 1 && resp != 0) {
+      _linkHistory.recordSignal(resp);
+    }
     return resp;
   }
 
@@ -392,22 +651,21 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     sendAT(GF("+DC="), (char)_class);
     return waitResponse() == 1;
   }
-  _lora_class getClassImpl() {
+  bool getClassImpl(_lora_class& _class) {
     sendAT(GF("+DC?"));
     int8_t devClass = waitResponse(GF("A"), GF("B"), GF("C"));
-    waitResponse();  // wait for ending ok
-    return (_lora_class)(devClass - 1 + 'A');
+    _class          = (_lora_class)(devClass - 1 + 'A');
+    return waitResponse() == 1 && devClass > 0;  // wait for ending ok
   }
 
   bool setPortImpl(uint8_t _port) {
     sendAT(GF("+AP="), _port);
     return waitResponse() == 1;
   }
-  uint8_t getPortImpl() {
+  bool getPortImpl(uint8_t& _port) {
     sendAT(GF("+AP?"));
-    int8_t resp = stream.parseInt();
-    waitResponse();  // wait for ending ok
-    return resp;
+    _port = stream.parseInt();
+    return waitResponse() == 1;  // wait for ending ok
   }
 
   // It is a bad idea to change this on the mDOT.  It's set at the factory based
@@ -421,8 +679,8 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     // to change it.
     return wasOk;
   }
-  String getBandImpl() {
-    return sendATGetString(GF("+FREQ?"));
+  bool getBandImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+FREQ?"), buff, size);
   }
 
   bool setFrequencySubBandImpl(int8_t subBand) {
@@ -430,71 +688,47 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
            subBand);  // Enter a value from 1-8 to configure the end device to
                       // use one set of eight channels out of 64 possible. This
                       // must match the gateway settings.
+    _channelCommands = 1;
+    forgetShadow(SHADOW_CHANNEL_MASK);
     return waitResponse() == 1;
   }
-  int8_t getFrequencySubBandImpl() {
+  bool getFrequencySubBandImpl(int8_t& subBand) {
     sendAT(GF("+FSB?"));
-    int8_t resp = stream.parseInt();
-    waitResponse();  // wait for ending ok
-    return resp;
+    subBand = stream.parseInt();
+    return waitResponse() == 1;  // wait for ending ok
   }
 
-  String getChannelMaskImpl() {
-    // NOTE: This will return **20** characters.
-    // The first 2 will always be 0.
-    String resp = sendATGetString(GF("+CHM?"));
-    resp.replace("Channel Mask: ", "");
-    resp.trim();
-    return resp;
+  // NOTE: The mDOT gives **20** characters; the first 2 will always be 0.
+  static constexpr uint8_t CHANNEL_MASK_DIGITS = 20;
+
+  bool getChannelMaskImpl(LoRa_AT_ChannelMask& mask) {
+    char resp[LORA_AT_STRING_BUFFER];
+    if (!sendATGetString(GF("+CHM?"), resp, sizeof(resp))) { return false; }
+    // skip "Channel Mask: ", if it's there
+    const char* hex = strchr(resp, ':');
+    return LoRa_AT_ChannelMask::parse(hex ? hex + 1 : resp, &mask);
   }
-  bool setChannelMaskImpl(const char* newMask) {
-    // The mDOT wants the channel mask to be sent as an offset from the first
-    // byte and then the next 4 bytes of the mask.
-    // For masks longer than 4 bytes (ie AU915, CN470, US915, US915_HYBRID), the
-    // command is sent multiple times.
-
-    size_t maskLen = strlen(newMask);
-    char*  maskPtr = const_cast<char*>(
-        newMask);  // Pointer to where in the buffer we're up to
-    uint8_t maskOffset = 4;
-    size_t  bytesSent  = 0;
-
-    // The mask must be 16 bits (4 characters) or 72 bits (18 characters)
-    // Because the mask is sent in chunks of 4 characters, the input mask must
-    // actually be 20 characters for a 72 bit mask. The first two characters
-    // will always be zero to make up for this.
-    // For US915 with all channels enabled, the mask is '00FFFFFFFFFFFFFFFFFF'
-    if (maskLen != 4 && maskLen != 18 && maskLen != 20) {
-      DBG("### Incorrect mask length:", maskLen);
-      return false;
+  bool applyChannelMaskImpl(const LoRa_AT_ChannelMask& newMask,
+                            const LoRa_AT_ChannelMask* current) {
+    // The mDOT wants the channel mask to be sent 16 channels (4 characters)
+    // at a time, with an offset counting the groups of 16 from the first
+    // channel. Only the groups that change are sent.
+    LoRa_AT_ChannelMask read = ~newMask;
+    if (current == nullptr) {
+      _channelCommands++;
+      getChannelMaskImpl(read);  // if it can't be read, send every group
+      current = &read;
     }
-    while (bytesSent < maskLen) {
-      uint8_t sendLength = 4;  // Send 4 bytes at a time
-
-      // start the send command
-      stream.write("AT+CHM=");
-      stream.print(maskOffset);
-      stream.write(',');
-      // zero pad the mask if someone only gave 18 characters
-      if (maskLen == 18 && maskOffset == 4) {
-        stream.print("00");
-        sendLength = 2;
-      }
-      // write out the 4 bytes of the mask
-      stream.write(reinterpret_cast<const uint8_t*>(maskPtr), sendLength);
-      // finish with a new line
-      stream.println();
-      stream.flush();
-
-      if (waitResponse() == 1) {
-        bytesSent += sendLength;  // bump up number of bytes sent
-        maskPtr += sendLength;    // bump up the pointer
-        maskOffset--;
-      } else {
-        break;
-      }
+    for (uint8_t offset = 0; offset < 5; offset++) {
+      uint16_t group = newMask.group(offset);
+      if (group == current->group(offset)) { continue; }
+      char hex[5];
+      LoRa_AT_ChannelMask(group).toHex(hex, 4);
+      _channelCommands++;
+      sendAT(GF("+CHM="), offset, ',', hex);
+      if (waitResponse() != 1) { return false; }
     }
-    return bytesSent == maskLen;
+    return true;
   }
 
 
@@ -504,19 +738,26 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
  protected:
   // NOTE: There is no way to directly enable duty cycle limitations. If a max
   // duty cycle is set, it's enforced. To not enforce it, set the max to 0.
+  // enableDutyCycle() counts the write and remembers that duty cycle is off;
+  // the maximum of 0 is remembered here along with it
   bool enableDutyCycleImpl(bool dutyCycle) {
-    if (!dutyCycle) { return setMaxDutyCycle(0); }
-    return false;
+    if (dutyCycle || !setMaxDutyCycleImpl(0)) { return false; }
+    _shadowMaxDutyCycle = 0;
+    shadowStore(SHADOW_MAX_DUTY_CYCLE);
+    return true;
   }
-  bool isDutyCycleEnabledImpl() {
-    return getMaxDutyCycleImpl() > 0;
+  bool isDutyCycleEnabledImpl(bool& dutyCycle) {
+    int8_t maxDutyCycle;
+    bool   resp = getMaxDutyCycleImpl(maxDutyCycle);
+    dutyCycle   = maxDutyCycle > 0;
+    return resp;
   }
 
   bool setMaxDutyCycleImpl(int8_t maxDutyCycle) {
     sendAT(GF("+DUTY="), maxDutyCycle);
     return waitResponse() == 1;
   }
-  int8_t getMaxDutyCycleImpl() {
+  bool getMaxDutyCycleImpl(int8_t& maxDutyCycle) {
     // This gives a detailed response, we're only going to return the int for
     // the max duty value.
     // AT+DUTY?
@@ -526,34 +767,33 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     // OK
     sendAT(GF("+DUTY?"));
     streamFind(' ');
-    int8_t resp = stream.parseInt();
-    waitResponse();  // wait for ending ok
-    return resp;
+    maxDutyCycle = stream.parseInt();
+    return waitResponse() == 1;  // wait for ending ok
   }
 
   bool setDataRateImpl(uint8_t dataRate) {
     sendAT(GF("+TXDR="), dataRate);
     return waitResponse() == 1;
   }
-  int8_t getDataRateImpl() {
+  bool getDataRateImpl(int8_t& dataRate) {
     sendAT(GF("+TXDR?"));
     // returns a longer response like "DR0 - SF12BW125"
     // We're only going to keep the DR number
     streamFind('R');
-    int8_t resp = stream.parseInt();
-    waitResponse();  // wait for ending ok
-    return resp;
+    dataRate = stream.parseInt();
+    return waitResponse() == 1;  // wait for ending ok
   }
 
   bool setAdaptiveDataRateImpl(bool useADR) {
     sendAT(GF("+ADR="), useADR);
     return waitResponse() == 1;
   }
-  bool getAdaptiveDataRateImpl() {
+  bool getAdaptiveDataRateImpl(bool& useADR) {
     sendAT(GF("+ADR?"));
-    bool resp = waitResponse(GF("1"), GF("0")) == 1;
-    waitResponse();  // returns an "OK" after the number
-    return resp;
+    int8_t resp = waitResponse(GF("1"), GF("0"));
+    useADR      = resp == 1;
+    // returns an "OK" after the number
+    return waitResponse() == 1 && resp > 0;
   }
 
 
@@ -562,18 +802,18 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
    */
  protected:
   // aka network address
-  String getDevAddrImpl() {
-    return sendATGetString(GF("+NA?"));
+  bool getDevAddrImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+NA?"), buff, size);
   }
 
   // network session key
-  String getNwkSKeyImpl() {
-    return sendATGetString(GF("+NSK?"));
+  bool getNwkSKeyImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+NSK?"), buff, size);
   }
 
   // aka data session key
-  String getAppSKeyImpl() {
-    return sendATGetString(GF("+DSK?"));
+  bool getAppSKeyImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+DSK?"), buff, size);
   }
 
 
@@ -582,12 +822,12 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
    */
  protected:
   // aka network id
-  String getAppEUIImpl() {
-    return sendATGetString(GF("+NI?"));
+  bool getAppEUIImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+NI?"), buff, size);
   }
   // aka network key
-  String getAppKeyImpl() {
-    return sendATGetString(GF("+NK?"));
+  bool getAppKeyImpl(char* buff, size_t size) {
+    return sendATGetString(GF("+NK?"), buff, size);
   }
 
 
@@ -595,8 +835,8 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
    * Time functions
    */
  protected:
-  String getDateTimeStringImpl(LoRa_AT_DateTimeFormat format)
-      LORA_AT_ATTR_NOT_AVAILABLE;
+  bool getDateTimeStringImpl(LoRa_AT_DateTimeFormat format, char* buff,
+                             size_t size) LORA_AT_ATTR_NOT_AVAILABLE;
 
   bool getDateTimePartsImpl(int* year, int* month, int* day, int* hour,
                             int* minute, int* second,
@@ -614,28 +854,21 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
 
       // NOTE: We can't use parseInt or sendATGetString here because the return
       // is slow!
-      String gps_time_str = "";
-      gps_time_str.reserve(16);
+      char                   gps_time_buff[24];
+      LoRa_AT_ResponseBuffer gps_time_str(gps_time_buff, sizeof(gps_time_buff));
       // Wait for final OK
       bool got_ok = waitResponse(15000L, gps_time_str) == 1;
       if (got_ok) {
-        gps_time_str.replace(AT_NL "OK" AT_NL, "");
-        gps_time_str.trim();
-
+        size_t len = gps_time_str.firstLine();
         // the epoch time is returned in MILLISECONDS which is too large for a
         // 32-bit unsigned into.  I'm chopping off the milliseconds and only
         // keeping the seconds.
-        int endSeconds = gps_time_str.length() - 3;
-        // subset text before the first carriage return, if it's there
-        int firstCR = gps_time_str.indexOf('\r');
-        if (firstCR > 0) { endSeconds = firstCR - 3; }
-        gps_time_str = gps_time_str.substring(0, endSeconds);
-        gps_time_str.trim();
-        gps_time = gps_time_str.toInt();
+        gps_time_buff[len > 3 ? len - 3 : 0] = '\0';
+        gps_time = strtoul(gps_time_buff, nullptr, 10);
       } else {
         // delay before the next attempt
         DBG(GF("Delay 10s before next time request attempt"));
-        delay(10000L);
+        LORA_AT_DELAY(10000L);
         // dump out anything, in case the time came in after the ok
         loraStream->dumpModemBuffer(10000L);
       }
@@ -706,116 +939,197 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
    */
  protected:
   int16_t modemSend(const uint8_t* buff, size_t len) {
-    // Pointer to where in the buffer we're up to
-    // A const cast is need to cast-away the constant-ness of the buffer (ie,
-    // modify it).
-    uint8_t* txPtr     = const_cast<uint8_t*>(buff);
-    size_t   bytesSent = 0;
+    return sendBlocking(buff, len);
+  }
+
+  // The steps of a send; each uplink queries the free space and then sends
+  // the message and waits for the OK.
+  enum mDOTSendStep : uint8_t {
+    MDOT_SEND_QUERY_TXS = 0,
+    MDOT_SEND_WAIT_TXS,
+    MDOT_SEND_MSG,
+    MDOT_SEND_WAIT_OK,
+  };
 
+  bool beginSendImpl(const uint8_t* buff, size_t len, bool whole) {
+    // nothing may be sent to the module while a send or join is under way
+    if (!canStartSend(len, whole)) { return false; }
     // NOTE: There's no way to require or not require confirmation for an
-    // individual message!
-    int8_t prev_ack_retries    = getConfirmationRetries();
-    bool   changed_ack_retries = false;
-    // If a number of retries isn't set, and we want confirmation, set the
-    // retries to 3. On the other hand, if the number of retries isn't 0 but we
-    // don't want confirmation, reset the retry number to 0.
-    if (_requireConfirmation && prev_ack_retries == 0) {
-      setConfirmationRetries(3);
-      DBG(GF("Set confirmation retries to 3 because ACK is on but no retries "
-             "were set"));
-      changed_ack_retries = true;
-    } else if (!_requireConfirmation && prev_ack_retries != 0) {
-      setConfirmationRetries(0);
-      DBG(GF("Set confirmation retries to 0 to disable ACK"));
-      changed_ack_retries = true;
+    // individual message! AT+ACK is both: 0 sends unconfirmed uplinks and any
+    // other number sends confirmed uplinks with that many retries. The module
+    // is left set up for this message, so a run of messages sent the same way
+    // only writes it once.
+    int8_t ackRetries = 0;
+    if (_sendConfirmed && _sendRetries >= 0) {
+      // 0 would turn confirmation off, so the fewest retries it can have is 1
+      ackRetries = _sendRetries > 0 ? _sendRetries : 1;
+    } else if (_sendConfirmed) {
+      ackRetries = _confirmRetries;
+      if (ackRetries <= 0) {
+        // use what the module has, unless that's no confirmation at all
+        ackRetries = getConfirmationRetries();
+        if (ackRetries <= 0) { ackRetries = 3; }
+      }
     }
+    if (!writeConfirmationRetries(ackRetries)) {
+      DBG(GF("### Module refused"), ackRetries, GF("confirmation retries"));
+    }
+    return startSend(buff, len, whole);
+  }
 
-    do {
-      // make no more than 5 attempts at the single send command
-      int8_t send_attempts = 0;
-      bool   send_success  = false;
-      while (send_attempts < 5 && !send_success) {
-        uint8_t sendLength =
-            0;  // Number of bytes to send from buffer in this command
-
+  LoRa_AT_SendStatus pollSendImpl() {
+    // Notes from datasheet:
+    // +SEND commands response is significantly impacted by the AT+ACK
+    // setting.
+    // With +ACK=[1-15], there is a random 1-3s delay before a retransmit if
+    // an ACK has not been received.  The theoretical max time with 8
+    // re-transmits requiring acknowledgements is 42.2 seconds.
+    // With +ACK=0 and no response from the network server, the time has
+    // been observed at about 2.5 seconds.
+    uint32_t sendTimeout = _sendConfirmed ? DEFAULT_ACKMESSAGE_TIMEOUT
+                                          : DEFAULT_MESSAGE_TIMEOUT;
+    int8_t   index;
+    switch (_sendStep) {
+      case MDOT_SEND_QUERY_TXS: {
         // check how many bytes are available for the next uplink
-        uint8_t uplinkAvailable = 0;
-        if (len != 0) {
-          sendAT(GF("+TXS?"));
-          uplinkAvailable = stream.parseInt();
-          DBG(uplinkAvailable, GF("bytes available for uplink."),
-              !uplinkAvailable ? GF("Flush the MAC buffer with empty message.")
-                               : GF(" "));
-          waitResponse();  // get the OK after the byte response
+        if (_sendLen == 0) {
+          _sendChunk = 0;
+          _sendStep  = MDOT_SEND_MSG;
+          break;
         }
-
-        // Ensure the program doesn't read past the allocated memory
-        sendLength = uplinkAvailable;
-        if (txPtr + uplinkAvailable > const_cast<uint8_t*>(buff) + len) {
-          sendLength = const_cast<uint8_t*>(buff) + len - txPtr;
+        // skip the query if nothing could have changed the space
+        if (usePlannedChunk()) {
+          _sendStep = MDOT_SEND_MSG;
+          break;
         }
-        // if there's no space available to send data, the queue is full of MAC
-        // commands and we need to send empty messages to flush them out
-        if (uplinkAvailable == 0 || len == 0) {
-          DBG(GF("Sending empty request"));
-          sendAT(GF("+SEND"));
-        } else {
-#ifdef LORA_AT_SEND_HEX
-          // start the send command
-          stream.write("AT+SENDB=");
-          // write everything as hex characters
-          writeHex(txPtr, sendLength);
-#else
-          // start the send command
-          stream.write("AT+SEND=");
-          // write out the number of bytes that are available for this uplink
-          stream.write(reinterpret_cast<const uint8_t*>(txPtr), sendLength);
-#endif
-          // finish with a new line
-          stream.println();
-          stream.flush();
+        startNumberQuery(GF("+TXS?"));
+        _sendStep = MDOT_SEND_WAIT_TXS;
+        break;
+      }
+      case MDOT_SEND_WAIT_TXS: {
+        uint32_t uplinkAvailable = 0;
+        index                    = pollNumberQuery(uplinkAvailable);
+        if (index < 0) { break; }
+        if (index == 0 || uplinkAvailable > 255) {
+          // without a count, an empty uplink would be sent in its place
+          DBG(GF("### Module didn't report the space for the uplink"));
+          finishSend(LORA_AT_SEND_FAILED);
+          break;
         }
-        // Notes from datasheet:
-        // +SEND commands response is significantly impacted by the AT+ACK
-        // setting.
-        // With +ACK=[1-15], there is a random 1-3s delay before a retransmit if
-        // an ACK has not been received.  The theoretical max time with 8
-        // re-transmits requiring acknowledgements is 42.2 seconds.
-        // With +ACK=0 and no response from the network server, the time has
-        // been observed at about 2.5 seconds.
-        uint32_t sendTimeout;
-        if (_requireConfirmation) {
-          sendTimeout = DEFAULT_ACKMESSAGE_TIMEOUT;
-        } else {
-          sendTimeout = DEFAULT_MESSAGE_TIMEOUT;
+        DBG(uplinkAvailable, GF("bytes available for uplink."),
+            !uplinkAvailable ? GF("Flush the MAC buffer with empty message.")
+                             : GF(" "));
+        if (!setSendChunk(uplinkAvailable)) {
+          finishSend(LORA_AT_SEND_FAILED);
+          break;
         }
-
+        _sendStep = MDOT_SEND_MSG;
+        break;
+      }
+      case MDOT_SEND_MSG: {
+        if (!airtimeAllows()) {
+          finishSend(LORA_AT_SEND_FAILED);
+          break;
+        }
+        writeSendCommand();
         // If there is downlink data available, it will be returned before the
         // "OK" from the send command.  Unfortunately, there will be no warning
         // if the downlink data is going to be present or not.  If no data is
         // present, a extra blank line is sent before the "OK."
-
-        String downlinkData = "";  // to hold any downlink data
-        downlinkData.reserve(LORA_AT_RX_BUFFER);
-        if (waitResponse(sendTimeout, downlinkData) == 1) {
-          bytesSent += sendLength;   // bump up number of bytes sent
-          txPtr += sendLength;       // bump up the pointer
-          prev_dl_check = millis();  // mark that we checked for downlink
-          send_success  = true;
-          readDownlinkToFifo(downlinkData);  // deal with the downlink data
+        _sendResponse.begin(loraStream ? &loraStream->rx : nullptr, false);
+        startAsyncWait(sendTimeout, GFP(LORA_OK), GFP(LORA_ERROR));
+        _sendStep = MDOT_SEND_WAIT_OK;
+        break;
+      }
+      case MDOT_SEND_WAIT_OK: {
+        index = pollAsyncWait(&_sendResponse);
+        if (index < 0) { break; }
+        if (index == 1) {
+          recordAirtime();
+          finishDownlink(_sendResponse);  // deal with the downlink data
+          finishUplink();
+        } else if (++_sendAttempts < 5) {
+          // make no more than 5 attempts at a single uplink, asking for the
+          // space again in case the planned size was wrong
+          forgetPlan(false);
+          _sendStep = MDOT_SEND_QUERY_TXS;
+        } else {
+          finishSend(LORA_AT_SEND_FAILED);
         }
-        send_attempts++;
+        break;
       }
-      // if we completely failed after 5 attempts, bail from the whole thing
-      if (!send_success) { break; }
-    } while (bytesSent < len && _networkConnected);
-
-    // undo changes to ack retries
-    if (changed_ack_retries) {
-      setConfirmationRetries(prev_ack_retries);
-      DBG(GF("Re-set confirmation retry number to"), prev_ack_retries);
     }
-    return bytesSent;
+    return _sendStatus;
+  }
+
+  // Asks for a number the mDOT answers with on a line of its own, collecting
+  // the answer without waiting for it
+  void startNumberQuery(GsmConstStr cmd) {
+    sendAT(cmd);
+    _queryResponse.clear();
+    startAsyncWait(1000L, GFP(LORA_OK), GFP(LORA_ERROR));
+  }
+
+  // Checks for the answer to startNumberQuery(); returns 1 once the number
+  // and the OK after it have arrived, 0 if the module answered with an error,
+  // anything other than a number or nothing at all, or -1 if still waiting.
+  // The value is only changed when 1 is returned.
+  int8_t pollNumberQuery(uint32_t& value) {
+    int8_t index = pollAsyncWait(&_queryResponse);
+    if (index < 0) { return -1; }
+    if (index != 1 || !_queryResponse.firstLine()) { return 0; }
+    const char* text = _queryResponse.c_str();
+    char*       end;
+    uint32_t    number = strtoul(text, &end, 10);
+    if (!isdigit(text[0]) || *end != '\0') { return 0; }
+    value = number;
+    return 1;
+  }
+
+  // Writes the send command for the current uplink
+  void writeSendCommand() {
+    if (_sendChunk == 0) {
+      DBG(GF("Sending empty request"));
+      sendAT(GF("+SEND"));
+      return;
+    }
+    const uint8_t* txPtr = _sendBuff + _sendDone;
+#ifdef LORA_AT_SEND_HEX
+    // start the send command
+    stream.write("AT+SENDB=");
+    // write everything as hex characters
+    writeHex(txPtr, _sendChunk);
+#else
+    // start the send command
+    stream.write("AT+SEND=");
+    // write out the number of bytes that are available for this uplink
+    stream.write(txPtr, _sendChunk);
+#endif
+    // finish with a new line
+    stream.println();
+    stream.flush();
+  }
+
+  // Counts an accepted uplink and moves on to the next one, if any
+  void finishUplink() {
+    _sendDone += _sendChunk;  // bump up number of bytes sent
+    // mark that we checked for downlink
+    prev_dl_check = LORA_AT_MILLIS();
+    if (_sendDone < _sendLen && _networkConnected &&
+        (_sendChunk || ++_sendAttempts < 5)) {
+      // Empty uplinks that only flushed MAC commands count against the
+      // attempts, so data that never fits can't keep us sending forever.
+      if (_sendChunk) { _sendAttempts = 0; }
+      _sendStep = MDOT_SEND_QUERY_TXS;
+    } else {
+      finishSend(_sendDone < _sendLen ? LORA_AT_SEND_FAILED
+                                      : LORA_AT_SEND_DONE);
+    }
+  }
+
+  // Ends the send
+  void finishSend(LoRa_AT_SendStatus status) {
+    _sendStatus = status;
   }
 
   size_t modemRead() {
@@ -844,12 +1158,14 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
    * Utilities
    */
  private:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF("Network Not Joined" AT_NL)) ||
-        data.endsWith(GF("Failed to join network" AT_NL))) {
-      _networkConnected = false;
-      DBG("### Network disconnected, please re-join!");
-      return true;
+  bool handleURCs(LoRa_AT_ResponseMatcher& matcher) {
+    switch (matcher.find(MDOT_URCS, MDOT_URC_MASK)) {
+      case MDOT_NOT_JOINED:
+      case MDOT_JOIN_FAILED: {
+        _networkConnected = false;
+        DBG("### Network disconnected, please re-join!");
+        return true;
+      }
     }
     return false;
   }
@@ -864,108 +1180,120 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
     return waitResponse() == 1;
   }
 
-  uint32_t getNextTransmit() {
-    sendAT(GF("+TXN?"));
-    uint32_t resp = stream.parseInt();
-    waitResponse();  // returns an "OK" after the number
-    return resp;
+  bool join(uint8_t attempts, uint32_t initialBackoff, bool force = false) {
+    return joinBlocking(attempts, initialBackoff, force);
   }
 
-  bool join(uint8_t attempts, uint32_t initialBackoff, bool force = false) {
-    // try multiple times to join
-    bool    success            = false;
-    uint8_t attempts_remaining = attempts;
-    int8_t  attempts_made      = 0;
-    while (!success && attempts_remaining) {
-#ifdef LORA_AT_DEBUG
-      uint32_t start = millis();
-#endif
-      sendAT(force ? GF("+JOIN=1") : GF("+JOIN"));
-      attempts_remaining--;
-      attempts_made++;
-      // The maximum settable join delay for non-default connections is 15s, so
-      // hopefully this will return before that.
-      int8_t join_resp = waitResponse(
-          15000L, GF("Successfully joined network" AT_NL),
-          GF("Failed to join network" AT_NL), GF("Join backoff" AT_NL));
-      waitResponse();        // returns an ok or error after the join message
-      if (join_resp == 1) {  // if we succeeded
-        success           = true;
-        _networkConnected = true;
-        DBG(GF("Successfully joined network after"), millis() - start,
-            GF("ms"));
-      } else {
-        DBG(GF("Join attempted failed after"), millis() - start, GF("ms with"),
-            attempts_remaining, GF("attempts remaining"));
+  // The steps of each join attempt
+  enum mDOTJoinStep : uint8_t {
+    MDOT_JOIN_START = 0,
+    MDOT_JOIN_WAIT_RESULT,
+    MDOT_JOIN_WAIT_OK_JOINED,
+    MDOT_JOIN_WAIT_OK_FAILED,
+    MDOT_JOIN_WAIT_TXN,
+  };
+
+  bool beginJoinImpl(uint8_t attempts, uint32_t initialBackoff, bool force) {
+    return startJoin(attempts, initialBackoff, force);
+  }
+
+  LoRa_AT_JoinStatus pollJoinImpl() {
+    if (joinBackingOff()) { return _joinStatus; }
+    int8_t index;
+    switch (_joinStep) {
+      case MDOT_JOIN_START: {
+        sendAT(_joinForce ? GF("+JOIN=1") : GF("+JOIN"));
+        _joinAttemptsLeft--;
+        _joinAttemptsMade++;
+        // The maximum settable join delay for non-default connections is 15s,
+        // so hopefully this will return before that.
+        startAsyncWait(15000L, GF("Successfully joined network" AT_NL),
+                       GF("Failed to join network" AT_NL),
+                       GF("Join backoff" AT_NL));
+        _joinStep = MDOT_JOIN_WAIT_RESULT;
+        break;
+      }
+      case MDOT_JOIN_WAIT_RESULT: {
+        index = pollAsyncWait();
+        if (index < 0) { break; }
+        if (index == 1) {  // if we succeeded
+          _networkConnected = true;
+          DBG(GF("Successfully joined network after"),
+              LORA_AT_MILLIS() - _asyncWaitStart, GF("ms"));
+        } else {
+          DBG(GF("Join attempted failed after"),
+              LORA_AT_MILLIS() - _asyncWaitStart, GF("ms with"),
+              _joinAttemptsLeft, GF("attempts remaining"));
+        }
+        // returns an ok or error after the join message
+        startAsyncWait(1000L, GFP(LORA_OK), GFP(LORA_ERROR));
+        _joinStep = index == 1 ? MDOT_JOIN_WAIT_OK_JOINED
+                               : MDOT_JOIN_WAIT_OK_FAILED;
+        break;
+      }
+      case MDOT_JOIN_WAIT_OK_JOINED: {
+        if (pollAsyncWait() < 0) { break; }
+        _joinStatus = LORA_AT_JOIN_JOINED;
+        break;
+      }
+      case MDOT_JOIN_WAIT_OK_FAILED: {
+        if (pollAsyncWait() < 0) { break; }
+        if (!_joinAttemptsLeft) {
+          retryJoin(0);
+          break;
+        }
         // check how long we need to wait for a free channel before next attempt
-        uint32_t transmit_wait = getNextTransmit();
+        startNumberQuery(GF("+TXN?"));
+        _joinStep = MDOT_JOIN_WAIT_TXN;
+        break;
+      }
+      case MDOT_JOIN_WAIT_TXN: {
+        uint32_t transmit_wait = 0;
+        index                  = pollNumberQuery(transmit_wait);
+        if (index < 0) { break; }
+        // without an answer, only the backoff is waited
+        if (index == 0) {
+          DBG(GF("### Module didn't report the wait for a free channel"));
+        }
         // calculate backoff
-        uint32_t backoff = calculateBackoff(attempts_made, initialBackoff);
-        // Delay at least until the next channel is free, or to the calculated
+        uint32_t backoff = calculateBackoff(_joinAttemptsMade,
+                                            _joinInitialBackoff);
+        // Wait at least until the next channel is free, or to the calculated
         // backoff, whichever is larger.
-        DBG(GF("Waiting"), max(transmit_wait + 100L, backoff),
-            GF("ms for a free channel before next join attempt."));
-        delay(max(transmit_wait + static_cast<uint32_t>(100), backoff));
+        retryJoin(max(transmit_wait + static_cast<uint32_t>(100), backoff));
+        break;
       }
     }
-    return success;
+    return _joinStatus;
   }
 
-  size_t readDownlinkToFifo(String& downlink) {
-    // String dl_marked = downlink;
-    // dl_marked.replace("\r", "←");
-    // dl_marked.replace("\n", "↓");
-    // DBG("## downlinkData: <<", dl_marked, ">>");
-    // strip the initial "\r\r\n\r\r\n" pattern out
-    downlink.replace("\r\r\n\r\r\n", "");
-    // strip out the OK, sometimes with an extra trailing new line
-    downlink.replace(AT_NL AT_NL "OK" AT_NL, "");
-    downlink.replace(AT_NL "OK" AT_NL, "");
-    // dl_marked = downlink;
-    // dl_marked.replace("\r", "←");
-    // dl_marked.replace("\n", "↓");
-    // DBG("## downlinkData cleaned: <<", dl_marked, ">>");
-    // if all we have is a various types of returns, it's nothing
-    if (downlink == "\r\r\n\r\r\n" || downlink == "\r\n" || downlink == "\r" ||
-        downlink == "\n") {
-      return 0;
-    }
+
+  // Adds the downlink payload of a finished response to the receive buffer
+  size_t finishDownlink(Response& response) {
+    size_t downlinkedBytes = response.finish();
+    if (!downlinkedBytes) { return 0; }
 
     // if there's data in the downlink, we're connected
     _networkConnected = true;
-
-    // deal with the downlink data
-    int downlinkedBytes = downlink.length();
-
-    // if we got data, move it into the FiFo
-    if (downlinkedBytes > 0) {
-      DBG("## Got", downlinkedBytes, "bytes of downlink data");
-      int putBuffLen = downlinkedBytes;
-      if (downlinkedBytes > loraStream->rx.free()) {
-        DBG("### Buffer overflow: ", downlinkedBytes, "->",
-            loraStream->rx.free());
-        // reset amount to put into the buffer to the free space available
-        putBuffLen = loraStream->rx.free();
-      }
-      loraStream->rx.put(
-          reinterpret_cast<uint8_t*>(const_cast<char*>(downlink.c_str())),
-          putBuffLen, false);
-      loraStream->sock_available = putBuffLen;
-      return putBuffLen;
-    }
-    return 0;
+    DBG("## Got", downlinkedBytes, "bytes of downlink data");
+    // it may have come with MAC commands
+    forgetPlan(true);
+    if (loraStream) { loraStream->sock_available = loraStream->rx.size(); }
+    return downlinkedBytes;
   }
 
-  String sendATGetString(GsmConstStr cmd) {
-    String resp;
+  // Sends a command and keeps the first line of the response in the buffer,
+  // or "UNKNOWN" if the module doesn't answer OK
+  bool sendATGetString(GsmConstStr cmd, char* buff, size_t size) {
+    LoRa_AT_ResponseBuffer resp(buff, size);
     sendAT(cmd);
-    if (waitResponse(1000L, resp) != 1) { return "UNKNOWN"; }
-    resp.replace(AT_NL "OK" AT_NL, "");
-    resp.trim();
-
-    // subset text before the first carriage return
-    int firstCR = resp.indexOf('\r');
-    return resp.substring(0, firstCR);
+    if (waitResponse(1000L, resp) != 1) {
+      resp.clear();
+      resp.append("UNKNOWN");
+      return false;
+    }
+    resp.firstLine();
+    return true;
   }
 
 
@@ -973,7 +1301,10 @@ class LoRa_AT_mDOT : public LoRa_AT_Modem<LoRa_AT_mDOT>,
   Stream& stream;
 
  protected:
-  LoRaStream_mDOT* loraStream;
+  LoRaStream_mDOT*       loraStream;
+  Response               _sendResponse;
+  char                   _queryText[24];  ///< The answer to a number query
+  LoRa_AT_ResponseBuffer _queryResponse;  ///< Collects _queryText
 };
 
 #endif  // SRC_LORA_AT_MDOT_H_
@@ -1,8 +1,71 @@
 #ifndef TinyGsmFifo_h
 #define TinyGsmFifo_h
 
-template <class T, unsigned N>
+/**
+ * @def TINY_GSM_FIFO_BARRIER
+ * @brief A memory barrier used between writing an item and publishing the new
+ * index in single-producer/single-consumer mode.
+ *
+ * AVR boards have a single core, so only the compiler needs to be kept from
+ * reordering memory access. Other boards may have more than one core or a
+ * write buffer, so a full hardware barrier is used.
+ */
+#ifndef TINY_GSM_FIFO_BARRIER
+#if defined(__AVR__) || defined(ARDUINO_ARCH_AVR)
+#define TINY_GSM_FIFO_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define TINY_GSM_FIFO_BARRIER() __sync_synchronize()
+#endif
+#endif
+
+/**
+ * @brief Select the type used to store the read and write positions of a FIFO.
+ *
+ * In single-producer/single-consumer mode the positions are volatile and are
+ * stored in a single byte when possible, so that they are always read and
+ * written in one instruction on 8-bit processors.
+ */
+template <bool SPSC, bool SmallIndex>
+struct TinyGsmFifoIndex {
+  typedef int type;
+};
+template <>
+struct TinyGsmFifoIndex<true, true> {
+  typedef volatile uint8_t type;
+};
+template <>
+struct TinyGsmFifoIndex<true, false> {
+  typedef volatile int type;
+};
+
+/**
+ * @brief A fixed size first-in-first-out ring buffer.
+ *
+ * @tparam T The type of the items in the buffer
+ * @tparam N The number of positions in the buffer; one position is always
+ * left empty, so the buffer holds at most N-1 items
+ * @tparam SPSC True to make the buffer safe for a single producer and a single
+ * consumer running in different contexts
+ *
+ * By default the buffer has no protection against being used from more than
+ * one context.
+ *
+ * When SPSC is true, the read and write positions are volatile and a memory
+ * barrier (#TINY_GSM_FIFO_BARRIER) separates each item access from the
+ * position update that makes it visible. Exactly one context (for example, a
+ * UART receive interrupt or a second core) may then call the writing functions
+ * (writeable(), free(), put(), reserve() and commit()) while exactly one other
+ * context calls the reading functions (readable(), size(), get(), peek() and
+ * consume()). No locks are taken and interrupts are never disabled. clear()
+ * is not safe to call while the other side is running.
+ */
+template <class T, unsigned N, bool SPSC = false>
 class TinyGsmFifo {
+#if defined(__AVR__) || defined(ARDUINO_ARCH_AVR)
+  static_assert(!SPSC || N <= 256,
+                "On AVR, a SPSC FIFO can have at most 256 positions");
+#endif
+
  public:
   /**
    * @brief Construct a new Tiny Gsm Fifo object, setting the head and tail to
@@ -59,7 +122,8 @@ class TinyGsmFifo {
                   // the buffer is full)
       return false;
     _b[j] = c;  // add the item at position j
-    _w    = i;  // bump the write position
+    if (SPSC) TINY_GSM_FIFO_BARRIER();  // the item must land before the index
+    _w = i;                              // bump the write position
     return true;
   }
 
@@ -87,7 +151,8 @@ class TinyGsmFifo {
       int m = N - w;
       // check wrap
       if (f > m) f = m;
-      memcpy(&_b[w], p, f);
+      memcpy(&_b[w], p, f * sizeof(T));
+      if (SPSC) TINY_GSM_FIFO_BARRIER();
       _w = _inc(w, f);
       c -= f;
       p += f;
@@ -95,6 +160,45 @@ class TinyGsmFifo {
     return n - c;
   }
 
+  /**
+   * @brief Get the contiguous free space at the write position so a producer
+   * can write items directly into the buffer.
+   *
+   * Nothing is added to the buffer until commit() is called. Because the
+   * space stops at the end of the underlying array, there may be more free
+   * space after committing and reserving again.
+   *
+   * @param n Set to the number of items that can be written at the returned
+   * position
+   * @param skip The number of items already written past the write position
+   * and not yet committed; optional with a default of 0. This lets a
+   * producer write more than one contiguous run before committing them all.
+   * @return Pointer to the write position
+   */
+  T* reserve(int& n, int skip = 0) {
+    int f = free() - skip;
+    if (f <= 0) {
+      n = 0;
+      return &_b[_w];
+    }
+    int w = _inc(_w, skip);
+    int m = N - w;
+    n     = f < m ? f : m;
+    return &_b[w];
+  }
+
+  /**
+   * @brief Add items that were written directly into the space from reserve()
+   * to the buffer.
+   *
+   * @param n The number of items written; must be no more than the number
+   * returned by reserve()
+   */
+  void commit(int n) {
+    if (SPSC) TINY_GSM_FIFO_BARRIER();
+    _w = _inc(_w, n);
+  }
+
   // reading thread/context API
   // --------------------------------------------------------
 
@@ -112,7 +216,9 @@ class TinyGsmFifo {
     int r = _r;
     if (r == _w)  // !readable()
       return false;
+    if (SPSC) TINY_GSM_FIFO_BARRIER();  // read the item only after the index
     *p = _b[r];
+    if (SPSC) TINY_GSM_FIFO_BARRIER();  // finish reading before freeing it
     _r = _inc(r);
     return true;
   }
@@ -134,7 +240,9 @@ class TinyGsmFifo {
       int m = N - r;
       // check wrap
       if (f > m) f = m;
-      memcpy(p, &_b[r], f);
+      if (SPSC) TINY_GSM_FIFO_BARRIER();
+      memcpy(p, &_b[r], f * sizeof(T));
+      if (SPSC) TINY_GSM_FIFO_BARRIER();
       _r = _inc(r, f);
       c -= f;
       p += f;
@@ -142,26 +250,67 @@ class TinyGsmFifo {
     return n - c;
   }
 
-  uint8_t peek() {
+  T peek() {
+    if (SPSC) TINY_GSM_FIFO_BARRIER();
     return _b[_r];
   }
 
+  /**
+   * @brief Get the contiguous readable items at the read position so a
+   * consumer can read them directly from the buffer.
+   *
+   * Nothing is removed from the buffer until consume() is called. Because the
+   * span stops at the end of the underlying array, there may be more items to
+   * read after consuming and peeking again.
+   *
+   * @param n Set to the number of items that can be read at the returned
+   * position
+   * @return Pointer to the read position
+   */
+  const T* peek(int& n) {
+    int r = _r;
+    int s = size();
+    int m = N - r;
+    n     = s < m ? s : m;
+    if (SPSC) TINY_GSM_FIFO_BARRIER();
+    return &_b[r];
+  }
+
+  /**
+   * @brief Remove items that were read directly from the span from peek(int&)
+   * from the buffer.
+   *
+   * @param n The number of items read; must be no more than the number
+   * returned by peek(int&)
+   */
+  void consume(int n) {
+    if (SPSC) TINY_GSM_FIFO_BARRIER();
+    _r = _inc(_r, n);
+  }
+
  private:
   /**
-   * @brief Get the next increment spot in the buffer, accounting for the size
-   * of each item in the buffer
+   * @brief Get the next increment spot in the buffer, wrapping at the end of
+   * the buffer.
    *
-   * @param i
-   * @param n
-   * @return
+   * When N is a power of two this is a mask; otherwise it is a single
+   * compare and subtract. The choice is made at compile time.
+   *
+   * @param i The current position; must be less than N
+   * @param n The number of positions to move; must be no more than N
+   * @return The new position
    */
   int _inc(int i, int n = 1) {
-    return (i + n) % N;
+    i += n;
+    if ((N & (N - 1)) == 0) { return i & (N - 1); }
+    return i >= static_cast<int>(N) ? i - N : i;
   }
 
-  T   _b[N];  /// The buffer, containing 'N' items of type 'T'
-  int _w;     /// The write position in the buffer
-  int _r;     /// The read position in the buffer
+  typedef typename TinyGsmFifoIndex<SPSC, (N <= 256)>::type index_type;
+
+  T          _b[N];  /// The buffer, containing 'N' items of type 'T'
+  index_type _w;     /// The write position in the buffer
+  index_type _r;     /// The read position in the buffer
 };
 
 #endif